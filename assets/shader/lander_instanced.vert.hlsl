@@ -0,0 +1,48 @@
+
+struct instance {
+    float4 basis;          // model x axis in xy, y axis in zw
+    float4 translation;    // xy, z is depth
+    float4 tint;
+};
+
+StructuredBuffer<instance> instances : register(t0, space0);
+
+cbuffer uniform_buffer : register(b0, space1) {
+    float4x4 view_proj;
+    uint first_instance;
+};
+
+// Same as lander.vert, but one draw covers a whole batch of objects sharing a mesh
+// Each instance's transform comes from the storage buffer instead of a pushed mvp
+//     - first_instance is pushed per batch, SV_InstanceID starts at 0 for every draw
+
+struct vs_input {
+    float2 position : POSITION;
+    float4 color : COLOR0;
+};
+
+struct vs_output {
+    float4 position : SV_POSITION;
+    float4 color : COLOR0;
+};
+
+vs_output main(vs_input input, uint instance_id : SV_InstanceID) {
+
+    instance inst = instances[first_instance + instance_id];
+
+    float2 world = inst.basis.xy * input.position.x + inst.basis.zw * input.position.y +
+                   inst.translation.xy;
+
+    vs_output output;
+    output.position = mul(view_proj, float4(world, inst.translation.z, 1.0F));
+    output.color = input.color * inst.tint;
+
+    return output;
+};
+
+// Apply the instance's 2D affine transform (rotation, scale, translation) to the vertex
+// Project with the shared view-projection matrix
+// Tint the vertex color per instance
+// Pairs with lander.frag, the fragment stage is unchanged
+
+// dxc.exe -spirv -T vs_6_0 -E main lander_instanced.vert.hlsl -Fo lander_instanced.vert.spv
@@ -9,3 +9,13 @@ auto C_transform::get_matrix() const -> glm::mat4 {
     model = glm::scale(model, glm::vec3(scale, 1.0F));
     return model;
 }
+
+auto C_mesh_lod::select(const float pixels_per_unit) const -> Uint32 {
+    Uint32 mesh_id{mesh_ids.front()};
+    for (size_t i = 0; i < mesh_ids.size(); ++i) {
+        if (max_errors[i] * pixels_per_unit > defs::terrain::lod_max_screen_error)
+            break;
+        mesh_id = mesh_ids[i];
+    }
+    return mesh_id;
+}
@@ -47,6 +47,19 @@ public:
     explicit C_mesh(const Uint32 mid) : mesh_id{mid} {}
 };
 
+// Alternate meshes for the same object, finest first
+class C_mesh_lod final : public Component {
+public:
+    std::vector<Uint32> mesh_ids;
+    std::vector<float> max_errors;    // world units, per level
+
+    C_mesh_lod(const std::vector<Uint32>& ids, const std::vector<float>& errors) :
+        mesh_ids{ids}, max_errors{errors} {}
+
+    // coarsest level whose error stays under the screen space limit at this scale
+    [[nodiscard]] auto select(float pixels_per_unit) const -> Uint32;
+};
+
 class C_render final : public Component {
 public:
     Uint32 pipeline_id{0};
@@ -93,11 +106,36 @@ public:
         thrust_power{thrust}, rotation_power{torque} {}
 };
 
+// Streams particles of one material from a point on the object while active
+// offset and direction are in the object's space and turn with it
+class C_emitter final : public Component {
+public:
+    defs::particles::Material material;
+    glm::vec2 offset{0.0F};
+    glm::vec2 direction{0.0F, -1.0F};
+    float rate{0.0F};    // particles per second
+    bool active{false};
+    float pending{0.0F};    // fraction of a particle carried to the next step
+
+    C_emitter(
+        const defs::particles::Material mat, const glm::vec2 off, const glm::vec2 dir,
+        const float per_second
+    ) :
+        material{mat}, offset{off}, direction{dir}, rate{per_second} {}
+};
+
+// Full resolution terrain line, plus what deformation needs to patch the lod meshes
 class C_terrain_points final : public Component {
 public:
     std::vector<glm::vec2> points;
+    std::vector<size_t> anchors;
+    std::vector<defs::types::terrain::Terrain_lod> lods;
 
-    explicit C_terrain_points(const std::vector<glm::vec2>& positions) : points{positions} {}
+    C_terrain_points(
+        const std::vector<glm::vec2>& positions, const std::vector<size_t>& anchor_indices,
+        const std::vector<defs::types::terrain::Terrain_lod>& lod_levels
+    ) :
+        points{positions}, anchors{anchor_indices}, lods{lod_levels} {}
 };
 
 class C_landing_zones final : public Component {
@@ -1,8 +1,11 @@
 
 
 #include <App.h>
+#include <debug_draw.h>
+#include <profiler.h>
 
 auto App::init() -> utils::Result<> {
+    profiler::set_thread_name("main");
 
     /* 1. Core systems
      * 2. Resource loading
@@ -27,15 +30,18 @@ auto App::init() -> utils::Result<> {
     game_state->input_system = std::make_unique<Input_system>();
     game_state->player_control_system = std::make_unique<Player_control_system>();
     game_state->physics_system = std::make_unique<Physics_system>();
-    game_state->render_system = std::make_unique<Render_system>();
+    game_state->particle_system = std::make_unique<Particle_system>();
+    game_state->particle_system->init();
 
     game_state->resource_manager = std::make_unique<Resource_manager>();
     CHECK_BOOL(game_state->resource_manager->init());
 
+    game_state->render_system = std::make_unique<Render_system>();
+    game_state->render_system->init(*game_state->resource_manager);
+
     game_state->renderer = std::make_unique<Renderer>();
     CHECK_BOOL(game_state->renderer->init(
-        *game_state->graphics->get_device(), *game_state->graphics->get_window(),
-        *game_state->resource_manager.get()
+        game_state->graphics->get_gpu(), *game_state->resource_manager.get()
     ));
 
     game_state->text_manager = std::make_unique<Text_manager>();
@@ -52,7 +58,13 @@ auto App::init() -> utils::Result<> {
     TRY(create_terrain_object());
     TRY(create_default_ui());
 
-    game_state->camera = {};
+    // every startup mesh goes to the gpu in one batch
+    TRY(game_state->renderer->register_meshes(startup_mesh_ids));
+    startup_mesh_ids.clear();
+
+    game_state->camera = std::make_unique<Camera>();
+    TRY(create_starfield());
+    TRY(create_particle_texture());
 
     // game_state->render_queue = {};
 
@@ -60,6 +72,14 @@ auto App::init() -> utils::Result<> {
 }
 
 auto App::quit() -> void {
+#ifdef LANDER_PROFILE
+    if (auto res{profiler::write_chrome_trace(
+            defs::paths::base_path / defs::paths::profile_trace_path
+        )};
+        not res)
+        utils::log(res.error());
+#endif
+
     // must shut down first, releasing shaders (shouldn't really need to)
     // requires graphics device, and MIX_DestroyAudio and TTF_CloseFont require
     // subsystems to be alive
@@ -89,6 +109,11 @@ auto App::update() -> void {
     game_state->timer->tick();
 
     while (game_state->timer->should_sim()) {
+        PROFILE_ZONE("App::simulate");
+
+        // shapes from the previous step stay up until this one draws its own
+        debug_draw::clear();
+
         // physics prev state = physics current state
         // 'integrate' (updating pos/velo with t and dt)
 
@@ -98,6 +123,9 @@ auto App::update() -> void {
         game_state->physics_system->iterate(
             game_state->game_objects, game_state->timer->sim_delta_seconds()
         );
+        game_state->particle_system->iterate(
+            game_state->game_objects, game_state->timer->sim_delta_seconds()
+        );
 
         // DEBUG
         static bool previous_state{false};
@@ -109,10 +137,40 @@ auto App::update() -> void {
         }
         previous_state = current_state;
 
+        // carve a crater under the lander
+        static bool previous_crater_state{false};
+        const bool crater_state{
+            game_state->input_system->crater_debug(game_state->game_objects, *input_state)
+        };
+        if (crater_state && !previous_crater_state) {
+            const glm::vec2 impact{game_state->lander->get_component<C_transform>()->position};
+            if (auto res{carve_crater(impact.x)}; not res)
+                utils::log(res.error());
+
+            game_state->particle_system->emit_burst(
+                defs::particles::Material::Explosion, impact, {0.0F, 1.0F},
+                defs::particles::crash_explosion
+            );
+            game_state->particle_system->emit_burst(
+                defs::particles::Material::Dust, impact, {0.0F, 1.0F}, defs::particles::crash_dust
+            );
+        }
+        previous_crater_state = crater_state;
+
+        // toggle the debug overlay
+        static bool previous_overlay_state{false};
+        if (input_state->is_g && !previous_overlay_state)
+            debug_draw::set_enabled(not debug_draw::is_enabled());
+        previous_overlay_state = input_state->is_g;
+        draw_debug_overlay();
+
         game_state->timer->advance_sim();
     }
 
     if (game_state->timer->should_render()) {
+        profiler::mark_frame();
+        PROFILE_ZONE("App::render");
+
         double alpha{game_state->timer->interpolation_alpha()};
 
         // // play sound
@@ -157,39 +215,49 @@ auto App::update() -> void {
         has_played = true;
         //
 
+        // hmm...
+        int window_width{};
+        SDL_GetWindowSizeInPixels(game_state->graphics->get_window(), &window_width, nullptr);
+
+        const defs::types::camera::Frame_data frame_data{
+            .view_matrix = game_state->camera->get_view_matrix(),
+            .proj_matrix = game_state->camera->get_projection_matrix(),
+            .camera_pos = game_state->camera->get_position(),
+            .pixels_per_unit =
+                static_cast<float>(window_width) / game_state->camera->get_view_size().x,
+        };
+
         // Rendering debug
         // Collect fresh render data - get commands into render_system's render_queue
         game_state->render_system->clear_queue();
-        game_state->render_system->collect_renderables(game_state->game_objects);
-
-        static std::string dbg_msg{""};
-        std::string dbg_msg1{"hello world"};
-        std::string dbg_msg2{"debug"};
-
-        static int counter{0};
-        ++counter;
-        if (counter % 120 == 0)
-            counter = 0;
-
-        if (counter <= 60)
-            dbg_msg = dbg_msg1;
-        else if (counter > 60)
-            dbg_msg = dbg_msg2;
-
+        game_state->render_system->collect_renderables(game_state->game_objects, frame_data);
+
+        // last frame's gpu calls
+        const Render_stats& stats{game_state->renderer->get_stats()};
+        const std::string dbg_msg{std::format(
+            "draws {} passes {} pipelines {} buffers {} textures {} pushes {}", stats.draws,
+            stats.render_passes + stats.copy_passes, stats.pipeline_binds, stats.buffer_binds,
+            stats.texture_binds, stats.uniform_pushes
+        )};
         game_state->text_manager->update_text_content(std::string(defs::ui::debug_text), dbg_msg);
 
         std::string fps_msg{std::format("{:.2f}", game_state->timer->get_fps())};
         game_state->text_manager->update_text_content(std::string(defs::ui::score_text), fps_msg);
+        update_profile_text();
 
         auto text_objects{game_state->text_manager->get_text_objects()};
         game_state->render_system->collect_text(text_objects);
-
-        // hmm...
-        const defs::types::camera::Frame_data frame_data{
-            .view_matrix = game_state->camera->get_view_matrix(),
-            .proj_matrix = game_state->camera->get_projection_matrix(),
-            .camera_pos = game_state->camera->get_position(),
-        };
+        game_state->render_system->collect_sprites(star_texture_id, stars);
+
+        game_state->particle_system->write_instances();
+        for (size_t i{0}; i < defs::particles::material_count; ++i)
+            game_state->render_system->collect_particles(
+                particle_texture_id,
+                game_state->particle_system->get_instances(
+                    static_cast<defs::particles::Material>(i)
+                )
+            );
+        game_state->render_system->collect_debug_lines(debug_draw::get_vertices());
 
         // Render things
         // game_state->renderer->begin_frame(frame_data);
@@ -214,19 +282,16 @@ auto App::load_startup_assets() -> utils::Result<> {
     for (const auto& sound : defs::assets::audio::startup_audio)
         TRY(game_state->resource_manager->load_sound(std::string(sound.file_name)));
 
-    for (const auto& shader_set : defs::assets::shaders::startup_shaders)
-        for (const auto& shader : *defs::assets::shaders::get_shader_set_file_names(
-                 std::string(shader_set.shader_set_name)
-             ))
-            TRY(game_state->resource_manager->load_shader(
-                game_state->graphics->get_device(), shader
-            ));
+    for (const auto& image : defs::assets::images::startup_images)
+        TRY(game_state->resource_manager->load_image(std::string(image)));
+
+    // shaders are compiled by the pipeline jobs that use them, see create_default_pipelines
 
     for (const auto& mesh : defs::assets::meshes::hardcoded_meshes) {
         auto mesh_id{TRY(
             game_state->resource_manager->create_mesh(std::string(mesh.mesh_name), mesh.as_vector())
         )};
-        TRY(game_state->renderer->register_mesh(mesh_id));
+        startup_mesh_ids.push_back(mesh_id);
     }
 
     return {};
@@ -248,6 +313,10 @@ auto App::create_lander() -> utils::Result<> {
     // add other components
     lander->add_component<C_physics>(50.0F);         // 50kg
     lander->add_component<C_player_controller>();    // thrust, rot speed
+    lander->add_component<C_emitter>(
+        defs::particles::Material::Exhaust, defs::particles::exhaust_offset,
+        glm::vec2{0.0F, -1.0F}, defs::particles::exhaust_rate
+    );
 
     // add collider component using vertices from mesh
     const defs::types::vertex::Mesh_data mesh_data{
@@ -284,29 +353,214 @@ auto App::create_default_ui() -> utils::Result<> {
         {100.0F, 100.0F}, {1.0F, 1.0F}, defs::colors::white
     ));
 
+#ifdef LANDER_PROFILE
+    TRY(game_state->text_manager->create_text(
+        std::string(defs::ui::profile_text), std::string(defs::assets::fonts::font_pong),
+        "profiling", {20.0F, 500.0F}, {0.5F, 0.5F}, defs::colors::white
+    ));
+#endif
+
     return {};
 }
 
-auto App::create_terrain_object() -> utils::Result<> {
+auto App::update_profile_text() -> void {
+#ifdef LANDER_PROFILE
+    const Uint64 now{SDL_GetTicksNS()};
+    if (now - last_profile_summary < defs::ui::profile_interval_ns)
+        return;
+    last_profile_summary = now;
+
+    // one line per zone, most expensive first
+    std::string summary{"zone ms/frame max calls"};
+    for (const profiler::Zone_summary& zone : profiler::summarize(defs::ui::profile_zones))
+        summary += std::format(
+            "\n{} {:.3f} {:.3f} {}", zone.name, zone.ms_per_frame, zone.max_ms, zone.calls
+        );
+
+    if (auto res{game_state->text_manager->update_text_content(
+            std::string(defs::ui::profile_text), summary
+        )};
+        not res)
+        utils::log(res.error());
+#endif
+}
+
+auto App::draw_debug_overlay() -> void {
+    if (not debug_draw::is_enabled())
+        return;
+
+    PROFILE_ZONE("App::draw_debug_overlay");
+
+    for (const auto& obj : game_state->game_objects) {
+        const C_transform* transform{obj->get_component<C_transform>()};
+        const C_collider* collider{obj->get_component<C_collider>()};
+        const C_physics* physics{obj->get_component<C_physics>()};
+
+        // collider outline in world space and the box around it
+        if (transform && collider && not collider->vertices.empty()) {
+            const glm::mat4 model{transform->get_matrix()};
+            debug_points.clear();
+            glm::vec2 min{std::numeric_limits<float>::max()};
+            glm::vec2 max{std::numeric_limits<float>::lowest()};
+            for (const glm::vec2 vertex : collider->vertices) {
+                const glm::vec2 point{model * glm::vec4{vertex, 0.0F, 1.0F}};
+                debug_points.push_back(point);
+                min = glm::min(min, point);
+                max = glm::max(max, point);
+            }
+            debug_draw::polyline(debug_points, defs::debug_draw::collider_color, true);
+            debug_draw::aabb(min, max, defs::debug_draw::bounds_color);
+        }
 
-    int width{};
-    int height{};
-    SDL_GetWindowSizeInPixels(game_state->graphics->get_window(), &width, &height);
+        if (transform && physics)
+            debug_draw::line(
+                transform->position,
+                transform->position + (physics->velocity * defs::debug_draw::velocity_scale),
+                defs::debug_draw::velocity_color
+            );
+    }
+
+    // what the terrain generator produced, anchors are the points simplification keeps
+    if (const C_terrain_points* terrain{game_state->terrain->get_component<C_terrain_points>()}) {
+        debug_draw::polyline(terrain->points, defs::debug_draw::terrain_color);
+        for (const size_t anchor : terrain->anchors)
+            debug_draw::circle(
+                terrain->points[anchor], defs::debug_draw::anchor_radius,
+                defs::debug_draw::anchor_color, defs::debug_draw::anchor_segments
+            );
+    }
 
-    Terrain_generator generator{static_cast<float>(width), static_cast<float>(height)};
-    const defs::types::terrain::Terrain_data terrain_data{TRY(generator.generate_terrain())};
+    if (const C_landing_zones* zones{game_state->terrain->get_component<C_landing_zones>()}) {
+        const float height{defs::debug_draw::label_height};
+        for (const defs::types::terrain::Landing_zone& zone : zones->zones) {
+            debug_draw::aabb(
+                {zone.start.x, std::min(zone.start.y, zone.end.y)},
+                {zone.end.x, std::max(zone.start.y, zone.end.y) + height},
+                defs::debug_draw::landing_zone_color
+            );
+
+            // score above the zone, formatted without allocating
+            std::array<char, 16> text{};
+            const auto written{std::format_to_n(text.data(), text.size(), "x{}", zone.score_value)};
+            debug_draw::label(
+                {zone.start.x, std::max(zone.start.y, zone.end.y) + (height * 2.0F)},
+                {text.data(), std::min(static_cast<size_t>(written.size), text.size())},
+                defs::debug_draw::landing_zone_color
+            );
+        }
+    }
+}
 
-    const defs::types::vertex::Mesh_data vertices{TRY(generator.generate_vertices(terrain_data))};
-    auto mesh_id{
-        TRY(game_state->resource_manager->create_mesh(std::string(defs::terrain::name), vertices))
+auto App::create_starfield() -> utils::Result<> {
+    SDL_Surface* image{TRY(
+        game_state->resource_manager->get_image(std::string(defs::assets::images::image_star))
+    )};
+    star_texture_id = TRY(game_state->renderer->create_texture(*image));
+
+    // scattered over the whole view, the terrain is drawn over the low ones
+    std::mt19937 rng{defs::background::star_seed};
+    const glm::vec2 view_size{game_state->camera->get_view_size()};
+    std::uniform_real_distribution<float> x_dist{0.0F, view_size.x};
+    std::uniform_real_distribution<float> y_dist{0.0F, view_size.y};
+    std::uniform_real_distribution<float> size_dist{
+        defs::background::star_min_size, defs::background::star_max_size
     };
-    TRY(game_state->renderer->register_mesh(mesh_id));
+    std::uniform_real_distribution<float> brightness_dist{0.3F, 1.0F};
+
+    stars.clear();
+    stars.reserve(defs::background::star_count);
+    for (int i = 0; i < defs::background::star_count; ++i) {
+        const float size{size_dist(rng)};
+        const float brightness{brightness_dist(rng)};
+        stars.push_back({
+            .position = {x_dist(rng), y_dist(rng), 0.0F},
+            .rotation = 0.0F,
+            .scale = {size, size},
+            .uv_rect = {0.0F, 0.0F, 1.0F, 1.0F},
+            .color = {brightness, brightness, 1.0F, brightness},
+        });
+    }
+
+    return {};
+}
+
+auto App::create_particle_texture() -> utils::Result<> {
+    constexpr int size{defs::particles::texture_size};
+
+    // premultiplied, color fades with alpha so glowing particles have no square edge
+    SDL_Surface* surface{CHECK_PTR(SDL_CreateSurface(size, size, SDL_PIXELFORMAT_RGBA32))};
+    const float radius{static_cast<float>(size) * 0.5F};
+    for (int y = 0; y < size; ++y) {
+        auto* row{static_cast<Uint8*>(surface->pixels) + (y * surface->pitch)};
+        for (int x = 0; x < size; ++x) {
+            const float distance{std::hypot(
+                static_cast<float>(x) + 0.5F - radius, static_cast<float>(y) + 0.5F - radius
+            )};
+            const float falloff{std::clamp(1.0F - (distance / radius), 0.0F, 1.0F)};
+            const auto value{static_cast<Uint8>(falloff * falloff * 255.0F)};
+            std::fill_n(row + (x * 4), 4, value);
+        }
+    }
+
+    auto texture_id{game_state->renderer->create_texture(*surface)};
+    SDL_DestroySurface(surface);
+    particle_texture_id = TRY(texture_id);
+
+    return {};
+}
+
+auto App::create_terrain_object() -> utils::Result<> {
+
+    // prefer the curated set, generate when it has not been baked
+    const auto level{load_level(0)};
+    if (level)
+        current_level = 0;
+    else
+        utils::log(std::format("No baked levels, generating terrain: {}", level.error()));
+
+    defs::types::terrain::Terrain_data terrain_data{};
+    std::vector<defs::types::vertex::Mesh_data> lod_vertices{};
+    if (level) {
+        terrain_data = level.value()->to_terrain_data();
+    } else {
+        int width{};
+        int height{};
+        SDL_GetWindowSizeInPixels(game_state->graphics->get_window(), &width, &height);
+
+        Terrain_generator generator{static_cast<float>(width), static_cast<float>(height)};
+        terrain_data = TRY(generator.generate_terrain());
+        lod_vertices = TRY(generator.generate_lod_vertices(terrain_data));
+    }
+
+    // one mesh per detail level, level 0 keeps the plain terrain name
+    // baked meshes are views into the mapped file, uploaded without a copy
+    std::vector<Uint32> lod_mesh_ids{};
+    std::vector<float> lod_errors{};
+    for (size_t i = 0; i < terrain_data.lods.size(); ++i) {
+        const std::string mesh_name{
+            i == 0 ? std::string(defs::terrain::name)
+                   : std::format("{}_lod_{}", defs::terrain::name, i)
+        };
+        auto mesh_id{TRY(
+            level ? game_state->resource_manager->create_mesh_view(
+                        mesh_name, level.value()->lod_vertices(i)
+                    )
+                  : game_state->resource_manager->create_mesh(mesh_name, lod_vertices[i])
+        )};
+        startup_mesh_ids.push_back(mesh_id);
+
+        lod_mesh_ids.push_back(mesh_id);
+        lod_errors.push_back(terrain_data.lods[i].max_error);
+    }
 
     auto terrain{std::make_unique<Game_object>()};
 
-    terrain->add_component<C_terrain_points>(terrain_data.points);
+    terrain->add_component<C_terrain_points>(
+        terrain_data.points, terrain_data.anchors, terrain_data.lods
+    );
     terrain->add_component<C_landing_zones>(terrain_data.landing_zones);
-    terrain->add_component<C_mesh>(mesh_id);
+    terrain->add_component<C_mesh>(lod_mesh_ids.front());
+    terrain->add_component<C_mesh_lod>(lod_mesh_ids, lod_errors);
     terrain->add_component<C_render>(static_cast<Uint32>(defs::pipelines::Type::Line), 0.0F, true);
 
     // store ref and add to collection
@@ -316,30 +570,121 @@ auto App::create_terrain_object() -> utils::Result<> {
     return {};
 }
 
-auto App::regenerate_terrain() -> utils::Result<> {
+auto App::load_level(const int index) -> utils::Result<const level_file::Level_view*> {
+    const std::string file_name{defs::assets::levels::level_file_name(index)};
 
-    int width{};
-    int height{};
-    SDL_GetWindowSizeInPixels(game_state->graphics->get_window(), &width, &height);
+    const Uint64 start{SDL_GetTicksNS()};
+    const level_file::Level_view* level{TRY(game_state->resource_manager->load_level(file_name))};
+    const Uint64 elapsed{SDL_GetTicksNS() - start};
 
-    Terrain_generator generator{static_cast<float>(width), static_cast<float>(height)};
+    utils::log(
+        std::format(
+            "Level '{}' loaded in {:.1f} us ({} points, {} vertices)", file_name,
+            static_cast<double>(elapsed) / 1'000.0, level->points.size(), level->vertices.size()
+        )
+    );
 
-    const defs::types::terrain::Terrain_data terrain_data{TRY(generator.generate_terrain())};
-    const defs::types::vertex::Mesh_data vertices{TRY(generator.generate_vertices(terrain_data))};
+    return level;
+}
+
+auto App::regenerate_terrain() -> utils::Result<> {
 
     C_mesh* mesh{game_state->terrain->get_component<C_mesh>()};
-    if (not mesh)
+    C_mesh_lod* mesh_lod{game_state->terrain->get_component<C_mesh_lod>()};
+    if (not mesh || not mesh_lod)
         return std::unexpected("Terrain mesh not found");
 
-    const Uint32 mesh_id{TRY(game_state->resource_manager->update_mesh(mesh->mesh_id, vertices))};
-    TRY(game_state->renderer->reregister_mesh(mesh_id));
-    mesh->mesh_id = mesh_id;
+    // cycle through the curated set when there is one
+    const level_file::Level_view* level{nullptr};
+    if (current_level >= 0) {
+        const int next_level{(current_level + 1) % defs::assets::levels::level_count};
+        if (auto loaded{load_level(next_level)}; loaded) {
+            level = loaded.value();
+            current_level = next_level;
+        } else {
+            utils::log(loaded.error());
+        }
+    }
+
+    defs::types::terrain::Terrain_data terrain_data{};
+    std::vector<defs::types::vertex::Mesh_data> lod_vertices{};
+    if (level) {
+        terrain_data = level->to_terrain_data();
+    } else {
+        int width{};
+        int height{};
+        SDL_GetWindowSizeInPixels(game_state->graphics->get_window(), &width, &height);
+
+        Terrain_generator generator{static_cast<float>(width), static_cast<float>(height)};
+        terrain_data = TRY(generator.generate_terrain());
+        lod_vertices = TRY(generator.generate_lod_vertices(terrain_data));
+    }
+
+    // level count is fixed, so every level maps onto its existing mesh
+    if (terrain_data.lods.size() != mesh_lod->mesh_ids.size())
+        return std::unexpected(
+            std::format(
+                "Terrain has {} lods, expected {}", terrain_data.lods.size(),
+                mesh_lod->mesh_ids.size()
+            )
+        );
+
+    for (size_t i = 0; i < mesh_lod->mesh_ids.size(); ++i) {
+        const Uint32 mesh_id{TRY(
+            level ? game_state->resource_manager->set_mesh_view(
+                        mesh_lod->mesh_ids[i], level->lod_vertices(i)
+                    )
+                  : game_state->resource_manager->update_mesh(
+                        mesh_lod->mesh_ids[i], lod_vertices[i]
+                    )
+        )};
+        TRY(game_state->renderer->reregister_mesh(mesh_id));
+        mesh_lod->max_errors[i] = terrain_data.lods[i].max_error;
+    }
+    mesh->mesh_id = mesh_lod->mesh_ids.front();
 
     C_terrain_points* terrain_points{game_state->terrain->get_component<C_terrain_points>()};
     C_landing_zones* landing_zones{game_state->terrain->get_component<C_landing_zones>()};
 
-    terrain_points->points = terrain_data.points;
-    landing_zones->zones = terrain_data.landing_zones;
+    terrain_points->points = std::move(terrain_data.points);
+    terrain_points->anchors = std::move(terrain_data.anchors);
+    terrain_points->lods = std::move(terrain_data.lods);
+    landing_zones->zones = std::move(terrain_data.landing_zones);
+
+    return {};
+}
+
+auto App::carve_crater(const float x) -> utils::Result<> {
+
+    C_terrain_points* terrain_points{game_state->terrain->get_component<C_terrain_points>()};
+    C_mesh_lod* mesh_lod{game_state->terrain->get_component<C_mesh_lod>()};
+    if (not terrain_points || not mesh_lod)
+        return std::unexpected("Terrain mesh not found");
+
+    const defs::types::terrain::Crater crater{
+        .x = x,
+        .radius = defs::terrain::crater_radius,
+        .depth = defs::terrain::crater_depth,
+        .floor = defs::terrain::line_thickness,
+    };
+
+    // points are edited in place, so anything reading them sees the crater right away
+    const std::vector<defs::types::terrain::Terrain_patch> patches{
+        TRY(Terrain_generator::carve_crater(
+            terrain_points->points, terrain_points->anchors, terrain_points->lods, crater
+        ))
+    };
+
+    // each level only re-uploads the vertices around the crater
+    for (size_t i = 0; i < patches.size() && i < mesh_lod->mesh_ids.size(); ++i) {
+        const defs::types::terrain::Terrain_patch& patch{patches[i]};
+        const size_t changed{TRY(game_state->resource_manager->update_mesh_range(
+            mesh_lod->mesh_ids[i], patch.first_vertex, patch.replaced_count, patch.vertices
+        ))};
+        TRY(game_state->renderer->update_mesh_range(
+            mesh_lod->mesh_ids[i], patch.first_vertex, changed
+        ));
+    }
 
     return {};
 }
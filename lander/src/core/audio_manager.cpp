@@ -1,6 +1,7 @@
 
 
 #include <audio_manager.h>
+#include <profiler.h>
 
 auto Audio_manager::init(Resource_manager* res_manager) -> utils::Result<> {
 
@@ -23,6 +24,7 @@ auto Audio_manager::quit() -> void {
 
 auto Audio_manager::play_sound(const std::string& name, const float volume, const int loops)
     -> utils::Result<> {
+    PROFILE_ZONE("Audio_manager::play_sound");
 
     MIX_Audio* sound{TRY(resource_manager->get_sound(name))};
     MIX_Track* track{CHECK_PTR(MIX_CreateTrack(mixer))};
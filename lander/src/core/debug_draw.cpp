@@ -0,0 +1,290 @@
+
+
+#include <debug_draw.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace debug_draw {
+
+    namespace {
+
+        using defs::types::vertex::Mesh_vertex;
+
+        struct Stream {
+            std::vector<Mesh_vertex> vertices;
+            std::atomic<Uint32> used{0};
+            std::atomic<size_t> dropped{0};
+
+            Stream() : vertices(defs::debug_draw::max_vertices) {}
+        };
+
+        std::atomic<bool> enabled{false};
+
+        auto stream() -> Stream& {
+            static Stream instance;
+            return instance;
+        }
+
+        // Room for count vertices, nullptr when the stream is full
+        auto reserve(const Uint32 count) -> Mesh_vertex* {
+            Stream& lines{stream()};
+            Uint32 first{lines.used.load(std::memory_order_relaxed)};
+            do {
+                if (count > defs::debug_draw::max_vertices - first) {
+                    lines.dropped.fetch_add(count / 2, std::memory_order_relaxed);
+                    return nullptr;
+                }
+            } while (not lines.used.compare_exchange_weak(
+                first, first + count, std::memory_order_relaxed
+            ));
+            return lines.vertices.data() + first;
+        }
+
+        // Glyphs on a 3 by 5 grid, x then y from the bottom left, a polyline per stroke
+        constexpr auto glyph_table = std::to_array<std::pair<char, std::string_view>>({
+            {'0', "0020240400 0024"},
+            {'1', "031410 0020"},
+            {'2', "042422020020"},
+            {'3', "04242000 0222"},
+            {'4', "040222 2420"},
+            {'5', "240402222000"},
+            {'6', "240400202202"},
+            {'7', "042420"},
+            {'8', "0020240400 0222"},
+            {'9', "2024040222"},
+            {'A', "00042420 0222"},
+            {'B', "0004142312211000 0212"},
+            {'C', "24040020"},
+            {'D', "00041423211000"},
+            {'E', "24040020 0212"},
+            {'F', "240400 0212"},
+            {'G', "240400202212"},
+            {'H', "0004 2024 0222"},
+            {'I', "0424 1014 0020"},
+            {'J', "24200001"},
+            {'K', "0004 240220"},
+            {'L', "040020"},
+            {'M', "0004122420"},
+            {'N', "00042024"},
+            {'O', "0020240400"},
+            {'P', "0004242202"},
+            {'Q', "0020240400 1120"},
+            {'R', "0004242202 1220"},
+            {'S', "240402222000"},
+            {'T', "0424 1410"},
+            {'U', "04002024"},
+            {'V', "041024"},
+            {'W', "0400122024"},
+            {'X', "0024 0420"},
+            {'Y', "041224 1210"},
+            {'Z', "04240020"},
+            {'.', "1011"},
+            {',', "1100"},
+            {':', "1011 1314"},
+            {'!', "1011 1214"},
+            {'-', "0222"},
+            {'+', "0222 1113"},
+            {'=', "0121 0323"},
+            {'_', "0020"},
+            {'/', "0024"},
+            {'<', "230221"},
+            {'>', "032201"},
+            {'(', "14030110"},
+            {')', "14232110"},
+            {'[', "14040010"},
+            {']', "04141000"},
+        });
+
+        // by character code, empty for anything without a glyph
+        constexpr auto glyphs{[] {
+            std::array<std::string_view, 128> by_code{};
+            for (const auto& [c, strokes] : glyph_table)
+                by_code[static_cast<size_t>(c)] = strokes;
+            return by_code;
+        }()};
+
+        // lower case is drawn upper case
+        constexpr auto glyph_strokes(const char c) -> std::string_view {
+            const char upper{c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c};
+            const auto code{static_cast<unsigned char>(upper)};
+            return code < glyphs.size() ? glyphs[code] : std::string_view{};
+        }
+
+        // Calls segment(x0, y0, x1, y1) in grid units for every line of a glyph
+        template <typename Fn>
+        constexpr auto for_each_segment(const std::string_view strokes, Fn&& segment) -> void {
+            size_t start{0};
+            while (start < strokes.size()) {
+                const size_t end{std::min(strokes.find(' ', start), strokes.size())};
+                for (size_t i{start}; i + 4 <= end; i += 2)
+                    segment(
+                        strokes[i] - '0', strokes[i + 1] - '0', strokes[i + 2] - '0',
+                        strokes[i + 3] - '0'
+                    );
+                start = end + 1;
+            }
+        }
+
+        constexpr auto count_segments(const std::string_view strokes) -> Uint32 {
+            Uint32 count{0};
+            for_each_segment(strokes, [&count](int, int, int, int) { ++count; });
+            return count;
+        }
+
+        // every stroke is whole points on the grid
+        static_assert([] {
+            for (const auto& [c, strokes] : glyph_table) {
+                size_t start{0};
+                while (start < strokes.size()) {
+                    const size_t end{std::min(strokes.find(' ', start), strokes.size())};
+                    if (end - start < 4 || (end - start) % 2 != 0)
+                        return false;
+                    for (size_t i{start}; i < end; i += 2)
+                        if (strokes[i] < '0' || strokes[i] > '2' || strokes[i + 1] < '0'
+                            || strokes[i + 1] > '4')
+                            return false;
+                    start = end + 1;
+                }
+            }
+            return true;
+        }());
+
+        constexpr float glyph_advance{3.0F};    // grid units, glyph and gap
+        constexpr float glyph_height{4.0F};
+        constexpr float line_advance{6.0F};
+
+    }    // namespace
+
+    auto set_enabled(const bool enable) -> void {
+        if (enable && not enabled.load(std::memory_order_relaxed)) {
+            stream().used.store(0, std::memory_order_relaxed);
+            stream().dropped.store(0, std::memory_order_relaxed);
+        }
+        enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    auto is_enabled() -> bool {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    auto line(const glm::vec2 from, const glm::vec2 to, const glm::vec4 color) -> void {
+        if (not is_enabled())
+            return;
+
+        if (Mesh_vertex* out{reserve(2)}) {
+            out[0] = {.position = from, .color = color};
+            out[1] = {.position = to, .color = color};
+        }
+    }
+
+    auto polyline(
+        const std::span<const glm::vec2> points, const glm::vec4 color, const bool closed
+    ) -> void {
+        if (not is_enabled() || points.size() < 2)
+            return;
+
+        const auto segments{static_cast<Uint32>(points.size() - (closed ? 0 : 1))};
+        Mesh_vertex* out{reserve(segments * 2)};
+        if (not out)
+            return;
+
+        for (Uint32 i{0}; i < segments; ++i) {
+            *out++ = {.position = points[i], .color = color};
+            *out++ = {.position = points[(i + 1) % points.size()], .color = color};
+        }
+    }
+
+    auto circle(
+        const glm::vec2 center, const float radius, const glm::vec4 color, const Uint32 segments
+    ) -> void {
+        if (not is_enabled() || segments < 3)
+            return;
+
+        Mesh_vertex* out{reserve(segments * 2)};
+        if (not out)
+            return;
+
+        // one sin and cos per circle, each point is the last one rotated by a step
+        const float step{6.28318531F / static_cast<float>(segments)};
+        const float cos_step{std::cos(step)};
+        const float sin_step{std::sin(step)};
+        glm::vec2 offset{radius, 0.0F};
+        for (Uint32 i{0}; i < segments; ++i) {
+            const glm::vec2 next{
+                i + 1 == segments ? glm::vec2{radius, 0.0F}
+                                  : glm::vec2{
+                                        (offset.x * cos_step) - (offset.y * sin_step),
+                                        (offset.x * sin_step) + (offset.y * cos_step)
+                                    }
+            };
+            *out++ = {.position = center + offset, .color = color};
+            *out++ = {.position = center + next, .color = color};
+            offset = next;
+        }
+    }
+
+    auto aabb(const glm::vec2 min, const glm::vec2 max, const glm::vec4 color) -> void {
+        const std::array<glm::vec2, 4> corners{min, {max.x, min.y}, max, {min.x, max.y}};
+        polyline(corners, color, true);
+    }
+
+    auto label(
+        const glm::vec2 position, const std::string_view text, const glm::vec4 color,
+        const float height
+    ) -> void {
+        if (not is_enabled())
+            return;
+
+        // reserved as one shape so a label is never cut short
+        Uint32 segments{0};
+        for (const char c : text)
+            segments += count_segments(glyph_strokes(c));
+        Mesh_vertex* out{segments > 0 ? reserve(segments * 2) : nullptr};
+        if (not out)
+            return;
+
+        const float scale{height / glyph_height};
+        glm::vec2 origin{position};
+        for (const char c : text) {
+            if (c == '\n') {
+                origin = {position.x, origin.y - (line_advance * scale)};
+                continue;
+            }
+
+            const auto segment{[&out, origin, scale, color](
+                                   const int x0, const int y0, const int x1, const int y1
+                               ) {
+                *out++ = {.position = origin + (glm::vec2{x0, y0} * scale), .color = color};
+                *out++ = {.position = origin + (glm::vec2{x1, y1} * scale), .color = color};
+            }};
+            for_each_segment(glyph_strokes(c), segment);
+            origin.x += glyph_advance * scale;
+        }
+    }
+
+    auto get_vertices() -> std::span<const Mesh_vertex> {
+        if (not is_enabled())
+            return {};
+
+        const Stream& lines{stream()};
+        return {lines.vertices.data(), lines.used.load(std::memory_order_relaxed)};
+    }
+
+    auto get_dropped() -> size_t {
+        return is_enabled() ? stream().dropped.load(std::memory_order_relaxed) : 0;
+    }
+
+    auto clear() -> void {
+        if (not is_enabled())
+            return;
+
+        stream().used.store(0, std::memory_order_relaxed);
+        stream().dropped.store(0, std::memory_order_relaxed);
+    }
+
+}    // namespace debug_draw
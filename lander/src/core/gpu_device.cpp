@@ -0,0 +1,198 @@
+
+
+#include <gpu_device.h>
+#include <resource_manager.h>
+
+auto Sdl_gpu_device::create_buffer(const SDL_GPUBufferCreateInfo& info) -> SDL_GPUBuffer* {
+    return SDL_CreateGPUBuffer(device, &info);
+}
+
+auto Sdl_gpu_device::release_buffer(SDL_GPUBuffer* buffer) -> void {
+    SDL_ReleaseGPUBuffer(device, buffer);
+}
+
+auto Sdl_gpu_device::create_transfer_buffer(const SDL_GPUTransferBufferCreateInfo& info)
+    -> SDL_GPUTransferBuffer* {
+    return SDL_CreateGPUTransferBuffer(device, &info);
+}
+
+auto Sdl_gpu_device::release_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void {
+    SDL_ReleaseGPUTransferBuffer(device, buffer);
+}
+
+auto Sdl_gpu_device::map_transfer_buffer(SDL_GPUTransferBuffer* buffer, const bool cycle)
+    -> void* {
+    return SDL_MapGPUTransferBuffer(device, buffer, cycle);
+}
+
+auto Sdl_gpu_device::unmap_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void {
+    SDL_UnmapGPUTransferBuffer(device, buffer);
+}
+
+auto Sdl_gpu_device::create_texture(const SDL_GPUTextureCreateInfo& info) -> SDL_GPUTexture* {
+    return SDL_CreateGPUTexture(device, &info);
+}
+
+auto Sdl_gpu_device::release_texture(SDL_GPUTexture* texture) -> void {
+    SDL_ReleaseGPUTexture(device, texture);
+}
+
+auto Sdl_gpu_device::create_sampler(const SDL_GPUSamplerCreateInfo& info) -> SDL_GPUSampler* {
+    return SDL_CreateGPUSampler(device, &info);
+}
+
+auto Sdl_gpu_device::release_sampler(SDL_GPUSampler* sampler) -> void {
+    SDL_ReleaseGPUSampler(device, sampler);
+}
+
+auto Sdl_gpu_device::create_graphics_pipeline(const SDL_GPUGraphicsPipelineCreateInfo& info)
+    -> SDL_GPUGraphicsPipeline* {
+    return SDL_CreateGPUGraphicsPipeline(device, &info);
+}
+
+auto Sdl_gpu_device::release_graphics_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void {
+    SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+}
+
+auto Sdl_gpu_device::create_shader(
+    Resource_manager& resource_manager, const std::string& file_name
+) -> utils::Result<SDL_GPUShader*> {
+    return resource_manager.create_shader(device, file_name);
+}
+
+auto Sdl_gpu_device::release_shader(SDL_GPUShader* shader) -> void {
+    SDL_ReleaseGPUShader(device, shader);
+}
+
+auto Sdl_gpu_device::swapchain_format() -> SDL_GPUTextureFormat {
+    return SDL_GetGPUSwapchainTextureFormat(device, window);
+}
+
+auto Sdl_gpu_device::acquire_command_buffer() -> SDL_GPUCommandBuffer* {
+    return SDL_AcquireGPUCommandBuffer(device);
+}
+
+auto Sdl_gpu_device::submit_with_fence(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUFence* {
+    return SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+}
+
+auto Sdl_gpu_device::wait_for_fence(SDL_GPUFence* fence) -> bool {
+    return SDL_WaitForGPUFences(device, true, &fence, 1);
+}
+
+auto Sdl_gpu_device::release_fence(SDL_GPUFence* fence) -> void {
+    SDL_ReleaseGPUFence(device, fence);
+}
+
+auto Sdl_gpu_device::wait_for_idle() -> bool {
+    return SDL_WaitForGPUIdle(device);
+}
+
+auto Sdl_gpu_device::acquire_swapchain_texture(
+    SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture** texture, Uint32* width, Uint32* height
+) -> bool {
+    return SDL_WaitAndAcquireGPUSwapchainTexture(command_buffer, window, texture, width, height);
+}
+
+auto Sdl_gpu_device::begin_copy_pass(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUCopyPass* {
+    return SDL_BeginGPUCopyPass(command_buffer);
+}
+
+auto Sdl_gpu_device::end_copy_pass(SDL_GPUCopyPass* copy_pass) -> void {
+    SDL_EndGPUCopyPass(copy_pass);
+}
+
+auto Sdl_gpu_device::upload_to_buffer(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUTransferBufferLocation& source,
+    const SDL_GPUBufferRegion& destination, const bool cycle
+) -> void {
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, cycle);
+}
+
+auto Sdl_gpu_device::upload_to_texture(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUTextureTransferInfo& source,
+    const SDL_GPUTextureRegion& destination, const bool cycle
+) -> void {
+    SDL_UploadToGPUTexture(copy_pass, &source, &destination, cycle);
+}
+
+auto Sdl_gpu_device::copy_buffer_to_buffer(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUBufferLocation& source,
+    const SDL_GPUBufferLocation& destination, const Uint32 size, const bool cycle
+) -> void {
+    SDL_CopyGPUBufferToBuffer(copy_pass, &source, &destination, size, cycle);
+}
+
+auto Sdl_gpu_device::blit_texture(
+    SDL_GPUCommandBuffer* command_buffer, const SDL_GPUBlitInfo& info
+) -> void {
+    SDL_BlitGPUTexture(command_buffer, &info);
+}
+
+auto Sdl_gpu_device::begin_render_pass(
+    SDL_GPUCommandBuffer* command_buffer,
+    const std::span<const SDL_GPUColorTargetInfo> color_targets,
+    const SDL_GPUDepthStencilTargetInfo* depth_target
+) -> SDL_GPURenderPass* {
+    return SDL_BeginGPURenderPass(
+        command_buffer, color_targets.data(), static_cast<Uint32>(color_targets.size()),
+        depth_target
+    );
+}
+
+auto Sdl_gpu_device::end_render_pass(SDL_GPURenderPass* render_pass) -> void {
+    SDL_EndGPURenderPass(render_pass);
+}
+
+auto Sdl_gpu_device::bind_graphics_pipeline(
+    SDL_GPURenderPass* render_pass, SDL_GPUGraphicsPipeline* pipeline
+) -> void {
+    SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
+}
+
+auto Sdl_gpu_device::bind_vertex_buffer(
+    SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding
+) -> void {
+    SDL_BindGPUVertexBuffers(render_pass, 0, &binding, 1);
+}
+
+auto Sdl_gpu_device::bind_index_buffer(
+    SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding,
+    const SDL_GPUIndexElementSize element_size
+) -> void {
+    SDL_BindGPUIndexBuffer(render_pass, &binding, element_size);
+}
+
+auto Sdl_gpu_device::bind_vertex_storage_buffer(
+    SDL_GPURenderPass* render_pass, SDL_GPUBuffer* buffer
+) -> void {
+    SDL_BindGPUVertexStorageBuffers(render_pass, 0, &buffer, 1);
+}
+
+auto Sdl_gpu_device::bind_fragment_sampler(
+    SDL_GPURenderPass* render_pass, const SDL_GPUTextureSamplerBinding& binding
+) -> void {
+    SDL_BindGPUFragmentSamplers(render_pass, 0, &binding, 1);
+}
+
+auto Sdl_gpu_device::push_vertex_uniforms(
+    SDL_GPUCommandBuffer* command_buffer, const Uint32 slot, const void* data, const Uint32 bytes
+) -> void {
+    SDL_PushGPUVertexUniformData(command_buffer, slot, data, bytes);
+}
+
+auto Sdl_gpu_device::draw(
+    SDL_GPURenderPass* render_pass, const Uint32 vertex_count, const Uint32 instance_count,
+    const Uint32 first_vertex, const Uint32 first_instance
+) -> void {
+    SDL_DrawGPUPrimitives(render_pass, vertex_count, instance_count, first_vertex, first_instance);
+}
+
+auto Sdl_gpu_device::draw_indexed(
+    SDL_GPURenderPass* render_pass, const Uint32 index_count, const Uint32 instance_count,
+    const Uint32 first_index, const Sint32 vertex_offset, const Uint32 first_instance
+) -> void {
+    SDL_DrawGPUIndexedPrimitives(
+        render_pass, index_count, instance_count, first_index, vertex_offset, first_instance
+    );
+}
@@ -8,11 +8,13 @@ auto Graphics_context::init(int width, int height, const std::string& title) ->
 
     window = TRY(create_window(width, height, title));
     device = TRY(create_device());
+    gpu = std::make_unique<Sdl_gpu_device>(device, window);
 
     return {};
 }
 
 auto Graphics_context::quit() -> void {
+    gpu.reset();
     if (device && window)
         SDL_ReleaseWindowFromGPUDevice(device, window);
     if (device)
@@ -7,6 +7,7 @@
 #include <game_state.h>
 #include <graphics_context.h>
 #include <lander_game.h>
+#include <level_file.h>
 #include <renderer.h>
 #include <terrain_generator.h>
 #include <text_manager.h>
@@ -23,6 +24,13 @@ class App {
 private:
     std::unique_ptr<Game_state> game_state;
     SDL_AppResult app_status{SDL_APP_CONTINUE};
+    int current_level{-1};    // index into the curated set, -1 when terrain is generated
+    std::vector<Uint32> startup_mesh_ids;    // created during init, registered as one batch
+    Uint32 star_texture_id{0};
+    std::vector<defs::types::shader::Sprite_instance> stars;    // background sprites
+    Uint32 particle_texture_id{0};
+    Uint64 last_profile_summary{0};
+    std::vector<glm::vec2> debug_points;    // reused by the debug overlay
 
 public:
     App() = default;
@@ -53,10 +61,17 @@ private:
     auto create_lander() -> utils::Result<>;
     auto create_default_pipelines() -> utils::Result<>;
     auto create_default_ui() -> utils::Result<>;
+    auto create_starfield() -> utils::Result<>;
+    auto create_particle_texture() -> utils::Result<>;
+    auto update_profile_text() -> void;
+    // colliders, velocities, terrain anchors and landing zones through debug_draw
+    auto draw_debug_overlay() -> void;
 
     auto create_terrain_object() -> utils::Result<>;
 
+    auto load_level(int index) -> utils::Result<const level_file::Level_view*>;
     auto regenerate_terrain() -> utils::Result<>;
+    auto carve_crater(float x) -> utils::Result<>;
 };
 
 #endif    // SDL3_GAME_APP_H
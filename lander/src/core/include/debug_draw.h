@@ -0,0 +1,53 @@
+
+
+#ifndef SDL3_GAME_DEBUG_DRAW_H
+#define SDL3_GAME_DEBUG_DRAW_H
+
+#include <SDL3/SDL.h>
+#include <definitions.h>
+
+#include <glm/glm/vec2.hpp>
+#include <glm/glm/vec4.hpp>
+#include <span>
+#include <string_view>
+
+// Immediate mode world space lines for looking at colliders, terrain and the like
+// Any thread may draw during a simulation step, every shape reserves its vertices in one
+// shared stream with a compare and swap and writes them without locking, shapes that do
+// not fit are dropped whole
+// Everything is a line list, labels included (a built in stroke font), so the renderer
+// flushes the whole stream with one draw
+// Shapes last until the next clear, once per simulation step, so frames rendered between
+// steps still show them
+// Disabled, every call returns before touching the stream, which is only allocated once
+// something is drawn
+namespace debug_draw {
+
+    auto set_enabled(bool enable) -> void;
+    [[nodiscard]] auto is_enabled() -> bool;
+
+    auto line(glm::vec2 from, glm::vec2 to, glm::vec4 color) -> void;
+    auto polyline(std::span<const glm::vec2> points, glm::vec4 color, bool closed = false)
+        -> void;
+    auto circle(
+        glm::vec2 center, float radius, glm::vec4 color,
+        Uint32 segments = defs::debug_draw::circle_segments
+    ) -> void;
+    auto aabb(glm::vec2 min, glm::vec2 max, glm::vec4 color) -> void;
+    // Letters, digits and a little punctuation, lower case is drawn upper case
+    auto label(
+        glm::vec2 position, std::string_view text, glm::vec4 color,
+        float height = defs::debug_draw::label_height
+    ) -> void;
+
+    // Line list vertex pairs drawn since the last clear, read once every writer has returned
+    [[nodiscard]] auto get_vertices() -> std::span<const defs::types::vertex::Mesh_vertex>;
+    // Lines that did not fit since the last clear
+    [[nodiscard]] auto get_dropped() -> size_t;
+
+    // Start of a simulation step, nothing may draw while it runs
+    auto clear() -> void;
+
+}    // namespace debug_draw
+
+#endif    // SDL3_GAME_DEBUG_DRAW_H
@@ -0,0 +1,202 @@
+
+
+#ifndef SDL3_GAME_GPU_DEVICE_H
+#define SDL3_GAME_GPU_DEVICE_H
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+#include <utils.h>
+
+#include <span>
+#include <string>
+
+class Resource_manager;
+
+// The SDL_gpu calls the renderer makes, one to one, so the render path can run against
+// something other than a real device (Null_gpu_device records them instead)
+// Handles stay SDL's opaque types, a backend may hand out whatever values it likes as long
+// as it recognizes them again
+// Creation and release are called from pipeline workers too, everything else from the
+// render thread only
+class Gpu_device {
+public:
+    virtual ~Gpu_device() = default;
+
+    // Resources
+    virtual auto create_buffer(const SDL_GPUBufferCreateInfo& info) -> SDL_GPUBuffer* = 0;
+    virtual auto release_buffer(SDL_GPUBuffer* buffer) -> void = 0;
+    virtual auto create_transfer_buffer(const SDL_GPUTransferBufferCreateInfo& info)
+        -> SDL_GPUTransferBuffer* = 0;
+    virtual auto release_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void = 0;
+    virtual auto map_transfer_buffer(SDL_GPUTransferBuffer* buffer, bool cycle) -> void* = 0;
+    virtual auto unmap_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void = 0;
+    virtual auto create_texture(const SDL_GPUTextureCreateInfo& info) -> SDL_GPUTexture* = 0;
+    virtual auto release_texture(SDL_GPUTexture* texture) -> void = 0;
+    virtual auto create_sampler(const SDL_GPUSamplerCreateInfo& info) -> SDL_GPUSampler* = 0;
+    virtual auto release_sampler(SDL_GPUSampler* sampler) -> void = 0;
+    virtual auto create_graphics_pipeline(const SDL_GPUGraphicsPipelineCreateInfo& info)
+        -> SDL_GPUGraphicsPipeline* = 0;
+    virtual auto release_graphics_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void = 0;
+    // Shaders come from the resource manager's files (and shader cache) on a real device
+    virtual auto create_shader(Resource_manager& resource_manager, const std::string& file_name)
+        -> utils::Result<SDL_GPUShader*> = 0;
+    virtual auto release_shader(SDL_GPUShader* shader) -> void = 0;
+    virtual auto swapchain_format() -> SDL_GPUTextureFormat = 0;
+
+    // Submission and sync
+    virtual auto acquire_command_buffer() -> SDL_GPUCommandBuffer* = 0;
+    virtual auto submit_with_fence(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUFence* = 0;
+    virtual auto wait_for_fence(SDL_GPUFence* fence) -> bool = 0;
+    virtual auto release_fence(SDL_GPUFence* fence) -> void = 0;
+    virtual auto wait_for_idle() -> bool = 0;
+    // texture is null when there is nothing to draw to (minimized)
+    virtual auto acquire_swapchain_texture(
+        SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture** texture, Uint32* width,
+        Uint32* height
+    ) -> bool = 0;
+
+    // Copy passes
+    virtual auto begin_copy_pass(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUCopyPass* = 0;
+    virtual auto end_copy_pass(SDL_GPUCopyPass* copy_pass) -> void = 0;
+    virtual auto upload_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTransferBufferLocation& source,
+        const SDL_GPUBufferRegion& destination, bool cycle
+    ) -> void = 0;
+    virtual auto upload_to_texture(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTextureTransferInfo& source,
+        const SDL_GPUTextureRegion& destination, bool cycle
+    ) -> void = 0;
+    virtual auto copy_buffer_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUBufferLocation& source,
+        const SDL_GPUBufferLocation& destination, Uint32 size, bool cycle
+    ) -> void = 0;
+
+    // Scaled copy between textures, recorded outside any pass
+    virtual auto blit_texture(SDL_GPUCommandBuffer* command_buffer, const SDL_GPUBlitInfo& info)
+        -> void = 0;
+
+    // Render passes
+    virtual auto begin_render_pass(
+        SDL_GPUCommandBuffer* command_buffer, std::span<const SDL_GPUColorTargetInfo> color_targets,
+        const SDL_GPUDepthStencilTargetInfo* depth_target
+    ) -> SDL_GPURenderPass* = 0;
+    virtual auto end_render_pass(SDL_GPURenderPass* render_pass) -> void = 0;
+    virtual auto bind_graphics_pipeline(
+        SDL_GPURenderPass* render_pass, SDL_GPUGraphicsPipeline* pipeline
+    ) -> void = 0;
+    virtual auto bind_vertex_buffer(
+        SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding
+    ) -> void = 0;
+    virtual auto bind_index_buffer(
+        SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding,
+        SDL_GPUIndexElementSize element_size
+    ) -> void = 0;
+    virtual auto bind_vertex_storage_buffer(SDL_GPURenderPass* render_pass, SDL_GPUBuffer* buffer)
+        -> void = 0;
+    virtual auto bind_fragment_sampler(
+        SDL_GPURenderPass* render_pass, const SDL_GPUTextureSamplerBinding& binding
+    ) -> void = 0;
+    virtual auto push_vertex_uniforms(
+        SDL_GPUCommandBuffer* command_buffer, Uint32 slot, const void* data, Uint32 bytes
+    ) -> void = 0;
+    virtual auto draw(
+        SDL_GPURenderPass* render_pass, Uint32 vertex_count, Uint32 instance_count,
+        Uint32 first_vertex, Uint32 first_instance
+    ) -> void = 0;
+    virtual auto draw_indexed(
+        SDL_GPURenderPass* render_pass, Uint32 index_count, Uint32 instance_count,
+        Uint32 first_index, Sint32 vertex_offset, Uint32 first_instance
+    ) -> void = 0;
+};
+
+// The real thing, forwards every call to SDL_gpu on device and presents to window
+class Sdl_gpu_device final : public Gpu_device {
+private:
+    SDL_GPUDevice* device{nullptr};
+    SDL_Window* window{nullptr};
+
+public:
+    Sdl_gpu_device(SDL_GPUDevice* gpu_device, SDL_Window* win) :
+        device{gpu_device}, window{win} {}
+
+    [[nodiscard]] auto get_device() const -> SDL_GPUDevice* { return device; }
+
+    auto create_buffer(const SDL_GPUBufferCreateInfo& info) -> SDL_GPUBuffer* override;
+    auto release_buffer(SDL_GPUBuffer* buffer) -> void override;
+    auto create_transfer_buffer(const SDL_GPUTransferBufferCreateInfo& info)
+        -> SDL_GPUTransferBuffer* override;
+    auto release_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void override;
+    auto map_transfer_buffer(SDL_GPUTransferBuffer* buffer, bool cycle) -> void* override;
+    auto unmap_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void override;
+    auto create_texture(const SDL_GPUTextureCreateInfo& info) -> SDL_GPUTexture* override;
+    auto release_texture(SDL_GPUTexture* texture) -> void override;
+    auto create_sampler(const SDL_GPUSamplerCreateInfo& info) -> SDL_GPUSampler* override;
+    auto release_sampler(SDL_GPUSampler* sampler) -> void override;
+    auto create_graphics_pipeline(const SDL_GPUGraphicsPipelineCreateInfo& info)
+        -> SDL_GPUGraphicsPipeline* override;
+    auto release_graphics_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void override;
+    auto create_shader(Resource_manager& resource_manager, const std::string& file_name)
+        -> utils::Result<SDL_GPUShader*> override;
+    auto release_shader(SDL_GPUShader* shader) -> void override;
+    auto swapchain_format() -> SDL_GPUTextureFormat override;
+
+    auto acquire_command_buffer() -> SDL_GPUCommandBuffer* override;
+    auto submit_with_fence(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUFence* override;
+    auto wait_for_fence(SDL_GPUFence* fence) -> bool override;
+    auto release_fence(SDL_GPUFence* fence) -> void override;
+    auto wait_for_idle() -> bool override;
+    auto acquire_swapchain_texture(
+        SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture** texture, Uint32* width,
+        Uint32* height
+    ) -> bool override;
+
+    auto begin_copy_pass(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUCopyPass* override;
+    auto end_copy_pass(SDL_GPUCopyPass* copy_pass) -> void override;
+    auto upload_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTransferBufferLocation& source,
+        const SDL_GPUBufferRegion& destination, bool cycle
+    ) -> void override;
+    auto upload_to_texture(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTextureTransferInfo& source,
+        const SDL_GPUTextureRegion& destination, bool cycle
+    ) -> void override;
+    auto copy_buffer_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUBufferLocation& source,
+        const SDL_GPUBufferLocation& destination, Uint32 size, bool cycle
+    ) -> void override;
+
+    auto blit_texture(SDL_GPUCommandBuffer* command_buffer, const SDL_GPUBlitInfo& info)
+        -> void override;
+
+    auto begin_render_pass(
+        SDL_GPUCommandBuffer* command_buffer, std::span<const SDL_GPUColorTargetInfo> color_targets,
+        const SDL_GPUDepthStencilTargetInfo* depth_target
+    ) -> SDL_GPURenderPass* override;
+    auto end_render_pass(SDL_GPURenderPass* render_pass) -> void override;
+    auto bind_graphics_pipeline(SDL_GPURenderPass* render_pass, SDL_GPUGraphicsPipeline* pipeline)
+        -> void override;
+    auto bind_vertex_buffer(SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding)
+        -> void override;
+    auto bind_index_buffer(
+        SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding,
+        SDL_GPUIndexElementSize element_size
+    ) -> void override;
+    auto bind_vertex_storage_buffer(SDL_GPURenderPass* render_pass, SDL_GPUBuffer* buffer)
+        -> void override;
+    auto bind_fragment_sampler(
+        SDL_GPURenderPass* render_pass, const SDL_GPUTextureSamplerBinding& binding
+    ) -> void override;
+    auto push_vertex_uniforms(
+        SDL_GPUCommandBuffer* command_buffer, Uint32 slot, const void* data, Uint32 bytes
+    ) -> void override;
+    auto draw(
+        SDL_GPURenderPass* render_pass, Uint32 vertex_count, Uint32 instance_count,
+        Uint32 first_vertex, Uint32 first_instance
+    ) -> void override;
+    auto draw_indexed(
+        SDL_GPURenderPass* render_pass, Uint32 index_count, Uint32 instance_count,
+        Uint32 first_index, Sint32 vertex_offset, Uint32 first_instance
+    ) -> void override;
+};
+
+#endif    // SDL3_GAME_GPU_DEVICE_H
@@ -5,6 +5,7 @@
 
 #include <SDL3/SDL.h>
 #include <SDL3_shadercross/SDL_shadercross.h>
+#include <gpu_device.h>
 #include <utils.h>
 
 #include <memory>
@@ -15,6 +16,7 @@ class Graphics_context {
 private:
     SDL_Window* window;
     SDL_GPUDevice* device;
+    std::unique_ptr<Sdl_gpu_device> gpu;    // what the renderer draws through
 
 public:
     auto init(int width, int height, const std::string& title) -> utils::Result<>;
@@ -22,6 +24,7 @@ public:
 
     [[nodiscard]] auto get_window() const -> SDL_Window* { return window; }
     [[nodiscard]] auto get_device() const -> SDL_GPUDevice* { return device; }
+    [[nodiscard]] auto get_gpu() const -> Gpu_device& { return *gpu; }
 
     // auto present() -> void;
 
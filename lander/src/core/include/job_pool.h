@@ -0,0 +1,73 @@
+
+
+#ifndef SDL3_GAME_JOB_POOL_H
+#define SDL3_GAME_JOB_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// A few worker threads running queued jobs in submission order
+// Jobs report back through whatever they capture, the pool only knows when it is idle
+class Job_pool {
+private:
+    std::vector<std::jthread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;    // a job or a parallel_for was queued, or the pool is stopping
+    std::condition_variable idle;    // the queue emptied and nothing is running
+    size_t running{0};
+    bool stopping{false};
+
+    // the parallel_for in progress, its indices are handed out one at a time
+    // the task is the caller's callable, run through a trampoline that knows its type
+    using Batch_call = void (*)(const void* task, size_t index);
+    const void* batch_task{nullptr};
+    Batch_call batch_call{nullptr};
+    size_t batch_count{0};
+    size_t batch_next{0};
+    size_t batch_finished{0};
+    std::condition_variable batch_done;
+
+public:
+    Job_pool() = default;
+    ~Job_pool();
+
+    Job_pool(const Job_pool&) = delete;
+    auto operator=(const Job_pool&) -> Job_pool& = delete;
+
+    // No threads runs every job inline on submit, workers are named after the pool in
+    // profiler traces
+    auto init(size_t thread_count, std::string_view name = "worker") -> void;
+    // Lets running jobs finish, queued ones are dropped
+    auto quit() -> void;
+
+    auto submit(std::function<void()> job) -> void;
+    // Blocks until every job submitted so far has finished
+    auto wait_idle() -> void;
+    // Runs task(0) .. task(count - 1) across the workers and the calling thread, returns
+    // once all of them have finished (not safe to call while the pool is quitting)
+    // The task is only referenced, never queued or wrapped, so no call allocates whatever
+    // it captures, one call at a time per pool
+    template <typename Fn>
+    auto parallel_for(const size_t count, const Fn& task) -> void {
+        run_parallel(count, &task, [](const void* context, const size_t index) {
+            (*static_cast<const Fn*>(context))(index);
+        });
+    }
+
+    [[nodiscard]] auto thread_count() const -> size_t { return workers.size(); }
+
+private:
+    auto run_parallel(size_t count, const void* task, Batch_call call) -> void;
+    auto work() -> void;
+    // Runs batch indices until none are left, with the mutex held on entry and exit
+    auto run_batch(std::unique_lock<std::mutex>& lock) -> void;
+};
+
+#endif    // SDL3_GAME_JOB_POOL_H
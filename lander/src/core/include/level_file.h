@@ -0,0 +1,109 @@
+
+
+#ifndef SDL3_GAME_LEVEL_FILE_H
+#define SDL3_GAME_LEVEL_FILE_H
+
+#include <SDL3/SDL.h>
+#include <definitions.h>
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// Baked terrain levels, one file holds the terrain line, its landing zones and every lod
+// mesh ready to upload
+// Layout: header, section table, then each section 16 byte aligned so arrays can be
+// viewed in place from a mapped file, no parsing and no copies
+// All values are little endian, the same as every platform we ship on
+namespace level_file {
+
+    inline constexpr Uint32 magic{0x4C564C4C};    // "LLVL"
+    // bump on any layout change, older files are rejected and need rebaking
+    inline constexpr Uint32 version{1};
+    inline constexpr size_t section_alignment{16};
+
+    enum class Section : Uint32 {
+        Points = 0,       // glm::vec2, full resolution terrain line
+        Landing_zones,    // Zone_record
+        Anchors,          // Uint32, indices into points
+        Lods,             // Lod_record, finest first
+        Lod_indices,      // Uint32, every lod's indices back to back
+        Vertices,         // Mesh_vertex, every lod's triangle strip back to back
+        Count,
+    };
+
+    inline constexpr size_t num_sections{static_cast<size_t>(Section::Count)};
+
+    struct Section_entry {
+        Uint64 offset;    // bytes from the start of the file
+        Uint64 bytes;
+    };
+
+    struct Header {
+        Uint32 magic;
+        Uint32 version;
+        Uint32 section_count;
+        Uint32 reserved;
+        float world_width;
+        float min_height;
+        float max_height;
+        float reserved_float;
+        std::array<Section_entry, num_sections> sections;
+    };
+
+    struct Zone_record {
+        glm::vec2 start;
+        glm::vec2 end;
+        Sint32 score_value;
+    };
+
+    struct Lod_record {
+        Uint32 first_index;    // into the lod indices section
+        Uint32 index_count;
+        Uint32 first_vertex;    // into the vertices section
+        Uint32 vertex_count;
+        float max_error;
+    };
+
+    // records are read straight out of the file, their layout is the format
+    static_assert(sizeof(glm::vec2) == 8);
+    static_assert(sizeof(Zone_record) == 20);
+    static_assert(sizeof(Lod_record) == 20);
+    static_assert(sizeof(defs::types::vertex::Mesh_vertex) == 24);
+    static_assert(sizeof(Header) == 32 + num_sections * sizeof(Section_entry));
+
+    // Typed spans over a loaded file, only valid while the file stays mapped
+    struct Level_view {
+        float world_width{0.0F};
+        float min_height{0.0F};
+        float max_height{0.0F};
+
+        std::span<const glm::vec2> points;
+        std::span<const Zone_record> landing_zones;
+        std::span<const Uint32> anchors;
+        std::span<const Lod_record> lods;
+        std::span<const Uint32> lod_indices;
+        std::span<const defs::types::vertex::Mesh_vertex> vertices;
+
+        [[nodiscard]] auto lod_vertices(size_t level) const
+            -> std::span<const defs::types::vertex::Mesh_vertex>;
+        [[nodiscard]] auto lod_index_span(size_t level) const -> std::span<const Uint32>;
+
+        // Owned copy for gameplay, which edits the points (craters)
+        [[nodiscard]] auto to_terrain_data() const -> defs::types::terrain::Terrain_data;
+    };
+
+    // lod_vertices holds one triangle strip per entry of terrain_data.lods
+    auto write(
+        const std::filesystem::path& path, const defs::types::terrain::Terrain_data& terrain_data,
+        const std::vector<defs::types::vertex::Mesh_data>& lod_vertices
+    ) -> utils::Result<>;
+
+    // Validates the header and every section, then views the bytes in place
+    auto read(std::span<const std::byte> bytes) -> utils::Result<Level_view>;
+
+}    // namespace level_file
+
+#endif    // SDL3_GAME_LEVEL_FILE_H
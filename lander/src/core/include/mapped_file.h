@@ -0,0 +1,36 @@
+
+
+#ifndef SDL3_GAME_MAPPED_FILE_H
+#define SDL3_GAME_MAPPED_FILE_H
+
+#include <utils.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read only view of a whole file, pages are loaded by the os on first touch
+// Move only, the mapping is released with the object
+class Mapped_file {
+private:
+    const std::byte* data{nullptr};
+    size_t size{0};
+
+public:
+    Mapped_file() = default;
+    ~Mapped_file();
+
+    Mapped_file(const Mapped_file&) = delete;
+    auto operator=(const Mapped_file&) -> Mapped_file& = delete;
+    Mapped_file(Mapped_file&& other) noexcept;
+    auto operator=(Mapped_file&& other) noexcept -> Mapped_file&;
+
+    static auto open(const std::filesystem::path& path) -> utils::Result<Mapped_file>;
+
+    [[nodiscard]] auto bytes() const -> std::span<const std::byte> { return {data, size}; }
+
+private:
+    auto release() -> void;
+};
+
+#endif    // SDL3_GAME_MAPPED_FILE_H
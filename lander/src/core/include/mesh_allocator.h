@@ -0,0 +1,41 @@
+
+
+#ifndef SDL3_GAME_MESH_ALLOCATOR_H
+#define SDL3_GAME_MESH_ALLOCATOR_H
+
+#include <SDL3/SDL.h>
+#include <utils.h>
+
+#include <vector>
+
+// Suballocates vertex slots out of one shared buffer, first fit over a free list
+// kept sorted by position, neighbouring ranges merge again when freed
+// Only bookkeeping, the gpu buffer itself belongs to the renderer
+class Mesh_allocator {
+private:
+    struct Range {
+        Uint32 first;
+        Uint32 count;
+    };
+
+    std::vector<Range> free_ranges;    // sorted by first, never touching
+    Uint32 capacity{0};
+    Uint32 used{0};
+
+public:
+    Mesh_allocator() = default;
+    explicit Mesh_allocator(const Uint32 slots) { grow(slots); }
+
+    // First slot of count consecutive free slots, fails when no free range is big enough
+    auto allocate(Uint32 count) -> utils::Result<Uint32>;
+    auto free(Uint32 first, Uint32 count) -> void;
+
+    // Adds slots at the end, existing allocations keep their positions
+    auto grow(Uint32 new_capacity) -> void;
+
+    [[nodiscard]] auto get_capacity() const -> Uint32 { return capacity; }
+    [[nodiscard]] auto get_used() const -> Uint32 { return used; }
+    [[nodiscard]] auto largest_free() const -> Uint32;
+};
+
+#endif    // SDL3_GAME_MESH_ALLOCATOR_H
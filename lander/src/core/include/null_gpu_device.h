@@ -0,0 +1,178 @@
+
+
+#ifndef SDL3_GAME_NULL_GPU_DEVICE_H
+#define SDL3_GAME_NULL_GPU_DEVICE_H
+
+#include <definitions.h>
+#include <gpu_device.h>
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// A gpu device with no gpu behind it, for running the renderer headless (benchmarks, checks)
+// Every call is appended to a command stream that can be inspected afterwards
+// Buffers and transfer buffers get real memory so mapped writes, uploads and buffer copies
+// land where a real device would put them, textures and pipelines are only handles
+// Fences are signalled on submit and the swapchain is always there, at a fixed size
+// Shaders are not loaded from disk at all
+class Null_gpu_device final : public Gpu_device {
+public:
+    enum class Op {
+        create_buffer,
+        release_buffer,
+        create_transfer_buffer,
+        release_transfer_buffer,
+        map_transfer_buffer,
+        create_texture,
+        release_texture,
+        create_sampler,
+        release_sampler,
+        create_pipeline,
+        release_pipeline,
+        create_shader,
+        release_shader,
+        acquire_command_buffer,
+        submit,
+        acquire_swapchain,
+        begin_copy_pass,
+        end_copy_pass,
+        upload_to_buffer,
+        upload_to_texture,
+        copy_buffer,
+        blit_texture,
+        begin_render_pass,
+        end_render_pass,
+        bind_pipeline,
+        bind_vertex_buffer,
+        bind_index_buffer,
+        bind_storage_buffer,
+        bind_sampler,
+        push_uniforms,
+        draw,
+        draw_indexed,
+        count,
+    };
+
+    // What each field means depends on the op, unused ones stay zero
+    struct Command {
+        Op op;
+        Uint64 object{0};    // handle created, released, bound or written
+        Uint32 offset{0};    // destination offset, or first vertex / index
+        Uint32 size{0};      // bytes, or vertex / index count
+        Uint32 instances{0};
+        Uint32 first_instance{0};
+        Sint32 vertex_offset{0};
+    };
+
+private:
+    mutable std::mutex mutex;    // pipeline workers create and release alongside the renderer
+    Uint64 next_handle{0x1000};
+    std::unordered_map<Uint64, std::vector<Uint8>> memory;    // buffers and transfer buffers
+    std::vector<Command> stream;
+    size_t error_count{0};    // out of range uploads, copies and unknown handles
+
+    SDL_GPUTextureFormat format{SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM};
+    Uint32 width{defs::startup::window_width};
+    Uint32 height{defs::startup::window_height};
+
+public:
+    Null_gpu_device() = default;
+    Null_gpu_device(Uint32 swapchain_width, Uint32 swapchain_height) :
+        width{swapchain_width}, height{swapchain_height} {}
+
+    [[nodiscard]] auto commands() const -> std::vector<Command>;
+    [[nodiscard]] auto count(Op op) const -> size_t;
+    [[nodiscard]] auto errors() const -> size_t;
+    // Contents of a buffer as the recorded uploads and copies left it, empty if unknown
+    [[nodiscard]] auto buffer_data(SDL_GPUBuffer* buffer) const -> std::span<const Uint8>;
+    // Forgets the recorded stream, live objects stay
+    auto clear() -> void;
+
+    auto create_buffer(const SDL_GPUBufferCreateInfo& info) -> SDL_GPUBuffer* override;
+    auto release_buffer(SDL_GPUBuffer* buffer) -> void override;
+    auto create_transfer_buffer(const SDL_GPUTransferBufferCreateInfo& info)
+        -> SDL_GPUTransferBuffer* override;
+    auto release_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void override;
+    auto map_transfer_buffer(SDL_GPUTransferBuffer* buffer, bool cycle) -> void* override;
+    auto unmap_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void override;
+    auto create_texture(const SDL_GPUTextureCreateInfo& info) -> SDL_GPUTexture* override;
+    auto release_texture(SDL_GPUTexture* texture) -> void override;
+    auto create_sampler(const SDL_GPUSamplerCreateInfo& info) -> SDL_GPUSampler* override;
+    auto release_sampler(SDL_GPUSampler* sampler) -> void override;
+    auto create_graphics_pipeline(const SDL_GPUGraphicsPipelineCreateInfo& info)
+        -> SDL_GPUGraphicsPipeline* override;
+    auto release_graphics_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void override;
+    auto create_shader(Resource_manager& resource_manager, const std::string& file_name)
+        -> utils::Result<SDL_GPUShader*> override;
+    auto release_shader(SDL_GPUShader* shader) -> void override;
+    auto swapchain_format() -> SDL_GPUTextureFormat override;
+
+    auto acquire_command_buffer() -> SDL_GPUCommandBuffer* override;
+    auto submit_with_fence(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUFence* override;
+    auto wait_for_fence(SDL_GPUFence* fence) -> bool override;
+    auto release_fence(SDL_GPUFence* fence) -> void override;
+    auto wait_for_idle() -> bool override;
+    auto acquire_swapchain_texture(
+        SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture** texture, Uint32* width,
+        Uint32* height
+    ) -> bool override;
+
+    auto begin_copy_pass(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUCopyPass* override;
+    auto end_copy_pass(SDL_GPUCopyPass* copy_pass) -> void override;
+    auto upload_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTransferBufferLocation& source,
+        const SDL_GPUBufferRegion& destination, bool cycle
+    ) -> void override;
+    auto upload_to_texture(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUTextureTransferInfo& source,
+        const SDL_GPUTextureRegion& destination, bool cycle
+    ) -> void override;
+    auto copy_buffer_to_buffer(
+        SDL_GPUCopyPass* copy_pass, const SDL_GPUBufferLocation& source,
+        const SDL_GPUBufferLocation& destination, Uint32 size, bool cycle
+    ) -> void override;
+
+    auto blit_texture(SDL_GPUCommandBuffer* command_buffer, const SDL_GPUBlitInfo& info)
+        -> void override;
+
+    auto begin_render_pass(
+        SDL_GPUCommandBuffer* command_buffer, std::span<const SDL_GPUColorTargetInfo> color_targets,
+        const SDL_GPUDepthStencilTargetInfo* depth_target
+    ) -> SDL_GPURenderPass* override;
+    auto end_render_pass(SDL_GPURenderPass* render_pass) -> void override;
+    auto bind_graphics_pipeline(SDL_GPURenderPass* render_pass, SDL_GPUGraphicsPipeline* pipeline)
+        -> void override;
+    auto bind_vertex_buffer(SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding)
+        -> void override;
+    auto bind_index_buffer(
+        SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding,
+        SDL_GPUIndexElementSize element_size
+    ) -> void override;
+    auto bind_vertex_storage_buffer(SDL_GPURenderPass* render_pass, SDL_GPUBuffer* buffer)
+        -> void override;
+    auto bind_fragment_sampler(
+        SDL_GPURenderPass* render_pass, const SDL_GPUTextureSamplerBinding& binding
+    ) -> void override;
+    auto push_vertex_uniforms(
+        SDL_GPUCommandBuffer* command_buffer, Uint32 slot, const void* data, Uint32 bytes
+    ) -> void override;
+    auto draw(
+        SDL_GPURenderPass* render_pass, Uint32 vertex_count, Uint32 instance_count,
+        Uint32 first_vertex, Uint32 first_instance
+    ) -> void override;
+    auto draw_indexed(
+        SDL_GPURenderPass* render_pass, Uint32 index_count, Uint32 instance_count,
+        Uint32 first_index, Sint32 vertex_offset, Uint32 first_instance
+    ) -> void override;
+
+private:
+    // caller holds the mutex
+    auto make_handle(Op op, Uint32 size = 0) -> Uint64;
+    auto release(Op op, const void* handle) -> void;
+    auto record(const Command& command) -> void;
+    auto memory_of(const void* handle) -> std::vector<Uint8>*;
+};
+
+#endif    // SDL3_GAME_NULL_GPU_DEVICE_H
@@ -0,0 +1,66 @@
+
+
+#ifndef SDL3_GAME_PROFILER_H
+#define SDL3_GAME_PROFILER_H
+
+#include <SDL3/SDL.h>
+#include <utils.h>
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Scoped cpu zones, recorded per thread and exported as a chrome trace (chrome://tracing
+// or ui.perfetto.dev) or summarized on screen
+// A zone costs two performance counter reads and one write into its thread's ring, no locks
+// or allocation after the thread's first zone, rings keep the most recent zones only
+// Zone names must outlive the profiler, string literals in practice
+// Built without LANDER_PROFILE the macros compile to nothing and the rest finds no zones
+namespace profiler {
+
+    inline constexpr size_t zones_per_thread{16 * 1024};
+
+    class Zone {
+    private:
+        const char* name;
+        Uint64 start;
+
+    public:
+        explicit Zone(const char* zone_name) :
+            name{zone_name}, start{SDL_GetPerformanceCounter()} {}
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        auto operator=(const Zone&) -> Zone& = delete;
+    };
+
+    struct Zone_summary {
+        std::string_view name;
+        double ms_per_frame{0.0};    // summed over every call and thread
+        double max_ms{0.0};          // longest single call
+        Uint32 calls{0};
+    };
+
+    // Names the calling thread in exported traces, costs nothing until it records a zone
+    auto set_thread_name(std::string_view name) -> void;
+
+    // Marks the start of a frame, summaries are per frame
+    auto mark_frame() -> void;
+
+    // The most expensive zones since the previous call, at most max_zones of them
+    auto summarize(size_t max_zones) -> std::vector<Zone_summary>;
+
+    // Every zone still held by the rings, as chrome trace event json
+    auto write_chrome_trace(const std::filesystem::path& path) -> utils::Result<>;
+
+}    // namespace profiler
+
+#ifdef LANDER_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) const profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif    // SDL3_GAME_PROFILER_H
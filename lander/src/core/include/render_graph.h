@@ -0,0 +1,205 @@
+
+
+#ifndef SDL3_GAME_RENDER_GRAPH_H
+#define SDL3_GAME_RENDER_GRAPH_H
+
+#include <SDL3/SDL_gpu.h>
+#include <definitions.h>
+#include <gpu_device.h>
+#include <utils.h>
+
+#include <array>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+// What a texture the graph owns looks like, transients with equal descs share pooled textures
+struct Graph_texture_desc {
+    SDL_GPUTextureFormat format{SDL_GPU_TEXTUREFORMAT_INVALID};
+    SDL_GPUTextureUsageFlags usage{0};
+    Uint32 width{0};
+    Uint32 height{0};
+
+    auto operator==(const Graph_texture_desc&) const -> bool = default;
+};
+
+// What a render pass callback records into
+struct Graph_render_context {
+    SDL_GPURenderPass* render_pass{nullptr};
+    bool pass_began{false};    // first callback of this gpu pass, nothing is bound yet
+};
+
+// The last compiled frame, logical passes merge into fewer gpu passes
+struct Graph_stats {
+    Uint32 copy_passes{0};
+    Uint32 render_passes{0};
+    Uint32 blits{0};
+    Uint32 culled_passes{0};         // declared, but nothing kept reads what they write
+    Uint32 transient_textures{0};    // declared this frame
+    Uint32 pooled_textures{0};       // actually backing them, across frames
+};
+
+// A frame's gpu work as passes that declare what they read and write, rebuilt every frame
+// compile() orders the passes by their dependencies, drops the ones nothing imported
+// depends on, merges neighbours that share attachments into one gpu pass (copies with
+// copies) and works out every attachment's load and store op from who touches it before
+// and after
+// Imported resources (the swapchain, the renderer's buffers) outlive the frame and are
+// always stored, transient textures are taken from a pool kept across frames, and two
+// transients whose lifetimes do not overlap in a frame alias the same texture
+// Declaring allocates nothing once the first frames have sized the lists
+class Render_graph {
+public:
+    using Resource = Uint32;
+    static constexpr Resource no_resource{std::numeric_limits<Uint32>::max()};
+
+    using Copy_fn = std::function<utils::Result<>(SDL_GPUCopyPass*)>;
+    using Render_fn = std::function<utils::Result<>(const Graph_render_context&)>;
+
+    // Declares what one pass touches, chained off the add functions
+    class Pass_builder {
+    private:
+        Render_graph& graph;
+        size_t pass;
+
+    public:
+        Pass_builder(Render_graph& render_graph, const size_t index) :
+            graph{render_graph}, pass{index} {}
+
+        auto read(Resource resource) -> Pass_builder&;
+        auto write(Resource resource) -> Pass_builder&;
+        // Render passes only, without a clear the target keeps what earlier passes drew
+        auto color(Resource texture, std::optional<SDL_FColor> clear = std::nullopt)
+            -> Pass_builder&;
+        auto depth(Resource texture, std::optional<float> clear = std::nullopt)
+            -> Pass_builder&;
+    };
+
+private:
+    static constexpr size_t none{std::numeric_limits<size_t>::max()};
+
+    enum class Pass_type : Uint8 { copy, render, blit };
+
+    struct Attachment {
+        Resource texture{no_resource};
+        bool clear{false};
+        SDL_FColor clear_color{};
+        float clear_depth{1.0F};
+    };
+
+    struct Pass {
+        const char* name{""};
+        Pass_type type{Pass_type::copy};
+        Copy_fn copy;
+        Render_fn render;
+        Attachment color{};
+        Attachment depth{};
+        // blits read the first and write the second
+        std::array<Resource, defs::render_graph::max_pass_reads> reads{};
+        std::array<Resource, defs::render_graph::max_pass_reads> writes{};
+        Uint32 read_count{0};
+        Uint32 write_count{0};
+        SDL_GPUFilter filter{SDL_GPU_FILTER_LINEAR};
+
+        // compile
+        Uint64 depends_on{0};    // passes that have to run first, by bit
+        Uint64 reads_from{0};    // the subset whose results it reads
+        bool live{false};
+    };
+
+    struct Resource_info {
+        SDL_GPUTexture* texture{nullptr};
+        SDL_GPUBuffer* buffer{nullptr};
+        Graph_texture_desc desc{};
+        bool imported{false};
+
+        // compile
+        size_t last_writer{none};
+        Uint64 readers{0};    // since the last write
+        size_t first_group{none};
+        size_t last_group{none};
+        bool cycle{false};    // first use of its pooled texture this frame
+    };
+
+    // A transient texture kept across frames
+    struct Pool_entry {
+        Graph_texture_desc desc{};
+        SDL_GPUTexture* texture{nullptr};
+        Uint64 last_frame{0};
+        size_t busy_until{0};    // last group using it this frame
+    };
+
+    // Consecutive scheduled passes recorded as one gpu pass (or one blit)
+    struct Group {
+        Pass_type type{Pass_type::copy};
+        size_t first{0};    // into order
+        size_t count{0};
+        SDL_GPUColorTargetInfo color{};
+        SDL_GPUDepthStencilTargetInfo depth{};
+        SDL_GPUBlitInfo blit{};
+    };
+
+    Gpu_device* gpu{nullptr};
+
+    std::vector<Pass> passes;
+    std::vector<Resource_info> resources;
+    std::vector<size_t> order;    // live passes, in recording order
+    std::vector<Group> groups;
+    std::vector<Pool_entry> pool;
+    Uint64 frame_number{0};
+    bool compiled{false};
+    std::string declare_error;    // first misuse while declaring, reported by compile
+    Graph_stats stats{};
+
+public:
+    auto init(Gpu_device& gpu_device) -> void;
+    // Releases the pooled textures, the gpu must be done with them
+    auto quit() -> void;
+
+    // Forgets the last frame's passes and resources, the pool stays
+    auto reset() -> void;
+
+    auto import_texture(SDL_GPUTexture* texture, const Graph_texture_desc& desc) -> Resource;
+    auto import_buffer(SDL_GPUBuffer* buffer) -> Resource;
+    // Only backed by a texture once compiled, and only if a kept pass uses it
+    auto create_texture(const Graph_texture_desc& desc) -> Resource;
+
+    // Passes run in an order their declarations allow, not necessarily as declared
+    auto add_copy_pass(const char* name, Copy_fn execute) -> Pass_builder;
+    auto add_render_pass(const char* name, Render_fn execute) -> Pass_builder;
+    // Scales all of source onto all of destination
+    auto add_blit_pass(
+        const char* name, Resource source, Resource destination,
+        SDL_GPUFilter filter = SDL_GPU_FILTER_LINEAR
+    ) -> void;
+
+    auto compile() -> utils::Result<>;
+    // Records the compiled frame into command_buffer, nothing when it was not compiled
+    auto execute(SDL_GPUCommandBuffer* command_buffer) -> utils::Result<>;
+
+    [[nodiscard]] auto get_stats() const -> const Graph_stats& { return stats; }
+
+private:
+    auto add_pass(const char* name, Pass_type type) -> Pass&;
+    auto fail(std::string message) -> void;
+    [[nodiscard]] auto valid(Resource resource) const -> bool;
+
+    // Calls access(resource, written) for everything pass touches, reads first
+    template <typename Fn>
+    static auto for_each_access(const Pass& pass, Fn&& access) -> void;
+
+    auto build_dependencies() -> utils::Result<>;
+    auto cull() -> void;
+    auto schedule() -> void;
+    [[nodiscard]] auto can_merge(const Pass& previous, const Pass& next) const -> bool;
+    auto build_groups() -> void;
+    auto allocate_transients() -> utils::Result<>;
+    auto resolve_ops() -> void;
+
+    auto record_group(SDL_GPUCommandBuffer* command_buffer, const Group& group)
+        -> utils::Result<>;
+};
+
+#endif    // SDL3_GAME_RENDER_GRAPH_H
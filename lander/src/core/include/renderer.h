@@ -4,27 +4,122 @@
 #define SDL3_GAME_RENDERER_H
 
 #include <SDL3/SDL_gpu.h>
+#include <gpu_device.h>
+#include <job_pool.h>
+#include <render_graph.h>
 #include <render_system.h>
+#include <mesh_allocator.h>
 #include <resource_manager.h>
+#include <sort_key.h>
+#include <upload_ring.h>
 
 #include <glm/glm/mat4x4.hpp>
+#include <glm/glm/vec2.hpp>
 #include <glm/glm/vec3.hpp>
+#include <array>
+#include <mutex>
 
-struct Buffer_handles {
-    SDL_GPUBuffer* vertex_buffer{nullptr};
-    SDL_GPUBuffer* index_buffer{nullptr};
-    SDL_GPUTransferBuffer* transfer_buffer{nullptr};
+// Where a mesh lives in the shared mesh buffer, everything a draw needs without the cpu copy
+struct Gpu_mesh {
+    Uint32 first_vertex{0};
+    Uint32 vertex_count{0};
+    Uint32 vertex_capacity{0};    // slots reserved, room to grow in place
+    Uint32 vertex_stride{sizeof(defs::types::vertex::Mesh_vertex)};    // layout of the pool
+};
+
+// A run of queued commands sharing pipeline and mesh, drawn with one instanced call when
+// the pipeline has an instanced variant, otherwise one draw per command
+struct Mesh_batch {
+    Uint32 pipeline_id{0};
+    Uint32 mesh_id{0};
+    Uint32 first_command{0};    // into its pass's sorted commands
+    Uint32 command_count{0};
+    Uint32 first_instance{0};    // into the instance buffer, instanced batches only
+    bool instanced{false};
+};
+
+// Glyphs of every text command that share an atlas page, drawn with one indexed call
+struct Text_batch {
+    SDL_GPUTexture* atlas{nullptr};
+    Uint32 first_index{0};    // into the text index buffer
+    Uint32 index_count{0};
+};
+
+// One text's glyph indices on one atlas page, already pointing into the text arena
+struct Text_run {
+    SDL_GPUTexture* atlas{nullptr};
+    std::vector<Uint32> indices;
+};
+
+// Where a text's glyphs live in the text arena, kept until the text is regenerated or
+// moved, so unchanged labels cost no upload
+struct Text_geometry {
+    Uint32 first_vertex{0};
+    Uint32 vertex_count{0};
+    Uint32 revision{0};
+    glm::mat4 model_matrix{1.0F};    // the glyphs are stored in world space
+    std::vector<Text_run> runs;
+};
+
+// One pass's mesh commands in draw order and their batches, reused every frame
+struct Mesh_pass {
+    std::vector<Render_mesh_command> commands;
+    std::vector<Mesh_batch> batches;
+    bool transparent{false};    // blended variants, far to near
+};
+
+// What a pipeline job hands back to the render thread, every variant it managed to create
+struct Built_pipeline {
+    Uint32 pipeline_id{0};
+    defs::pipelines::Type type{};
+    SDL_GPUGraphicsPipeline* pipeline{nullptr};
+    SDL_GPUGraphicsPipeline* instanced{nullptr};
+    SDL_GPUGraphicsPipeline* transparent{nullptr};
+    SDL_GPUGraphicsPipeline* transparent_instanced{nullptr};
+    std::string error;    // the base pipeline failed, nothing was created
 };
 
 struct Text_handles {
     SDL_GPUGraphicsPipeline* pipeline{nullptr};
-    SDL_GPUBuffer* vertex_buffer{nullptr};
-    SDL_GPUBuffer* index_buffer{nullptr};
-    SDL_GPUTransferBuffer* vertex_transfer_buffer{nullptr};
-    SDL_GPUTransferBuffer* index_transfer_buffer{nullptr};
     SDL_GPUSampler* sampler{nullptr};
 };
 
+struct Sprite_handles {
+    SDL_GPUGraphicsPipeline* pipeline{nullptr};
+    SDL_GPUSampler* sampler{nullptr};
+};
+
+// A buffer rewritten every frame, grown (never shrunk) when a frame needs more
+struct Dynamic_buffer {
+    SDL_GPUBuffer* buffer{nullptr};
+    size_t capacity{0};    // bytes
+};
+
+// Everything one frame in flight writes, reused only after its fence has signaled, so the
+// cpu fills one set while the gpu still reads the others and nothing has to cycle
+struct Frame_resources {
+    SDL_GPUFence* fence{nullptr};    // last submit that used this set
+    Dynamic_buffer mesh_instances{};
+    Dynamic_buffer sprites{};
+    Dynamic_buffer particles{};
+    Dynamic_buffer debug_lines{};
+    // mesh and text arena slots freed while this set was open, returned to their
+    // allocators once the fence shows no draw can still read them
+    std::vector<std::pair<Uint32, Uint32>> freed_mesh_slots;    // first vertex, count
+    std::vector<std::pair<Uint32, Uint32>> freed_text_slots;
+};
+
+// Gpu calls issued in one frame, to see what batching and bind elimination buy
+struct Render_stats {
+    Uint32 draws{0};
+    Uint32 pipeline_binds{0};
+    Uint32 buffer_binds{0};    // vertex, index and storage
+    Uint32 texture_binds{0};
+    Uint32 uniform_pushes{0};
+    Uint32 render_passes{0};    // after the render graph merged what it could
+    Uint32 copy_passes{0};
+};
+
 struct Frame_context {
     SDL_GPUCommandBuffer* command_buffer{nullptr};
     SDL_GPURenderPass* render_pass{nullptr};
@@ -33,6 +128,15 @@ struct Frame_context {
     Uint32 height{0};
     defs::types::camera::Frame_data frame_data{};
 
+    // what the render pass has bound, so repeated binds can be skipped
+    SDL_GPUGraphicsPipeline* bound_pipeline{nullptr};
+    SDL_GPUBuffer* bound_vertex_buffer{nullptr};
+    SDL_GPUBuffer* bound_index_buffer{nullptr};
+    SDL_GPUIndexElementSize bound_index_size{SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    SDL_GPUBuffer* bound_storage_buffer{nullptr};
+    SDL_GPUTexture* bound_texture{nullptr};
+    Render_stats stats{};
+
     auto reset() -> void {
         command_buffer = nullptr;
         render_pass = nullptr;
@@ -40,84 +144,263 @@ struct Frame_context {
         height = 0;
         swapchain_texture = nullptr;
         frame_data = {};
+        reset_bindings();
+        stats = {};
+    }
+
+    // a new render pass starts with nothing bound
+    auto reset_bindings() -> void {
+        bound_pipeline = nullptr;
+        bound_vertex_buffer = nullptr;
+        bound_index_buffer = nullptr;
+        bound_index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+        bound_storage_buffer = nullptr;
+        bound_texture = nullptr;
     }
 };
 
 class Renderer {
 private:
     // External references
-    SDL_GPUDevice* device{nullptr};
-    SDL_Window* window{nullptr};
+    Gpu_device* gpu{nullptr};
     Resource_manager* resource_manager{nullptr};
 
     // Owned resources
     Uint32 next_pipeline_id{1};
     Uint32 next_buffer_id{1};
     Uint32 next_sampler_id{1};
+    Uint32 next_texture_id{1};
     std::unordered_map<Uint32, SDL_GPUGraphicsPipeline*> pipelines;
     std::unordered_map<Uint32, SDL_GPUBuffer*> vertex_buffers;
     std::unordered_map<Uint32, SDL_GPUBuffer*> index_buffers;
-    std::unordered_map<Uint32, SDL_GPUTransferBuffer*> transfer_buffers;
     std::unordered_map<Uint32, SDL_GPUSampler*> samplers;
+    std::unordered_map<Uint32, SDL_GPUTexture*> textures;
+
+    // Every mesh shares one vertex buffer, suballocated in vertex slots
+    SDL_GPUBuffer* mesh_vertex_buffer{nullptr};
+    Uint32 mesh_vertex_buffer_id{0};
+    Mesh_allocator mesh_allocator{};
+    std::unordered_map<Uint32, Gpu_mesh> gpu_meshes;    // mesh_id -> slot in the pool
 
-    // GPU resource IDs
-    std::unordered_map<Uint32, Buffer_handles> mesh_to_buffers;    // mesh_id -> buffer ptrs
+    // Pipeline variants by pipeline_id, the base pipeline draws when one is missing
+    std::unordered_map<Uint32, SDL_GPUGraphicsPipeline*> instanced_pipelines;
+    std::unordered_map<Uint32, SDL_GPUGraphicsPipeline*> transparent_pipelines;
+    std::unordered_map<Uint32, SDL_GPUGraphicsPipeline*> transparent_instanced_pipelines;
 
-    // Text resources
+    // Pipelines are built on worker threads and wait in built_pipelines until the render
+    // thread collects them, draws whose pipeline is not ready yet are skipped
+    Job_pool pipeline_jobs;
+    std::mutex built_mutex;
+    std::vector<Built_pipeline> built_pipelines;
+    size_t pending_pipelines{0};
+    size_t failed_pipelines{0};
+    Uint64 pipelines_requested_ns{0};    // when the pending set was last empty
+
+    // Mesh commands sorted and batched per pass every frame, with the sort's buffers
+    Mesh_pass opaque_pass{};
+    Mesh_pass transparent_pass{.transparent = true};
+    std::vector<sort_key::Entry> sort_entries;
+    std::vector<sort_key::Entry> sort_scratch;
+
+    // Staging memory for every upload, flushed once per frame
+    Upload_ring upload_ring{};
+
+    // Per frame dynamic buffers and fences, frame_index is the set being recorded
+    std::array<Frame_resources, defs::pipelines::frames_in_flight> frames{};
+    size_t frame_index{0};
+
+    // Text resources, glyphs are retained in the arena and the per atlas index list is
+    // only rewritten when the set of drawn texts changes
     Text_handles text_handles{};
-    size_t text_vertex_buffer_size{0};
-    size_t text_index_buffer_size{0};
+    SDL_GPUBuffer* text_vertex_buffer{nullptr};
+    Mesh_allocator text_allocator{};
+    std::unordered_map<Uint32, Text_geometry> text_geometry;    // by text_id
+    Dynamic_buffer text_indices{};
+    std::vector<Uint32> text_layout;    // text_ids the index list was built from, in order
+    std::vector<Text_batch> text_batches;
+    SDL_GPUIndexElementSize text_index_size{SDL_GPU_INDEXELEMENTSIZE_16BIT};
+
+    // Sprite resources, particles are sprites drawn with another blend state
+    Sprite_handles sprite_handles{};
+    Sprite_handles particle_handles{};
+
+    // debug_draw's lines, one vertex buffer per frame set and one draw
+    SDL_GPUGraphicsPipeline* debug_line_pipeline{nullptr};
+
+    // The frame's passes, rebuilt every frame, its pool keeps the depth and offscreen
+    // targets across frames
+    Render_graph graph{};
+    float render_scale{defs::render_graph::render_scale};
 
     // Current context
     Frame_context current_frame{};
+    Render_stats last_frame_stats{};
 
 public:
-    auto init(SDL_GPUDevice& gpu_device, SDL_Window& win, Resource_manager& res_manager)
-        -> utils::Result<>;
+    // Every gpu call goes through gpu_device, the real one or a Null_gpu_device
+    auto init(Gpu_device& gpu_device, Resource_manager& res_manager) -> utils::Result<>;
     auto quit() -> void;
 
-    // Create and store pipeline from patching a Desc template, return created pipeline's id
+    // Queue a pipeline built from patching a Desc template, return its id right away
+    // The pipeline is compiled on a worker thread and draws with it start once it is ready
     auto create_pipeline(const defs::pipelines::Desc& desc) -> utils::Result<Uint32>;
+    // Blocks until every requested pipeline is built, fails if any of them could not be
+    auto wait_for_pipelines() -> utils::Result<>;
+    [[nodiscard]] auto pipelines_pending() const -> bool { return pending_pipelines > 0; }
+
+    // Uploads an rgba image (Resource_manager::load_image) as a sampled texture, the id
+    // names its atlas in sprite batches
+    auto create_texture(const SDL_Surface& image) -> utils::Result<Uint32>;
 
     // Prepare buffers for a mesh and upload data
     auto register_mesh(Uint32 mesh_id) -> utils::Result<>;
+    // Same as register_mesh for many meshes, with one staging reservation and one submit
+    // rather than waiting for the next frame, use it for startup loads
+    auto register_meshes(std::span<const Uint32> mesh_ids) -> utils::Result<>;
     auto reregister_mesh(Uint32 mesh_id) -> utils::Result<>;
+    // Upload only [first_vertex, first_vertex + vertex_count) into the existing buffer
+    auto update_mesh_range(Uint32 mesh_id, size_t first_vertex, size_t vertex_count)
+        -> utils::Result<>;
 
     // Single call to render a frame
     auto render_frame(Render_queue& queue, const defs::types::camera::Frame_data& frame_data)
         -> utils::Result<>;
 
+    // Counters of the last submitted frame
+    [[nodiscard]] auto get_stats() const -> const Render_stats& { return last_frame_stats; }
+    // How the last frame's graph compiled
+    [[nodiscard]] auto get_graph_stats() const -> const Graph_stats& { return graph.get_stats(); }
+
+    // Fraction of the window the scene is drawn at, clamped to [min_render_scale, 1]
+    // Below 1 the scene goes to offscreen targets that a post blit scales up, the next
+    // frame picks it up
+    auto set_render_scale(float scale) -> void;
+    [[nodiscard]] auto get_render_scale() const -> float { return render_scale; }
+
 private:
     auto begin_frame(Render_queue& queue, const defs::types::camera::Frame_data& frame_data)
         -> utils::Result<>;
-    auto execute_commands(const Render_queue& queue) const -> utils::Result<>;
+    auto execute_commands() -> utils::Result<>;
     auto end_frame() -> utils::Result<>;
+    // Declares the uploads and every draw pass of the frame, what each reads and draws to
+    auto build_frame_graph(const Render_queue& queue) -> utils::Result<>;
 
-    auto render_opaque(const std::vector<Render_mesh_command>& commands) const -> utils::Result<>;
-    // auto render_transparent(const std::vector<Render_mesh_command>& commands) -> utils::Result<>;
+    auto render_meshes(const Mesh_pass& pass) -> utils::Result<>;
     // auto render_ui(const std::vector<Render_ui_command>& commands) -> utils::Result<>;
-    auto render_text(const std::vector<Render_text_command>& commands) const -> utils::Result<>;
+    auto render_text() -> utils::Result<>;
+    auto render_sprites(const std::vector<Render_sprite_batch>& batches) -> utils::Result<>;
+    auto render_particles(const std::vector<Render_particle_batch>& batches) -> utils::Result<>;
+    auto render_debug_lines(std::span<const defs::types::vertex::Mesh_vertex> vertices)
+        -> utils::Result<>;
+
+    // Points the draws at the graph's current gpu pass, forgetting the binds of the last one
+    auto enter_render_pass(const Graph_render_context& context) -> void;
+    // Render pass state changes, skipped when the same thing is already bound
+    auto bind_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void;
+    auto bind_vertex_buffer(SDL_GPUBuffer* buffer) -> void;
+    auto bind_index_buffer(SDL_GPUBuffer* buffer, SDL_GPUIndexElementSize element_size) -> void;
+    auto bind_vertex_storage_buffer(SDL_GPUBuffer* buffer) -> void;
+    auto bind_fragment_texture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler) -> void;
+    auto push_vertex_uniforms(const void* data, Uint32 bytes) -> void;
+
+    // Hands the submitted command buffer's fence to the open frame set and opens the next
+    // one, waiting only if the gpu is still reading it
+    auto advance_frame(SDL_GPUFence* fence) -> utils::Result<>;
+    [[nodiscard]] auto frame() -> Frame_resources& { return frames[frame_index]; }
+    // Grows buffer to hold at least bytes, the old contents are dropped
+    auto ensure_dynamic_buffer(
+        Dynamic_buffer& dynamic_buffer, SDL_GPUBufferUsageFlags usage, size_t bytes
+    ) -> utils::Result<>;
 
     auto prepare_text_resources() -> utils::Result<>;
-    auto create_text_vertex_buffers(size_t buffer_bytes) -> utils::Result<>;
-    auto create_text_index_buffers(size_t buffer_bytes) -> utils::Result<>;
+    // Replaces the text arena with an empty one of vertex_capacity, every text regenerates
+    auto create_text_arena(Uint32 vertex_capacity) -> utils::Result<>;
+
+    auto prepare_sprite_resources() -> utils::Result<>;
+    // Copies every batch into the sprite buffer back to back and records where each starts
+    auto upload_sprite_data(std::vector<Render_sprite_batch>& batches) -> utils::Result<>;
+
+    auto prepare_particle_resources() -> utils::Result<>;
+    // Same as upload_sprite_data, into the particle buffer
+    auto upload_particle_data(std::vector<Render_particle_batch>& batches) -> utils::Result<>;
+
+    auto prepare_debug_line_resources() -> utils::Result<>;
+    auto upload_debug_lines(std::span<const defs::types::vertex::Mesh_vertex> vertices)
+        -> utils::Result<>;
 
     auto create_vertex_buffer(size_t buffer_size) -> utils::Result<Uint32>;
     auto create_index_buffer(size_t buffer_size) -> utils::Result<Uint32>;
-    auto create_transfer_buffer(size_t buffer_size) -> utils::Result<Uint32>;
     auto create_sampler() -> utils::Result<Uint32>;
 
-    auto upload_mesh_data(
-        const Buffer_handles& buffers, const defs::types::vertex::Mesh_data& vertex_data
-    ) const -> utils::Result<>;
-    auto upload_text_data(std::vector<Render_text_command>& commands) -> utils::Result<>;
+    // Places a mesh in the pool with at least capacity slots and stages its vertices
+    auto add_gpu_mesh(
+        Uint32 mesh_id, std::span<const defs::types::vertex::Mesh_vertex> mesh_data,
+        size_t capacity = 0
+    ) -> utils::Result<>;
+    auto allocate_mesh_slots(Uint32 vertex_count) -> utils::Result<Uint32>;
+    // Reallocates the pool with room for extra_vertices more, copying it over on the gpu
+    auto grow_mesh_pool(Uint32 extra_vertices) -> utils::Result<>;
 
-    static auto make_glyph_vertices(const TTF_GPUAtlasDrawSequence& glyph)
-        -> std::vector<defs::types::vertex::Textured_vertex>;
-    auto ensure_text_buffer_capacity(size_t vertex_count, size_t index_count) -> utils::Result<>;
+    auto upload_mesh_range(
+        const Gpu_mesh& gpu_mesh, std::span<const defs::types::vertex::Mesh_vertex> vertex_data,
+        size_t first_vertex, size_t vertex_count
+    ) -> utils::Result<>;
+    // Records and submits everything staged so far without waiting for a frame
+    auto submit_uploads() -> utils::Result<>;
+    // Stages glyphs only for texts that are new or changed, and the index list when the
+    // drawn texts differ from last frame
+    auto upload_text_data(const std::vector<Render_text_command>& commands) -> utils::Result<>;
+    // Writes a text's glyphs in world space into its arena slot
+    auto emit_text_geometry(const Render_text_command& command, Uint32 first_vertex)
+        -> utils::Result<>;
+    // Moves every text drawn this frame to the front of a fresh, larger arena, dropping
+    // the holes and anything no longer drawn
+    auto compact_text_arena(const std::vector<Render_text_command>& commands)
+        -> utils::Result<>;
+    // Groups the retained indices by atlas page into text_batches, switching to 32 bit
+    // indices once the arena is past what 16 bits can address
+    auto write_text_indices(const std::vector<Render_text_command>& commands)
+        -> utils::Result<>;
+    static auto count_text_vertices(const Render_text_command& command) -> Uint32;
+
+    static auto write_glyph_vertices(
+        const TTF_GPUAtlasDrawSequence& glyph, const glm::mat4& model_matrix,
+        std::span<defs::types::vertex::Textured_vertex> destination
+    ) -> void;
+
+    // Moves finished pipeline jobs into the pipeline maps, render thread only
+    auto collect_pipelines() -> void;
+    // Compiles the shaders and creates a pipeline with its variants, runs on a worker, so
+    // it only touches the gpu device and the thread safe parts of the resource manager
+    auto build_pipeline(const defs::pipelines::Desc& desc, SDL_GPUTextureFormat swapchain_format)
+        const -> utils::Result<Built_pipeline>;
+    // Same pipeline with the instanced vertex stage, fails if that shader is not shipped
+    auto create_instanced_pipeline(
+        std::string_view shader_name, const SDL_GPUGraphicsPipelineCreateInfo& create_info
+    ) const -> utils::Result<SDL_GPUGraphicsPipeline*>;
+    // Blended copies of a mesh pipeline (and its instanced variant) for the transparent pass
+    auto create_transparent_pipelines(
+        const defs::pipelines::Desc& desc, const SDL_GPUGraphicsPipelineCreateInfo& create_info,
+        Built_pipeline& built
+    ) const -> utils::Result<>;
+    // Sorts both mesh passes into batches, stages the instanced transforms of both
+    auto prepare_mesh_batches(const Render_queue& queue) -> utils::Result<>;
+    // Opaque near to far inside each batch of equal (pipeline, mesh), transparent strictly
+    // far to near with consecutive equal draws batched
+    // presorted is used instead of sorting when it holds an entry for every command
+    auto sort_mesh_pass(
+        const std::vector<Render_mesh_command>& commands,
+        std::span<const sort_key::Entry> presorted, Mesh_pass& pass, Uint32& instance_count
+    ) -> void;
+    // Picks the pipeline variant a batch of pass draws with
+    auto get_batch_pipeline(const Mesh_pass& pass, const Mesh_batch& batch) const
+        -> utils::Result<SDL_GPUGraphicsPipeline*>;
+    static auto make_mesh_instance(const Render_mesh_command& command)
+        -> defs::types::shader::Mesh_instance;
 
     auto get_pipeline(Uint32 pipeline_id) const -> utils::Result<SDL_GPUGraphicsPipeline*>;
-    auto get_buffers(Uint32 mesh_id) const -> utils::Result<const Buffer_handles*>;
+    auto get_gpu_mesh(Uint32 mesh_id) const -> utils::Result<const Gpu_mesh*>;
+    auto get_texture(Uint32 texture_id) const -> utils::Result<SDL_GPUTexture*>;
 };
 
 #endif    // SDL3_GAME_RENDERER_H
@@ -4,12 +4,17 @@
 #define SDL3_GAME_RESOURCE_MANAGER_H
 
 #include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
 #include <SDL3_mixer/SDL_mixer.h>
 #include <SDL3_shadercross/SDL_shadercross.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include <definitions.h>
+#include <level_file.h>
+#include <mapped_file.h>
+#include <shader_cache.h>
 
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -20,12 +25,21 @@ private:
     Uint32 next_mesh_id{1};
     std::unordered_map<std::string, Uint32> mesh_ids;
     std::unordered_map<Uint32, defs::types::vertex::Mesh_data> meshes;
+    // meshes that point into a mapped level file, copied into meshes on first write
+    std::unordered_map<Uint32, std::span<const defs::types::vertex::Mesh_vertex>> mesh_views;
+    std::vector<defs::types::vertex::Mesh_bounds> mesh_bounds;    // indexed by mesh id
+
+    // mapped level files, views stay valid until quit
+    std::unordered_map<std::string, Mapped_file> level_files;
+    std::unordered_map<std::string, level_file::Level_view> levels;
 
     // std::unordered_map<std::string, std::vector<Uint8>> loaded_files;
     std::unordered_map<std::string, TTF_Font*> fonts;
     std::unordered_map<std::string, MIX_Audio*> sounds;
+    std::unordered_map<std::string, SDL_Surface*> images;    // rgba, ready for gpu upload
     // maybe this should have both shaders of a pair under one key...
     std::unordered_map<std::string, SDL_GPUShader*> shaders;
+    Shader_cache shader_cache;
 
 public:
     auto init() -> utils::Result<>;
@@ -33,24 +47,66 @@ public:
 
     auto load_font(const std::string& file_name, float size) -> utils::Result<TTF_Font*>;
     auto load_sound(const std::string& file_name) -> utils::Result<MIX_Audio*>;
+    // Decodes an image with SDL_image, always converted to 8 bit rgba
+    auto load_image(const std::string& file_name) -> utils::Result<SDL_Surface*>;
     auto load_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
         -> utils::Result<SDL_GPUShader*>;
+    // Same without keeping the shader, safe to call from worker threads
+    // The caller releases it with SDL_ReleaseGPUShader
+    auto create_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
+        -> utils::Result<SDL_GPUShader*>;
+    // Maps a baked level, already loaded levels are returned as is
+    auto load_level(const std::string& file_name) -> utils::Result<const level_file::Level_view*>;
 
     auto create_mesh(const std::string& mesh_name, const defs::types::vertex::Mesh_data& vertices)
         -> utils::Result<Uint32>;
     auto update_mesh(const Uint32 mesh_id, const defs::types::vertex::Mesh_data& vertices)
         -> utils::Result<Uint32>;
+    // Replace replaced_count vertices from first_vertex with vertices, sizes may differ
+    // Returns how many vertices from first_vertex onward changed and need uploading, just
+    // the range when the sizes match, the whole tail of the mesh when they do not
+    auto update_mesh_range(
+        Uint32 mesh_id, size_t first_vertex, size_t replaced_count,
+        std::span<const defs::types::vertex::Mesh_vertex> vertices
+    ) -> utils::Result<size_t>;
+    // Meshes over memory the caller keeps alive (mapped levels), no copy is made
+    auto create_mesh_view(
+        const std::string& mesh_name, std::span<const defs::types::vertex::Mesh_vertex> vertices
+    ) -> utils::Result<Uint32>;
+    auto set_mesh_view(Uint32 mesh_id, std::span<const defs::types::vertex::Mesh_vertex> vertices)
+        -> utils::Result<Uint32>;
 
     auto get_font(const std::string& file_name) -> utils::Result<TTF_Font*>;
     auto get_sound(const std::string& file_name) -> utils::Result<MIX_Audio*>;
+    auto get_image(const std::string& file_name) -> utils::Result<SDL_Surface*>;
     auto get_shader(const std::string& file_name) -> utils::Result<SDL_GPUShader*>;
+    [[nodiscard]] auto get_shader_cache() const -> const Shader_cache& { return shader_cache; }
+
+    auto get_level(const std::string& file_name) const
+        -> utils::Result<const level_file::Level_view*>;
 
     auto get_mesh_id(const std::string& mesh_name) -> utils::Result<Uint32>;
+    // Read only access that works for owned meshes and views alike, prefer it for uploads
+    auto get_mesh_vertices(Uint32 mesh_id) const
+        -> utils::Result<std::span<const defs::types::vertex::Mesh_vertex>>;
+    // Writable access, a view is copied into an owned mesh first
     auto get_mesh_data(Uint32 mesh_id) -> utils::Result<defs::types::vertex::Mesh_data*>;
     auto get_mesh_data_copy(Uint32 mesh_id) const -> utils::Result<defs::types::vertex::Mesh_data>;
+    // Model space bounds indexed by mesh id, fitted whenever vertices are registered or
+    // replaced through this class, ids past the end have none yet
+    [[nodiscard]] auto get_mesh_bounds() const
+        -> std::span<const defs::types::vertex::Mesh_bounds> {
+        return mesh_bounds;
+    }
 
     auto release_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
         -> utils::Result<SDL_GPUShader*>;
+
+private:
+    // Grows the mesh's bounds to hold vertices, starting over when reset
+    auto fit_mesh_bounds(
+        Uint32 mesh_id, std::span<const defs::types::vertex::Mesh_vertex> vertices, bool reset
+    ) -> void;
 };
 
 #endif    // SDL3_GAME_RESOURCE_MANAGER_H
@@ -0,0 +1,82 @@
+
+
+#ifndef SDL3_GAME_SHADER_CACHE_H
+#define SDL3_GAME_SHADER_CACHE_H
+
+#include <SDL3/SDL.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+#include <utils.h>
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+
+// Backend native shaders kept on disk between runs, so a warm start creates shaders
+// straight from the cached blob without reflecting or cross compiling the spir-v
+// Entries are keyed by a hash of the spir-v and stage plus the gpu driver, shader format and
+// shadercross version, a changed shader, a different backend or an upgraded cross compiler
+// simply misses and writes a new entry
+// SDL_gpu has no pipeline cache object, pipelines are still built every launch (drivers
+// keep their own cache for those)
+// load may run on several threads at once
+class Shader_cache {
+public:
+    static constexpr Uint32 magic{0x48535443};    // "CTSH"
+    // bump on any layout change, older entries are ignored and rewritten
+    static constexpr Uint32 version{1};
+
+    struct Entry_header {
+        Uint32 magic;
+        Uint32 version;
+        Uint64 key;
+        Uint32 format;    // SDL_GPUShaderFormat
+        Uint32 stage;     // SDL_GPUShaderStage
+        Uint32 num_samplers;
+        Uint32 num_storage_textures;
+        Uint32 num_storage_buffers;
+        Uint32 num_uniform_buffers;
+        Uint64 compile_ns;    // what the miss cost, reported as saved on every hit
+        Uint64 code_bytes;
+    };
+    static_assert(sizeof(Entry_header) == 56);
+
+private:
+    std::filesystem::path directory;    // empty when the cache is disabled
+
+    mutable std::mutex stats_mutex;
+    int hits{0};
+    int misses{0};
+    Uint64 saved_ns{0};
+
+public:
+    // Creates the directory if needed, failing only disables caching
+    auto init(const std::filesystem::path& cache_directory) -> void;
+
+    // Creates the shader from its cache entry, or reflects and cross compiles it and
+    // stores the result for the next launch
+    auto load(
+        SDL_GPUDevice* gpu_device, const std::string& name, std::span<const Uint8> spirv,
+        SDL_ShaderCross_ShaderStage stage
+    ) -> utils::Result<SDL_GPUShader*>;
+
+    // One line summary of the hits and misses so far
+    auto log_stats() const -> void;
+
+    [[nodiscard]] auto hit_count() const -> int;
+    [[nodiscard]] auto miss_count() const -> int;
+
+private:
+    struct Compiled {
+        Entry_header header{};
+        void* code{nullptr};    // SDL_free'd by the caller
+    };
+
+    auto compile(
+        std::span<const Uint8> spirv, SDL_ShaderCross_ShaderStage stage, SDL_GPUShaderFormat format
+    ) -> utils::Result<Compiled>;
+    auto write_entry(const std::filesystem::path& path, const Compiled& compiled) const
+        -> utils::Result<>;
+};
+
+#endif    // SDL3_GAME_SHADER_CACHE_H
@@ -0,0 +1,97 @@
+
+
+#ifndef SDL3_GAME_UPLOAD_RING_H
+#define SDL3_GAME_UPLOAD_RING_H
+
+#include <SDL3/SDL_gpu.h>
+#include <gpu_device.h>
+#include <utils.h>
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// One persistent transfer buffer split into a partition per frame in flight
+// Uploads suballocate from the open partition and are recorded into a single copy pass
+// when the frame flushes, the renderer only reopens a partition once its frame's fence
+// has signaled
+class Upload_ring {
+public:
+    static constexpr size_t alignment{16};
+
+private:
+    struct Pending_upload {
+        SDL_GPUTransferBuffer* source{nullptr};
+        Uint32 source_offset{0};
+        SDL_GPUBuffer* destination{nullptr};
+        Uint32 destination_offset{0};
+        Uint32 size{0};
+        bool cycle{false};
+        // texture uploads replace a whole single level texture instead
+        SDL_GPUTexture* texture{nullptr};
+        Uint32 width{0};
+        Uint32 height{0};
+    };
+
+    Gpu_device* gpu{nullptr};
+    SDL_GPUTransferBuffer* transfer_buffer{nullptr};
+    std::byte* mapped{nullptr};
+    size_t capacity{0};    // bytes, whole ring
+    size_t frames_in_flight{0};
+
+    size_t partition{0};    // open partition, takes the next frame's uploads
+    size_t head{0};         // bytes used in the open partition
+
+    std::vector<Pending_upload> pending;
+    // outgrown buffers still holding pending data, released once recorded
+    std::vector<SDL_GPUTransferBuffer*> retired;
+
+    size_t peak_bytes{0};    // most bytes staged in one frame
+
+public:
+    auto init(Gpu_device* gpu_device, size_t ring_bytes, size_t frame_count) -> utils::Result<>;
+    auto quit() -> void;
+
+    // Reserves bytes in the open partition and queues a copy into destination
+    // Returns where to write, the memory is valid until the next flush
+    // cycle as in SDL_UploadToGPUBuffer, only for writes that replace everything in use
+    auto stage(SDL_GPUBuffer* destination, size_t destination_offset, size_t bytes, bool cycle)
+        -> utils::Result<std::byte*>;
+
+    // Same for a whole 2d texture, bytes are tightly packed rows of width pixels
+    auto stage_texture(SDL_GPUTexture* texture, Uint32 width, Uint32 height, size_t bytes)
+        -> utils::Result<std::byte*>;
+
+    // Makes room for bytes more in the open partition up front, so a batch of stages
+    // never grows the ring halfway through
+    auto reserve(size_t bytes) -> utils::Result<>;
+
+    // Drops queued copies into a buffer (or a byte range of it) that is about to be
+    // released or reused
+    auto discard(
+        const SDL_GPUBuffer* destination, size_t first_byte = 0,
+        size_t bytes = std::numeric_limits<size_t>::max()
+    ) -> void;
+
+    // Records every queued copy into one copy pass on command_buffer
+    auto flush(SDL_GPUCommandBuffer* command_buffer) -> utils::Result<>;
+    // Same into a copy pass someone else began, the frame's render graph
+    auto record(SDL_GPUCopyPass* copy_pass) -> void;
+    [[nodiscard]] auto has_pending() const -> bool { return not pending.empty(); }
+
+    // Opens frame's partition for new uploads, the caller has waited for the gpu to
+    // finish the last frame that used it
+    auto begin_frame(size_t frame) -> void;
+
+    [[nodiscard]] auto partition_bytes() const -> size_t { return capacity / frames_in_flight; }
+    [[nodiscard]] auto peak_frame_bytes() const -> size_t { return peak_bytes; }
+
+private:
+    // Reserves bytes in the open partition, returns their offset into the ring
+    auto allocate(size_t bytes) -> utils::Result<size_t>;
+    auto create_buffer(size_t ring_bytes) -> utils::Result<>;
+    auto grow(size_t needed_bytes) -> utils::Result<>;
+    auto unmap() -> void;
+};
+
+#endif    // SDL3_GAME_UPLOAD_RING_H
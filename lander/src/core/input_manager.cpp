@@ -1,6 +1,7 @@
 
 
 #include <input_manager.h>
+#include <profiler.h>
 
 auto Input_manager::init() -> utils::Result<> {
     input_state = std::make_unique<Input_state>();
@@ -8,6 +9,7 @@ auto Input_manager::init() -> utils::Result<> {
 }
 
 auto Input_manager::handle_input(const SDL_Event& event) -> utils::Result<> {
+    PROFILE_ZONE("Input_manager::handle_input");
 
     // switch by game state
 
@@ -27,6 +29,12 @@ auto Input_manager::handle_input(const SDL_Event& event) -> utils::Result<> {
                 case SDLK_0:
                     input_state->is_zero = true;
                     break;
+                case SDLK_C:
+                    input_state->is_c = true;
+                    break;
+                case SDLK_G:
+                    input_state->is_g = true;
+                    break;
                 default:
                     break;
             }
@@ -46,6 +54,12 @@ auto Input_manager::handle_input(const SDL_Event& event) -> utils::Result<> {
                 case SDLK_0:
                     input_state->is_zero = false;
                     break;
+                case SDLK_C:
+                    input_state->is_c = false;
+                    break;
+                case SDLK_G:
+                    input_state->is_g = false;
+                    break;
                 default:
                     break;
             }
@@ -0,0 +1,122 @@
+
+
+#include <job_pool.h>
+#include <profiler.h>
+
+#include <format>
+
+Job_pool::~Job_pool() {
+    quit();
+}
+
+auto Job_pool::init(const size_t thread_count, const std::string_view name) -> void {
+    stopping = false;
+    workers.reserve(thread_count);
+    for (size_t i{0}; i < thread_count; ++i)
+        workers.emplace_back([this, worker_name = std::format("{} {}", name, i)] {
+            profiler::set_thread_name(worker_name);
+            work();
+        });
+}
+
+auto Job_pool::quit() -> void {
+    {
+        const std::scoped_lock lock{mutex};
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+
+    // jthread joins on destruction
+    workers.clear();
+    idle.notify_all();
+}
+
+auto Job_pool::submit(std::function<void()> job) -> void {
+    // without workers the caller does the work
+    if (workers.empty()) {
+        job();
+        return;
+    }
+
+    {
+        const std::scoped_lock lock{mutex};
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+auto Job_pool::wait_idle() -> void {
+    std::unique_lock lock{mutex};
+    idle.wait(lock, [this] { return stopping || (jobs.empty() && running == 0); });
+}
+
+auto Job_pool::run_parallel(const size_t count, const void* task, const Batch_call call)
+    -> void {
+    if (workers.empty() || count < 2) {
+        for (size_t i{0}; i < count; ++i)
+            call(task, i);
+        return;
+    }
+
+    std::unique_lock lock{mutex};
+    batch_task = task;
+    batch_call = call;
+    batch_count = count;
+    batch_next = 0;
+    batch_finished = 0;
+    wake.notify_all();
+
+    // the caller takes a share instead of idling
+    run_batch(lock);
+    batch_done.wait(lock, [this] { return batch_finished == batch_count; });
+
+    batch_task = nullptr;
+    batch_call = nullptr;
+    batch_count = 0;
+    batch_next = 0;
+}
+
+auto Job_pool::run_batch(std::unique_lock<std::mutex>& lock) -> void {
+    while (batch_next < batch_count) {
+        const size_t index{batch_next++};
+        const void* task{batch_task};
+        const Batch_call call{batch_call};
+
+        lock.unlock();
+        call(task, index);
+        lock.lock();
+
+        if (++batch_finished == batch_count)
+            batch_done.notify_all();
+    }
+}
+
+auto Job_pool::work() -> void {
+    std::unique_lock lock{mutex};
+    while (true) {
+        wake.wait(lock, [this] {
+            return stopping || not jobs.empty() || batch_next < batch_count;
+        });
+        if (stopping)
+            return;
+
+        // someone is blocked in parallel_for, that comes before queued jobs
+        if (batch_next < batch_count) {
+            run_batch(lock);
+            continue;
+        }
+
+        std::function<void()> job{std::move(jobs.front())};
+        jobs.pop_front();
+        ++running;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        --running;
+        if (jobs.empty() && running == 0)
+            idle.notify_all();
+    }
+}
@@ -0,0 +1,244 @@
+
+
+#include <level_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <utility>
+
+namespace level_file {
+
+    namespace {
+
+        auto align_up(const size_t value) -> size_t {
+            return (value + section_alignment - 1) & ~(section_alignment - 1);
+        }
+
+        // Checks one section table entry and views it as a T array
+        template <typename T>
+        auto view_section(
+            const std::span<const std::byte> bytes, const Header& header, const Section section
+        ) -> utils::Result<std::span<const T>> {
+            const Section_entry& entry{header.sections[static_cast<size_t>(section)]};
+
+            if (entry.offset % section_alignment != 0 || entry.offset > bytes.size() ||
+                entry.bytes > bytes.size() - entry.offset || entry.bytes % sizeof(T) != 0)
+                return std::unexpected(
+                    std::format(
+                        "Level section {} is malformed ({}+{} of {} bytes)",
+                        static_cast<Uint32>(section), entry.offset, entry.bytes, bytes.size()
+                    )
+                );
+
+            return std::span<const T>{
+                reinterpret_cast<const T*>(bytes.data() + entry.offset), entry.bytes / sizeof(T)
+            };
+        }
+
+        // Appends a section to the file image and records it in the table
+        template <typename T>
+        auto append_section(
+            std::vector<std::byte>& image, Header& header, const Section section,
+            const std::span<const T> values
+        ) -> void {
+            const size_t offset{align_up(image.size())};
+            const size_t bytes{values.size_bytes()};
+
+            image.resize(offset + bytes);
+            if (bytes > 0)
+                std::memcpy(image.data() + offset, values.data(), bytes);
+
+            header.sections[static_cast<size_t>(section)] = {.offset = offset, .bytes = bytes};
+        }
+
+    }    // namespace
+
+    auto Level_view::lod_vertices(const size_t level) const
+        -> std::span<const defs::types::vertex::Mesh_vertex> {
+        return vertices.subspan(lods[level].first_vertex, lods[level].vertex_count);
+    }
+
+    auto Level_view::lod_index_span(const size_t level) const -> std::span<const Uint32> {
+        return lod_indices.subspan(lods[level].first_index, lods[level].index_count);
+    }
+
+    auto Level_view::to_terrain_data() const -> defs::types::terrain::Terrain_data {
+        defs::types::terrain::Terrain_data terrain_data{
+            .points = {points.begin(), points.end()},
+            .landing_zones = {},
+            .anchors = {anchors.begin(), anchors.end()},
+            .lods = {},
+            .world_width = world_width,
+            .min_height = min_height,
+            .max_height = max_height,
+        };
+
+        terrain_data.landing_zones.reserve(landing_zones.size());
+        for (const auto& [start, end, score_value] : landing_zones)
+            terrain_data.landing_zones.push_back(
+                {.start = start, .end = end, .score_value = score_value}
+            );
+
+        terrain_data.lods.reserve(lods.size());
+        for (size_t i = 0; i < lods.size(); ++i) {
+            const std::span<const Uint32> indices{lod_index_span(i)};
+            terrain_data.lods.push_back(
+                {.indices = {indices.begin(), indices.end()}, .max_error = lods[i].max_error}
+            );
+        }
+
+        return terrain_data;
+    }
+
+    auto write(
+        const std::filesystem::path& path, const defs::types::terrain::Terrain_data& terrain_data,
+        const std::vector<defs::types::vertex::Mesh_data>& lod_vertices
+    ) -> utils::Result<> {
+
+        if (lod_vertices.size() != terrain_data.lods.size())
+            return std::unexpected(
+                std::format(
+                    "Level has {} lods but {} lod meshes", terrain_data.lods.size(),
+                    lod_vertices.size()
+                )
+            );
+
+        // flatten everything that is not already a plain array
+        std::vector<Zone_record> zones{};
+        zones.reserve(terrain_data.landing_zones.size());
+        for (const auto& [start, end, score_value] : terrain_data.landing_zones)
+            zones.push_back({.start = start, .end = end, .score_value = score_value});
+
+        std::vector<Uint32> anchors{};
+        anchors.reserve(terrain_data.anchors.size());
+        for (const size_t anchor : terrain_data.anchors)
+            anchors.push_back(static_cast<Uint32>(anchor));
+
+        std::vector<Lod_record> lods{};
+        std::vector<Uint32> lod_indices{};
+        defs::types::vertex::Mesh_data vertices{};
+        for (size_t i = 0; i < terrain_data.lods.size(); ++i) {
+            lods.push_back({
+                .first_index = static_cast<Uint32>(lod_indices.size()),
+                .index_count = static_cast<Uint32>(terrain_data.lods[i].indices.size()),
+                .first_vertex = static_cast<Uint32>(vertices.size()),
+                .vertex_count = static_cast<Uint32>(lod_vertices[i].size()),
+                .max_error = terrain_data.lods[i].max_error,
+            });
+            lod_indices.insert(
+                lod_indices.end(), terrain_data.lods[i].indices.begin(),
+                terrain_data.lods[i].indices.end()
+            );
+            vertices.insert(vertices.end(), lod_vertices[i].begin(), lod_vertices[i].end());
+        }
+
+        Header header{
+            .magic = magic,
+            .version = version,
+            .section_count = static_cast<Uint32>(num_sections),
+            .reserved = 0,
+            .world_width = terrain_data.world_width,
+            .min_height = terrain_data.min_height,
+            .max_height = terrain_data.max_height,
+            .reserved_float = 0.0F,
+            .sections = {},
+        };
+
+        // build the whole image in memory, header goes in last once the table is filled
+        std::vector<std::byte> image(sizeof(Header));
+        append_section(image, header, Section::Points, std::span{terrain_data.points});
+        append_section(image, header, Section::Landing_zones, std::span{std::as_const(zones)});
+        append_section(image, header, Section::Anchors, std::span{std::as_const(anchors)});
+        append_section(image, header, Section::Lods, std::span{std::as_const(lods)});
+        append_section(image, header, Section::Lod_indices, std::span{std::as_const(lod_indices)});
+        append_section(image, header, Section::Vertices, std::span{std::as_const(vertices)});
+        std::memcpy(image.data(), &header, sizeof(Header));
+
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        if (not file)
+            return std::unexpected(std::format("Failed to create '{}'", path.string()));
+
+        file.write(
+            reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size())
+        );
+        if (not file)
+            return std::unexpected(std::format("Failed to write '{}'", path.string()));
+
+        return {};
+    }
+
+    auto read(const std::span<const std::byte> bytes) -> utils::Result<Level_view> {
+
+        if (bytes.size() < sizeof(Header))
+            return std::unexpected(std::format("Level is too small ({} bytes)", bytes.size()));
+
+        // header is tiny, copy it out rather than view it
+        Header header{};
+        std::memcpy(&header, bytes.data(), sizeof(Header));
+
+        if (header.magic != magic)
+            return std::unexpected("Not a level file");
+        if (header.version != version || header.section_count != num_sections)
+            return std::unexpected(
+                std::format(
+                    "Level version {} does not match {}, rebake levels", header.version, version
+                )
+            );
+
+        Level_view view{
+            .world_width = header.world_width,
+            .min_height = header.min_height,
+            .max_height = header.max_height,
+            .points = TRY(view_section<glm::vec2>(bytes, header, Section::Points)),
+            .landing_zones = TRY(view_section<Zone_record>(bytes, header, Section::Landing_zones)),
+            .anchors = TRY(view_section<Uint32>(bytes, header, Section::Anchors)),
+            .lods = TRY(view_section<Lod_record>(bytes, header, Section::Lods)),
+            .lod_indices = TRY(view_section<Uint32>(bytes, header, Section::Lod_indices)),
+            .vertices = TRY(view_section<defs::types::vertex::Mesh_vertex>(
+                bytes, header, Section::Vertices
+            )),
+        };
+
+        // every index has to land inside the file, checked once here so users can trust it
+        if (std::ranges::any_of(view.anchors, [&](Uint32 i) { return i >= view.points.size(); }))
+            return std::unexpected("Level anchor out of range");
+
+        // height lookups binary search the points and lods are patched in place, both
+        // assume x only grows and every lod spans the whole terrain
+        if (std::ranges::adjacent_find(view.points, [](const glm::vec2& a, const glm::vec2& b) {
+                return a.x >= b.x;
+            }) != view.points.end())
+            return std::unexpected("Level points are not in ascending x order");
+
+        for (const auto& lod : view.lods) {
+            if (size_t{lod.first_index} + lod.index_count > view.lod_indices.size() ||
+                size_t{lod.first_vertex} + lod.vertex_count > view.vertices.size())
+                return std::unexpected("Level lod range out of bounds");
+
+            // two strip vertices per kept point
+            if (size_t{lod.vertex_count} != size_t{2} * lod.index_count)
+                return std::unexpected(
+                    std::format(
+                        "Level lod has {} vertices for {} indices", lod.vertex_count,
+                        lod.index_count
+                    )
+                );
+
+            const auto indices{view.lod_indices.subspan(lod.first_index, lod.index_count)};
+            if (indices.empty() || indices.front() != 0 ||
+                indices.back() != view.points.size() - 1 ||
+                std::ranges::adjacent_find(indices, std::greater_equal{}) != indices.end())
+                return std::unexpected("Level lod indices do not ascend from first to last point");
+        }
+
+        if (std::ranges::any_of(view.lod_indices, [&](Uint32 i) {
+                return i >= view.points.size();
+            }))
+            return std::unexpected("Level lod index out of range");
+
+        return view;
+    }
+
+}    // namespace level_file
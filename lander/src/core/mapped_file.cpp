@@ -0,0 +1,111 @@
+
+
+#include <mapped_file.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+Mapped_file::~Mapped_file() {
+    release();
+}
+
+Mapped_file::Mapped_file(Mapped_file&& other) noexcept :
+    data{std::exchange(other.data, nullptr)}, size{std::exchange(other.size, 0)} {}
+
+auto Mapped_file::operator=(Mapped_file&& other) noexcept -> Mapped_file& {
+    if (this != &other) {
+        release();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+#if defined(_WIN32)
+
+auto Mapped_file::open(const std::filesystem::path& path) -> utils::Result<Mapped_file> {
+    HANDLE file{CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+    )};
+    if (file == INVALID_HANDLE_VALUE)
+        return std::unexpected(std::format("Failed to open '{}'", path.string()));
+
+    LARGE_INTEGER file_size{};
+    if (not GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return std::unexpected(std::format("'{}' is empty or unreadable", path.string()));
+    }
+
+    // the view keeps the mapping alive, so both handles can close straight away
+    HANDLE mapping{CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    CloseHandle(file);
+    if (not mapping)
+        return std::unexpected(std::format("Failed to map '{}'", path.string()));
+
+    const void* view{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+    CloseHandle(mapping);
+    if (not view)
+        return std::unexpected(std::format("Failed to map '{}'", path.string()));
+
+    Mapped_file mapped{};
+    mapped.data = static_cast<const std::byte*>(view);
+    mapped.size = static_cast<size_t>(file_size.QuadPart);
+    return mapped;
+}
+
+auto Mapped_file::release() -> void {
+    if (data)
+        UnmapViewOfFile(data);
+    data = nullptr;
+    size = 0;
+}
+
+#else
+
+auto Mapped_file::open(const std::filesystem::path& path) -> utils::Result<Mapped_file> {
+    const int file{::open(path.c_str(), O_RDONLY)};
+    if (file < 0)
+        return std::unexpected(std::format("Failed to open '{}'", path.string()));
+
+    struct stat file_stat{};
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file);
+        return std::unexpected(std::format("'{}' is empty or unreadable", path.string()));
+    }
+
+    // the mapping holds its own reference to the file, so the descriptor can close
+    const size_t file_size{static_cast<size_t>(file_stat.st_size)};
+    void* view{mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0)};
+    ::close(file);
+    if (view == MAP_FAILED)
+        return std::unexpected(std::format("Failed to map '{}'", path.string()));
+
+    Mapped_file mapped{};
+    mapped.data = static_cast<const std::byte*>(view);
+    mapped.size = file_size;
+    return mapped;
+}
+
+auto Mapped_file::release() -> void {
+    if (data)
+        munmap(const_cast<std::byte*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,74 @@
+
+
+#include <mesh_allocator.h>
+
+#include <algorithm>
+
+auto Mesh_allocator::allocate(const Uint32 count) -> utils::Result<Uint32> {
+    if (count == 0)
+        return std::unexpected("Empty mesh allocation");
+
+    const auto it{std::ranges::find_if(free_ranges, [count](const Range& range) {
+        return range.count >= count;
+    })};
+    if (it == free_ranges.end())
+        return std::unexpected(
+            std::format("No free range of {} slots ({} of {} used)", count, used, capacity)
+        );
+
+    // take from the front so the rest of the range stays put
+    const Uint32 first{it->first};
+    it->first += count;
+    it->count -= count;
+    if (it->count == 0)
+        free_ranges.erase(it);
+
+    used += count;
+    return first;
+}
+
+auto Mesh_allocator::free(const Uint32 first, const Uint32 count) -> void {
+    if (count == 0)
+        return;
+
+    const auto next{std::ranges::lower_bound(free_ranges, first, {}, &Range::first)};
+    const auto previous{next != free_ranges.begin() ? std::prev(next) : free_ranges.end()};
+    const bool joins_previous{
+        previous != free_ranges.end() && previous->first + previous->count == first
+    };
+    const bool joins_next{next != free_ranges.end() && first + count == next->first};
+
+    if (joins_previous && joins_next) {
+        previous->count += count + next->count;
+        free_ranges.erase(next);
+    } else if (joins_previous) {
+        previous->count += count;
+    } else if (joins_next) {
+        next->first = first;
+        next->count += count;
+    } else {
+        free_ranges.insert(next, {.first = first, .count = count});
+    }
+
+    used -= count;
+}
+
+auto Mesh_allocator::grow(const Uint32 new_capacity) -> void {
+    if (new_capacity <= capacity)
+        return;
+
+    const Uint32 added{new_capacity - capacity};
+    if (not free_ranges.empty() && free_ranges.back().first + free_ranges.back().count == capacity)
+        free_ranges.back().count += added;
+    else
+        free_ranges.push_back({.first = capacity, .count = added});
+
+    capacity = new_capacity;
+}
+
+auto Mesh_allocator::largest_free() const -> Uint32 {
+    Uint32 largest{0};
+    for (const Range& range : free_ranges)
+        largest = std::max(largest, range.count);
+    return largest;
+}
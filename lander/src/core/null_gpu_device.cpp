@@ -0,0 +1,378 @@
+
+
+#include <null_gpu_device.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+    auto handle_of(const void* pointer) -> Uint64 {
+        return static_cast<Uint64>(reinterpret_cast<uintptr_t>(pointer));
+    }
+
+    template <typename T>
+    auto as_handle(const Uint64 handle) -> T* {
+        return reinterpret_cast<T*>(static_cast<uintptr_t>(handle));
+    }
+
+    // whether [offset, offset + size) fits in bytes
+    auto in_range(const std::vector<Uint8>& bytes, const Uint32 offset, const Uint32 size) -> bool {
+        return static_cast<size_t>(offset) + size <= bytes.size();
+    }
+
+}    // namespace
+
+auto Null_gpu_device::commands() const -> std::vector<Command> {
+    const std::scoped_lock lock{mutex};
+    return stream;
+}
+
+auto Null_gpu_device::count(const Op op) const -> size_t {
+    const std::scoped_lock lock{mutex};
+    return std::ranges::count(stream, op, &Command::op);
+}
+
+auto Null_gpu_device::errors() const -> size_t {
+    const std::scoped_lock lock{mutex};
+    return error_count;
+}
+
+auto Null_gpu_device::buffer_data(SDL_GPUBuffer* buffer) const -> std::span<const Uint8> {
+    const std::scoped_lock lock{mutex};
+    const auto found{memory.find(handle_of(buffer))};
+    if (found == memory.end())
+        return {};
+    return found->second;
+}
+
+auto Null_gpu_device::clear() -> void {
+    const std::scoped_lock lock{mutex};
+    stream.clear();
+    error_count = 0;
+}
+
+auto Null_gpu_device::make_handle(const Op op, const Uint32 size) -> Uint64 {
+    // keep handles aligned like real pointers, nothing ever dereferences them
+    const Uint64 handle{next_handle};
+    next_handle += 16;
+    record({.op = op, .object = handle, .size = size});
+    return handle;
+}
+
+auto Null_gpu_device::release(const Op op, const void* handle) -> void {
+    if (handle == nullptr)
+        return;
+    record({.op = op, .object = handle_of(handle)});
+}
+
+auto Null_gpu_device::record(const Command& command) -> void {
+    stream.push_back(command);
+}
+
+auto Null_gpu_device::memory_of(const void* handle) -> std::vector<Uint8>* {
+    const auto found{memory.find(handle_of(handle))};
+    if (found == memory.end()) {
+        ++error_count;
+        return nullptr;
+    }
+    return &found->second;
+}
+
+auto Null_gpu_device::create_buffer(const SDL_GPUBufferCreateInfo& info) -> SDL_GPUBuffer* {
+    const std::scoped_lock lock{mutex};
+    const Uint64 handle{make_handle(Op::create_buffer, info.size)};
+    memory[handle].resize(info.size);
+    return as_handle<SDL_GPUBuffer>(handle);
+}
+
+auto Null_gpu_device::release_buffer(SDL_GPUBuffer* buffer) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_buffer, buffer);
+    memory.erase(handle_of(buffer));
+}
+
+auto Null_gpu_device::create_transfer_buffer(const SDL_GPUTransferBufferCreateInfo& info)
+    -> SDL_GPUTransferBuffer* {
+    const std::scoped_lock lock{mutex};
+    const Uint64 handle{make_handle(Op::create_transfer_buffer, info.size)};
+    memory[handle].resize(info.size);
+    return as_handle<SDL_GPUTransferBuffer>(handle);
+}
+
+auto Null_gpu_device::release_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_transfer_buffer, buffer);
+    memory.erase(handle_of(buffer));
+}
+
+auto Null_gpu_device::map_transfer_buffer(SDL_GPUTransferBuffer* buffer, const bool cycle)
+    -> void* {
+    // uploads are applied as they are recorded, so the same memory can be handed out again
+    // whether or not the caller asked to cycle
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::map_transfer_buffer, .object = handle_of(buffer)});
+    std::vector<Uint8>* bytes{memory_of(buffer)};
+    return bytes != nullptr ? bytes->data() : nullptr;
+}
+
+auto Null_gpu_device::unmap_transfer_buffer(SDL_GPUTransferBuffer* buffer) -> void {}
+
+auto Null_gpu_device::create_texture(const SDL_GPUTextureCreateInfo& info) -> SDL_GPUTexture* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUTexture>(make_handle(Op::create_texture));
+}
+
+auto Null_gpu_device::release_texture(SDL_GPUTexture* texture) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_texture, texture);
+}
+
+auto Null_gpu_device::create_sampler(const SDL_GPUSamplerCreateInfo& info) -> SDL_GPUSampler* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUSampler>(make_handle(Op::create_sampler));
+}
+
+auto Null_gpu_device::release_sampler(SDL_GPUSampler* sampler) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_sampler, sampler);
+}
+
+auto Null_gpu_device::create_graphics_pipeline(const SDL_GPUGraphicsPipelineCreateInfo& info)
+    -> SDL_GPUGraphicsPipeline* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUGraphicsPipeline>(make_handle(Op::create_pipeline));
+}
+
+auto Null_gpu_device::release_graphics_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_pipeline, pipeline);
+}
+
+auto Null_gpu_device::create_shader(
+    Resource_manager& resource_manager, const std::string& file_name
+) -> utils::Result<SDL_GPUShader*> {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUShader>(make_handle(Op::create_shader));
+}
+
+auto Null_gpu_device::release_shader(SDL_GPUShader* shader) -> void {
+    const std::scoped_lock lock{mutex};
+    release(Op::release_shader, shader);
+}
+
+auto Null_gpu_device::swapchain_format() -> SDL_GPUTextureFormat {
+    return format;
+}
+
+auto Null_gpu_device::acquire_command_buffer() -> SDL_GPUCommandBuffer* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUCommandBuffer>(make_handle(Op::acquire_command_buffer));
+}
+
+auto Null_gpu_device::submit_with_fence(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUFence* {
+    // the work already happened while recording, so the fence is signalled from the start
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::submit, .object = handle_of(command_buffer)});
+    return as_handle<SDL_GPUFence>(next_handle += 16);
+}
+
+auto Null_gpu_device::wait_for_fence(SDL_GPUFence* fence) -> bool {
+    return true;
+}
+
+auto Null_gpu_device::release_fence(SDL_GPUFence* fence) -> void {}
+
+auto Null_gpu_device::wait_for_idle() -> bool {
+    return true;
+}
+
+auto Null_gpu_device::acquire_swapchain_texture(
+    SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture** texture, Uint32* width, Uint32* height
+) -> bool {
+    const std::scoped_lock lock{mutex};
+    *texture = as_handle<SDL_GPUTexture>(make_handle(Op::acquire_swapchain));
+    if (width != nullptr)
+        *width = this->width;
+    if (height != nullptr)
+        *height = this->height;
+    return true;
+}
+
+auto Null_gpu_device::begin_copy_pass(SDL_GPUCommandBuffer* command_buffer) -> SDL_GPUCopyPass* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPUCopyPass>(make_handle(Op::begin_copy_pass));
+}
+
+auto Null_gpu_device::end_copy_pass(SDL_GPUCopyPass* copy_pass) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::end_copy_pass, .object = handle_of(copy_pass)});
+}
+
+auto Null_gpu_device::upload_to_buffer(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUTransferBufferLocation& source,
+    const SDL_GPUBufferRegion& destination, const bool cycle
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::upload_to_buffer,
+        .object = handle_of(destination.buffer),
+        .offset = destination.offset,
+        .size = destination.size,
+    });
+
+    std::vector<Uint8>* from{memory_of(source.transfer_buffer)};
+    std::vector<Uint8>* to{memory_of(destination.buffer)};
+    if (from == nullptr || to == nullptr)
+        return;
+    if (not in_range(*from, source.offset, destination.size) ||
+        not in_range(*to, destination.offset, destination.size)) {
+        ++error_count;
+        return;
+    }
+    std::memcpy(to->data() + destination.offset, from->data() + source.offset, destination.size);
+}
+
+auto Null_gpu_device::upload_to_texture(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUTextureTransferInfo& source,
+    const SDL_GPUTextureRegion& destination, const bool cycle
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::upload_to_texture,
+        .object = handle_of(destination.texture),
+        .offset = source.offset,
+        .size = destination.w * destination.h,
+    });
+}
+
+auto Null_gpu_device::copy_buffer_to_buffer(
+    SDL_GPUCopyPass* copy_pass, const SDL_GPUBufferLocation& source,
+    const SDL_GPUBufferLocation& destination, const Uint32 size, const bool cycle
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::copy_buffer,
+        .object = handle_of(destination.buffer),
+        .offset = destination.offset,
+        .size = size,
+    });
+
+    std::vector<Uint8>* from{memory_of(source.buffer)};
+    std::vector<Uint8>* to{memory_of(destination.buffer)};
+    if (from == nullptr || to == nullptr)
+        return;
+    if (not in_range(*from, source.offset, size) || not in_range(*to, destination.offset, size)) {
+        ++error_count;
+        return;
+    }
+    // same buffer copies may overlap
+    std::memmove(to->data() + destination.offset, from->data() + source.offset, size);
+}
+
+auto Null_gpu_device::blit_texture(
+    SDL_GPUCommandBuffer* command_buffer, const SDL_GPUBlitInfo& info
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::blit_texture,
+        .object = handle_of(info.destination.texture),
+        .size = info.destination.w * info.destination.h,
+    });
+}
+
+auto Null_gpu_device::begin_render_pass(
+    SDL_GPUCommandBuffer* command_buffer,
+    const std::span<const SDL_GPUColorTargetInfo> color_targets,
+    const SDL_GPUDepthStencilTargetInfo* depth_target
+) -> SDL_GPURenderPass* {
+    const std::scoped_lock lock{mutex};
+    return as_handle<SDL_GPURenderPass>(
+        make_handle(Op::begin_render_pass, static_cast<Uint32>(color_targets.size()))
+    );
+}
+
+auto Null_gpu_device::end_render_pass(SDL_GPURenderPass* render_pass) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::end_render_pass, .object = handle_of(render_pass)});
+}
+
+auto Null_gpu_device::bind_graphics_pipeline(
+    SDL_GPURenderPass* render_pass, SDL_GPUGraphicsPipeline* pipeline
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::bind_pipeline, .object = handle_of(pipeline)});
+}
+
+auto Null_gpu_device::bind_vertex_buffer(
+    SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::bind_vertex_buffer,
+        .object = handle_of(binding.buffer),
+        .offset = binding.offset,
+    });
+}
+
+auto Null_gpu_device::bind_index_buffer(
+    SDL_GPURenderPass* render_pass, const SDL_GPUBufferBinding& binding,
+    const SDL_GPUIndexElementSize element_size
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::bind_index_buffer,
+        .object = handle_of(binding.buffer),
+        .offset = binding.offset,
+    });
+}
+
+auto Null_gpu_device::bind_vertex_storage_buffer(
+    SDL_GPURenderPass* render_pass, SDL_GPUBuffer* buffer
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::bind_storage_buffer, .object = handle_of(buffer)});
+}
+
+auto Null_gpu_device::bind_fragment_sampler(
+    SDL_GPURenderPass* render_pass, const SDL_GPUTextureSamplerBinding& binding
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::bind_sampler, .object = handle_of(binding.texture)});
+}
+
+auto Null_gpu_device::push_vertex_uniforms(
+    SDL_GPUCommandBuffer* command_buffer, const Uint32 slot, const void* data, const Uint32 bytes
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({.op = Op::push_uniforms, .offset = slot, .size = bytes});
+}
+
+auto Null_gpu_device::draw(
+    SDL_GPURenderPass* render_pass, const Uint32 vertex_count, const Uint32 instance_count,
+    const Uint32 first_vertex, const Uint32 first_instance
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::draw,
+        .offset = first_vertex,
+        .size = vertex_count,
+        .instances = instance_count,
+        .first_instance = first_instance,
+    });
+}
+
+auto Null_gpu_device::draw_indexed(
+    SDL_GPURenderPass* render_pass, const Uint32 index_count, const Uint32 instance_count,
+    const Uint32 first_index, const Sint32 vertex_offset, const Uint32 first_instance
+) -> void {
+    const std::scoped_lock lock{mutex};
+    record({
+        .op = Op::draw_indexed,
+        .offset = first_index,
+        .size = index_count,
+        .instances = instance_count,
+        .first_instance = first_instance,
+        .vertex_offset = vertex_offset,
+    });
+}
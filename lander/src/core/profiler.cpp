@@ -0,0 +1,247 @@
+
+
+#include <profiler.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+
+namespace profiler {
+
+    namespace {
+
+        // fields are atomics so the reader may race the writer, a lapped slot is detected
+        // and dropped rather than read torn
+        struct Event {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<Uint64> start{0};
+            std::atomic<Uint64> end{0};
+        };
+
+        // Written by its own thread only, read by whoever summarizes or exports
+        // claimed is bumped before a slot is overwritten and written after it is complete,
+        // a reader that saw any new field also sees the claim (seqlock style)
+        struct Thread_ring {
+            std::array<Event, zones_per_thread> events;
+            std::atomic<Uint64> claimed{0};
+            std::atomic<Uint64> written{0};
+
+            // registry mutex
+            Uint64 summarized{0};    // first zone the next summary looks at
+            std::string name;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Thread_ring>> rings;    // outlive their threads
+        };
+
+        struct Recorded {
+            const char* name;
+            Uint64 start;
+            Uint64 end;
+            size_t thread;
+        };
+
+        auto registry() -> Registry& {
+            static Registry instance;
+            return instance;
+        }
+
+        thread_local Thread_ring* local_ring{nullptr};
+        thread_local std::string local_name;    // until the thread records its first zone
+        std::atomic<Uint64> frames_since_summary{0};
+
+        auto this_ring() -> Thread_ring& {
+            if (local_ring == nullptr) {
+                Registry& reg{registry()};
+                const std::scoped_lock lock{reg.mutex};
+                auto ring{std::make_unique<Thread_ring>()};
+                ring->name = local_name.empty() ? std::format("thread {}", reg.rings.size())
+                                                : std::move(local_name);
+                local_ring = ring.get();
+                reg.rings.push_back(std::move(ring));
+            }
+            return *local_ring;
+        }
+
+        // Appends every zone the ring still holds from index from on, returns where the
+        // next read should start (registry mutex held)
+        auto read_ring(
+            const Thread_ring& ring, const size_t thread, const Uint64 from,
+            std::vector<Recorded>& out
+        ) -> Uint64 {
+            const Uint64 written{ring.written.load(std::memory_order_acquire)};
+            const Uint64 oldest{written > zones_per_thread ? written - zones_per_thread : 0};
+            const Uint64 first{std::max(from, oldest)};
+
+            const size_t copied_from{out.size()};
+            for (Uint64 i{first}; i < written; ++i) {
+                const Event& event{ring.events[i % zones_per_thread]};
+                out.push_back({
+                    .name = event.name.load(std::memory_order_relaxed),
+                    .start = event.start.load(std::memory_order_relaxed),
+                    .end = event.end.load(std::memory_order_relaxed),
+                    .thread = thread,
+                });
+            }
+
+            // slots the writer started reusing while they were copied may be torn
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const Uint64 claimed{ring.claimed.load(std::memory_order_relaxed)};
+            if (claimed > zones_per_thread && claimed - zones_per_thread > first) {
+                const Uint64 torn{
+                    std::min(claimed - zones_per_thread - first, written - first)
+                };
+                out.erase(
+                    out.begin() + static_cast<std::ptrdiff_t>(copied_from),
+                    out.begin() + static_cast<std::ptrdiff_t>(copied_from + torn)
+                );
+            }
+
+            return written;
+        }
+
+        auto json_escaped(const std::string_view text) -> std::string {
+            std::string escaped;
+            escaped.reserve(text.size());
+            for (const char c : text) {
+                if (c == '"' || c == '\\')
+                    escaped.push_back('\\');
+                escaped.push_back(c);
+            }
+            return escaped;
+        }
+
+    }    // namespace
+
+    Zone::~Zone() {
+        const Uint64 end{SDL_GetPerformanceCounter()};
+        Thread_ring& ring{this_ring()};
+
+        const Uint64 index{ring.written.load(std::memory_order_relaxed)};
+        ring.claimed.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Event& event{ring.events[index % zones_per_thread]};
+        event.name.store(name, std::memory_order_relaxed);
+        event.start.store(start, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+        ring.written.store(index + 1, std::memory_order_release);
+    }
+
+    auto set_thread_name(const std::string_view name) -> void {
+        // threads that never record a zone never get a ring
+        if (local_ring == nullptr) {
+            local_name = name;
+            return;
+        }
+        const std::scoped_lock lock{registry().mutex};
+        local_ring->name = name;
+    }
+
+    auto mark_frame() -> void {
+        frames_since_summary.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto summarize(const size_t max_zones) -> std::vector<Zone_summary> {
+        std::vector<Recorded> recorded;
+        {
+            Registry& reg{registry()};
+            const std::scoped_lock lock{reg.mutex};
+            for (size_t i{0}; i < reg.rings.size(); ++i)
+                reg.rings[i]->summarized =
+                    read_ring(*reg.rings[i], i, reg.rings[i]->summarized, recorded);
+        }
+
+        const auto frames{static_cast<double>(
+            std::max<Uint64>(frames_since_summary.exchange(0, std::memory_order_relaxed), 1)
+        )};
+        const double ms_per_tick{1000.0 / static_cast<double>(SDL_GetPerformanceFrequency())};
+
+        // literals with the same text may still differ in address across files
+        std::unordered_map<std::string_view, Zone_summary> zones;
+        for (const Recorded& zone : recorded) {
+            const double ms{static_cast<double>(zone.end - zone.start) * ms_per_tick};
+            Zone_summary& summary{zones[zone.name]};
+            summary.name = zone.name;
+            summary.ms_per_frame += ms;
+            summary.max_ms = std::max(summary.max_ms, ms);
+            ++summary.calls;
+        }
+
+        std::vector<Zone_summary> slowest;
+        slowest.reserve(zones.size());
+        for (Zone_summary& summary : zones | std::views::values) {
+            summary.ms_per_frame /= frames;
+            slowest.push_back(summary);
+        }
+        std::ranges::sort(slowest, std::ranges::greater{}, &Zone_summary::ms_per_frame);
+        if (slowest.size() > max_zones)
+            slowest.resize(max_zones);
+
+        return slowest;
+    }
+
+    auto write_chrome_trace(const std::filesystem::path& path) -> utils::Result<> {
+        std::vector<Recorded> recorded;
+        std::vector<std::string> thread_names;
+        {
+            Registry& reg{registry()};
+            const std::scoped_lock lock{reg.mutex};
+            for (size_t i{0}; i < reg.rings.size(); ++i) {
+                read_ring(*reg.rings[i], i, 0, recorded);
+                thread_names.push_back(reg.rings[i]->name);
+            }
+        }
+
+        std::ofstream file{path, std::ios::trunc};
+        if (not file)
+            return std::unexpected(std::format("Failed to create '{}'", path.string()));
+
+        // timestamps in microseconds from the oldest zone kept
+        const double us_per_tick{1'000'000.0 / static_cast<double>(SDL_GetPerformanceFrequency())};
+        Uint64 origin{UINT64_MAX};
+        for (const Recorded& zone : recorded)
+            origin = std::min(origin, zone.start);
+
+        // thread names first, then one complete event per zone
+        file << "{\"traceEvents\":[";
+        const char* separator{"\n"};
+        for (size_t i{0}; i < thread_names.size(); ++i) {
+            file << separator
+                 << std::format(
+                        "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                        "\"args\":{{\"name\":\"{}\"}}}}",
+                        i, json_escaped(thread_names[i])
+                    );
+            separator = ",\n";
+        }
+        for (const Recorded& zone : recorded) {
+            file << separator
+                 << std::format(
+                        "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                        "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                        json_escaped(zone.name), zone.thread,
+                        static_cast<double>(zone.start - origin) * us_per_tick,
+                        static_cast<double>(zone.end - zone.start) * us_per_tick
+                    );
+            separator = ",\n";
+        }
+        file << "\n]}\n";
+
+        if (not file)
+            return std::unexpected(std::format("Failed to write '{}'", path.string()));
+
+        utils::log(std::format("Wrote {} zones to '{}'", recorded.size(), path.string()));
+        return {};
+    }
+
+}    // namespace profiler
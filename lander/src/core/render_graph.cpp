@@ -0,0 +1,509 @@
+
+
+#include <profiler.h>
+#include <render_graph.h>
+
+#include <algorithm>
+#include <span>
+
+auto Render_graph::Pass_builder::read(const Resource resource) -> Pass_builder& {
+    Pass& target{graph.passes[pass]};
+    if (not graph.valid(resource))
+        graph.fail(std::format("Pass '{}' reads an unknown resource", target.name));
+    else if (target.read_count == target.reads.size())
+        graph.fail(std::format("Pass '{}' reads too many resources", target.name));
+    else
+        target.reads[target.read_count++] = resource;
+    return *this;
+}
+
+auto Render_graph::Pass_builder::write(const Resource resource) -> Pass_builder& {
+    Pass& target{graph.passes[pass]};
+    if (not graph.valid(resource))
+        graph.fail(std::format("Pass '{}' writes an unknown resource", target.name));
+    else if (target.write_count == target.writes.size())
+        graph.fail(std::format("Pass '{}' writes too many resources", target.name));
+    else
+        target.writes[target.write_count++] = resource;
+    return *this;
+}
+
+auto Render_graph::Pass_builder::color(
+    const Resource texture, const std::optional<SDL_FColor> clear
+) -> Pass_builder& {
+    Pass& target{graph.passes[pass]};
+    if (target.type != Pass_type::render || not graph.valid(texture) ||
+        graph.resources[texture].buffer)
+        graph.fail(std::format("Pass '{}' has no color target to draw to", target.name));
+    else
+        target.color = {
+            .texture = texture,
+            .clear = clear.has_value(),
+            .clear_color = clear.value_or(SDL_FColor{}),
+        };
+    return *this;
+}
+
+auto Render_graph::Pass_builder::depth(const Resource texture, const std::optional<float> clear)
+    -> Pass_builder& {
+    Pass& target{graph.passes[pass]};
+    if (target.type != Pass_type::render || not graph.valid(texture) ||
+        graph.resources[texture].buffer)
+        graph.fail(std::format("Pass '{}' has no depth target to draw to", target.name));
+    else
+        target.depth = {
+            .texture = texture,
+            .clear = clear.has_value(),
+            .clear_depth = clear.value_or(1.0F),
+        };
+    return *this;
+}
+
+auto Render_graph::init(Gpu_device& gpu_device) -> void {
+    gpu = &gpu_device;
+}
+
+auto Render_graph::quit() -> void {
+    reset();
+    for (const Pool_entry& entry : pool)
+        gpu->release_texture(entry.texture);
+    pool.clear();
+    stats = {};
+}
+
+auto Render_graph::reset() -> void {
+    // cleared, not freed, so the next frame's declarations reuse the storage
+    passes.clear();
+    resources.clear();
+    order.clear();
+    groups.clear();
+    declare_error.clear();
+    compiled = false;
+}
+
+auto Render_graph::import_texture(SDL_GPUTexture* texture, const Graph_texture_desc& desc)
+    -> Resource {
+    resources.push_back({.texture = texture, .desc = desc, .imported = true});
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+auto Render_graph::import_buffer(SDL_GPUBuffer* buffer) -> Resource {
+    resources.push_back({.buffer = buffer, .imported = true});
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+auto Render_graph::create_texture(const Graph_texture_desc& desc) -> Resource {
+    resources.push_back({.desc = desc});
+    return static_cast<Resource>(resources.size() - 1);
+}
+
+auto Render_graph::add_copy_pass(const char* name, Copy_fn execute) -> Pass_builder {
+    add_pass(name, Pass_type::copy).copy = std::move(execute);
+    return {*this, passes.size() - 1};
+}
+
+auto Render_graph::add_render_pass(const char* name, Render_fn execute) -> Pass_builder {
+    add_pass(name, Pass_type::render).render = std::move(execute);
+    return {*this, passes.size() - 1};
+}
+
+auto Render_graph::add_blit_pass(
+    const char* name, const Resource source, const Resource destination,
+    const SDL_GPUFilter filter
+) -> void {
+    add_pass(name, Pass_type::blit).filter = filter;
+    Pass_builder{*this, passes.size() - 1}.read(source).write(destination);
+
+    for (const Resource resource : {source, destination})
+        if (valid(resource) && resources[resource].buffer)
+            fail(std::format("Pass '{}' blits a buffer", name));
+}
+
+auto Render_graph::compile() -> utils::Result<> {
+    PROFILE_ZONE("Render_graph::compile");
+
+    compiled = false;
+    stats = {};
+    if (not declare_error.empty())
+        return std::unexpected(declare_error);
+
+    TRY(build_dependencies());
+    cull();
+    schedule();
+    build_groups();
+    TRY(allocate_transients());
+    resolve_ops();
+
+    for (const Group& group : groups) {
+        if (group.type == Pass_type::copy)
+            ++stats.copy_passes;
+        else if (group.type == Pass_type::render)
+            ++stats.render_passes;
+        else
+            ++stats.blits;
+    }
+    stats.transient_textures = static_cast<Uint32>(
+        std::ranges::count_if(resources, [](const Resource_info& info) {
+            return not info.imported;
+        })
+    );
+    stats.pooled_textures = static_cast<Uint32>(pool.size());
+
+    compiled = true;
+    return {};
+}
+
+auto Render_graph::execute(SDL_GPUCommandBuffer* command_buffer) -> utils::Result<> {
+    PROFILE_ZONE("Render_graph::execute");
+
+    if (not compiled)
+        return {};
+
+    // recorded once, a second call has nothing left to do
+    compiled = false;
+    for (const Group& group : groups)
+        TRY(record_group(command_buffer, group));
+
+    return {};
+}
+
+auto Render_graph::add_pass(const char* name, const Pass_type type) -> Pass& {
+    Pass& pass{passes.emplace_back()};
+    pass.name = name;
+    pass.type = type;
+    return pass;
+}
+
+auto Render_graph::fail(std::string message) -> void {
+    if (declare_error.empty())
+        declare_error = std::move(message);
+}
+
+auto Render_graph::valid(const Resource resource) const -> bool {
+    return resource < resources.size();
+}
+
+template <typename Fn>
+auto Render_graph::for_each_access(const Pass& pass, Fn&& access) -> void {
+    for (const Resource resource : std::span{pass.reads}.first(pass.read_count))
+        access(resource, false);
+    // an attachment that is not cleared loads what the passes before it drew
+    for (const Attachment* attachment : {&pass.color, &pass.depth})
+        if (attachment->texture != no_resource && not attachment->clear)
+            access(attachment->texture, false);
+
+    for (const Attachment* attachment : {&pass.color, &pass.depth})
+        if (attachment->texture != no_resource)
+            access(attachment->texture, true);
+    for (const Resource resource : std::span{pass.writes}.first(pass.write_count))
+        access(resource, true);
+}
+
+auto Render_graph::build_dependencies() -> utils::Result<> {
+    if (passes.size() > defs::render_graph::max_passes)
+        return std::unexpected(std::format(
+            "Render graph has {} passes, at most {}", passes.size(), defs::render_graph::max_passes
+        ));
+
+    for (Resource_info& info : resources) {
+        info.last_writer = none;
+        info.readers = 0;
+    }
+
+    for (size_t i{0}; i < passes.size(); ++i) {
+        Pass& pass{passes[i]};
+        const Uint64 bit{Uint64{1} << i};
+
+        if (pass.type == Pass_type::render) {
+            if (pass.color.texture == no_resource && pass.depth.texture == no_resource)
+                return std::unexpected(std::format("Pass '{}' has no attachments", pass.name));
+            // sampling a texture while drawing to it is undefined
+            for (const Resource resource : std::span{pass.reads}.first(pass.read_count))
+                if (resource == pass.color.texture || resource == pass.depth.texture)
+                    return std::unexpected(
+                        std::format("Pass '{}' reads its own attachment", pass.name)
+                    );
+        }
+
+        pass.depends_on = 0;
+        pass.reads_from = 0;
+        for_each_access(pass, [&](const Resource resource, const bool written) {
+            Resource_info& info{resources[resource]};
+            const Uint64 writer{
+                info.last_writer != none && info.last_writer != i ? Uint64{1} << info.last_writer
+                                                                  : 0
+            };
+            if (not written) {
+                pass.depends_on |= writer;
+                pass.reads_from |= writer;
+                info.readers |= bit;
+                return;
+            }
+
+            // after the last write and after everything that read it since
+            pass.depends_on |= writer | (info.readers & ~bit);
+            info.last_writer = i;
+            info.readers = 0;
+        });
+    }
+
+    return {};
+}
+
+auto Render_graph::cull() -> void {
+    // walking back, a pass is kept if it writes something that outlives the frame or a
+    // kept pass reads what it wrote
+    Uint64 needed{0};
+    for (size_t i{passes.size()}; i-- > 0;) {
+        Pass& pass{passes[i]};
+        bool writes_imported{false};
+        for_each_access(pass, [&](const Resource resource, const bool written) {
+            writes_imported = writes_imported || (written && resources[resource].imported);
+        });
+
+        pass.live = writes_imported || (needed & (Uint64{1} << i)) != 0;
+        if (pass.live)
+            needed |= pass.reads_from;
+        else
+            ++stats.culled_passes;
+    }
+}
+
+auto Render_graph::schedule() -> void {
+    Uint64 remaining{0};
+    for (size_t i{0}; i < passes.size(); ++i)
+        if (passes[i].live)
+            remaining |= Uint64{1} << i;
+
+    // of the passes whose dependencies have run: one that continues the current gpu pass,
+    // then copies so uploads gather in front, then declaration order
+    const Pass* previous{nullptr};
+    while (remaining != 0) {
+        size_t first_ready{none};
+        size_t first_copy{none};
+        size_t merging{none};
+        for (size_t i{0}; i < passes.size(); ++i) {
+            if ((remaining & (Uint64{1} << i)) == 0 || (passes[i].depends_on & remaining) != 0)
+                continue;
+
+            if (first_ready == none)
+                first_ready = i;
+            if (first_copy == none && passes[i].type == Pass_type::copy)
+                first_copy = i;
+            if (previous && can_merge(*previous, passes[i])) {
+                merging = i;
+                break;
+            }
+        }
+
+        const size_t next{
+            merging != none ? merging : (first_copy != none ? first_copy : first_ready)
+        };
+        order.push_back(next);
+        remaining &= ~(Uint64{1} << next);
+        previous = &passes[next];
+    }
+}
+
+auto Render_graph::can_merge(const Pass& previous, const Pass& next) const -> bool {
+    if (previous.type != next.type || next.type == Pass_type::blit)
+        return false;
+    if (next.type == Pass_type::copy)
+        return true;
+
+    // a clear can only happen as a gpu pass begins
+    return next.color.texture == previous.color.texture &&
+           next.depth.texture == previous.depth.texture && not next.color.clear &&
+           not next.depth.clear;
+}
+
+auto Render_graph::build_groups() -> void {
+    for (size_t i{0}; i < order.size(); ++i) {
+        const Pass& pass{passes[order[i]]};
+        if (i > 0 && can_merge(passes[order[i - 1]], pass)) {
+            ++groups.back().count;
+            continue;
+        }
+        groups.push_back({.type = pass.type, .first = i, .count = 1});
+    }
+
+    // lifetimes in groups, what is never touched by a kept pass gets no texture
+    for (Resource_info& info : resources) {
+        info.first_group = none;
+        info.last_group = none;
+    }
+    for (size_t g{0}; g < groups.size(); ++g)
+        for (const size_t index : std::span{order}.subspan(groups[g].first, groups[g].count))
+            for_each_access(passes[index], [&](const Resource resource, bool) {
+                Resource_info& info{resources[resource]};
+                if (info.first_group == none)
+                    info.first_group = g;
+                info.last_group = g;
+            });
+}
+
+auto Render_graph::allocate_transients() -> utils::Result<> {
+    ++frame_number;
+
+    // sdl defers the release until the gpu is done with what was submitted
+    std::erase_if(pool, [this](const Pool_entry& entry) {
+        if (frame_number - entry.last_frame < defs::render_graph::transient_idle_frames)
+            return false;
+        gpu->release_texture(entry.texture);
+        return true;
+    });
+
+    // in order of first use, so a texture freed by an earlier group is there to alias
+    for (size_t g{0}; g < groups.size(); ++g) {
+        for (Resource_info& info : resources) {
+            if (info.imported || info.first_group != g)
+                continue;
+
+            // one already used this frame but done by now, else one from an earlier frame
+            auto entry{std::ranges::find_if(pool, [&](const Pool_entry& candidate) {
+                return candidate.desc == info.desc && candidate.last_frame == frame_number &&
+                       candidate.busy_until < g;
+            })};
+            info.cycle = entry == pool.end();
+            if (entry == pool.end())
+                entry = std::ranges::find_if(pool, [&](const Pool_entry& candidate) {
+                    return candidate.desc == info.desc && candidate.last_frame != frame_number;
+                });
+
+            if (entry == pool.end()) {
+                const SDL_GPUTextureCreateInfo texture_info{
+                    .type = SDL_GPU_TEXTURETYPE_2D,
+                    .format = info.desc.format,
+                    .usage = info.desc.usage,
+                    .width = info.desc.width,
+                    .height = info.desc.height,
+                    .layer_count_or_depth = 1,
+                    .num_levels = 1,
+                };
+                SDL_GPUTexture* texture{CHECK_PTR(gpu->create_texture(texture_info))};
+                pool.push_back({.desc = info.desc, .texture = texture});
+                entry = pool.end() - 1;
+            }
+
+            entry->last_frame = frame_number;
+            entry->busy_until = info.last_group;
+            info.texture = entry->texture;
+        }
+    }
+
+    return {};
+}
+
+auto Render_graph::resolve_ops() -> void {
+    for (size_t g{0}; g < groups.size(); ++g) {
+        Group& group{groups[g]};
+        const Pass& first{passes[order[group.first]]};
+
+        // cleared, loaded when something earlier this frame (or before it, for imports)
+        // drew to it, otherwise whatever was there is not worth reading
+        const auto load_op{[&](const Attachment& attachment) {
+            const Resource_info& info{resources[attachment.texture]};
+            if (attachment.clear)
+                return SDL_GPU_LOADOP_CLEAR;
+            return info.imported || info.first_group < g ? SDL_GPU_LOADOP_LOAD
+                                                         : SDL_GPU_LOADOP_DONT_CARE;
+        }};
+        // kept when it outlives the frame or a later group uses it
+        const auto store_op{[&](const Resource resource) {
+            const Resource_info& info{resources[resource]};
+            return info.imported || info.last_group > g ? SDL_GPU_STOREOP_STORE
+                                                        : SDL_GPU_STOREOP_DONT_CARE;
+        }};
+        // a pooled texture the gpu may still be reading from the last frame is swapped
+        // for a fresh one rather than waited on, only where the old contents are unused
+        const auto cycle{[&](const Resource resource, const SDL_GPULoadOp load) {
+            const Resource_info& info{resources[resource]};
+            return info.cycle && info.first_group == g && load != SDL_GPU_LOADOP_LOAD;
+        }};
+
+        if (group.type == Pass_type::render) {
+            if (first.color.texture != no_resource) {
+                const SDL_GPULoadOp load{load_op(first.color)};
+                group.color = {
+                    .texture = resources[first.color.texture].texture,
+                    .clear_color = first.color.clear_color,
+                    .load_op = load,
+                    .store_op = store_op(first.color.texture),
+                    .cycle = cycle(first.color.texture, load),
+                };
+            }
+            if (first.depth.texture != no_resource) {
+                const SDL_GPULoadOp load{load_op(first.depth)};
+                group.depth = {
+                    .texture = resources[first.depth.texture].texture,
+                    .clear_depth = first.depth.clear_depth,
+                    .load_op = load,
+                    .store_op = store_op(first.depth.texture),
+                    .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+                    .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+                    .cycle = cycle(first.depth.texture, load),
+                };
+            }
+        }
+
+        if (group.type == Pass_type::blit) {
+            // the whole destination is overwritten, nothing in it needs loading
+            const Resource_info& source{resources[first.reads[0]]};
+            const Resource_info& destination{resources[first.writes[0]]};
+            group.blit = {
+                .source = {
+                    .texture = source.texture,
+                    .w = source.desc.width,
+                    .h = source.desc.height,
+                },
+                .destination = {
+                    .texture = destination.texture,
+                    .w = destination.desc.width,
+                    .h = destination.desc.height,
+                },
+                .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .filter = first.filter,
+                .cycle = cycle(first.writes[0], SDL_GPU_LOADOP_DONT_CARE),
+            };
+        }
+    }
+}
+
+auto Render_graph::record_group(SDL_GPUCommandBuffer* command_buffer, const Group& group)
+    -> utils::Result<> {
+    const std::span<const size_t> indices{std::span{order}.subspan(group.first, group.count)};
+
+    if (group.type == Pass_type::blit) {
+        gpu->blit_texture(command_buffer, group.blit);
+        return {};
+    }
+
+    if (group.type == Pass_type::copy) {
+        SDL_GPUCopyPass* copy_pass{CHECK_PTR(gpu->begin_copy_pass(command_buffer))};
+        for (const size_t index : indices) {
+            if (auto res{passes[index].copy(copy_pass)}; not res) {
+                gpu->end_copy_pass(copy_pass);
+                return std::unexpected(std::format("{}: {}", passes[index].name, res.error()));
+            }
+        }
+        gpu->end_copy_pass(copy_pass);
+        return {};
+    }
+
+    const std::span<const SDL_GPUColorTargetInfo> color_targets{
+        &group.color, group.color.texture ? size_t{1} : size_t{0}
+    };
+    SDL_GPURenderPass* render_pass{CHECK_PTR(gpu->begin_render_pass(
+        command_buffer, color_targets, group.depth.texture ? &group.depth : nullptr
+    ))};
+    for (size_t i{0}; i < indices.size(); ++i) {
+        const Graph_render_context context{.render_pass = render_pass, .pass_began = i == 0};
+        if (auto res{passes[indices[i]].render(context)}; not res) {
+            gpu->end_render_pass(render_pass);
+            return std::unexpected(std::format("{}: {}", passes[indices[i]].name, res.error()));
+        }
+    }
+    gpu->end_render_pass(render_pass);
+
+    return {};
+}
@@ -1,61 +1,240 @@
 
 
+#include <profiler.h>
 #include <renderer.h>
 
 #include <algorithm>
+#include <cstring>
 
-auto Renderer::init(SDL_GPUDevice& gpu_device, SDL_Window& win, Resource_manager& res_manager)
-    -> utils::Result<> {
-    device = &gpu_device;
-    window = &win;
+// x86-64 always has sse2, other targets take the scalar glyph path
+#if defined(__SSE2__) || defined(_M_X64)
+#define GLYPH_SSE2
+#include <xmmintrin.h>
+#endif
+
+auto Renderer::init(Gpu_device& gpu_device, Resource_manager& res_manager) -> utils::Result<> {
+    gpu = &gpu_device;
     resource_manager = &res_manager;
 
+    TRY(upload_ring.init(
+        gpu, defs::pipelines::upload_ring_bytes, defs::pipelines::frames_in_flight
+    ));
+    graph.init(*gpu);
+    TRY(grow_mesh_pool(defs::pipelines::mesh_pool_vertices));
+
+    for (Frame_resources& frame_set : frames)
+        TRY(ensure_dynamic_buffer(
+            frame_set.mesh_instances, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+            defs::pipelines::initial_mesh_instances * sizeof(defs::types::shader::Mesh_instance)
+        ));
+
+    // one core stays with the main thread
+    const auto spare_cores{static_cast<size_t>(std::max(SDL_GetNumLogicalCPUCores() - 1, 1))};
+    pipeline_jobs.init(std::min(spare_cores, defs::pipelines::max_pipeline_threads), "pipeline");
+
     return {};
 }
 
 auto Renderer::quit() -> void {
-    SDL_WaitForGPUIdle(device);
+    gpu->wait_for_idle();
+
+    upload_ring.quit();
+
+    // pipelines still compiling finish first, so they are released with the rest
+    pipeline_jobs.quit();
+    collect_pipelines();
+    pending_pipelines = 0;
+    failed_pipelines = 0;
 
     // clean up pipelines
     for (const auto& pipeline : pipelines | std::views::values)
         if (pipeline)
-            SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+            gpu->release_graphics_pipeline(pipeline);
     pipelines.clear();
 
+    for (auto* variants :
+         {&instanced_pipelines, &transparent_pipelines, &transparent_instanced_pipelines}) {
+        for (const auto& pipeline : *variants | std::views::values)
+            gpu->release_graphics_pipeline(pipeline);
+        variants->clear();
+    }
+
     // clean up buffers
     for (const auto& buffer : vertex_buffers | std::views::values)
         if (buffer)
-            SDL_ReleaseGPUBuffer(device, buffer);
+            gpu->release_buffer(buffer);
     vertex_buffers.clear();
 
     for (const auto& buffer : index_buffers | std::views::values)
         if (buffer)
-            SDL_ReleaseGPUBuffer(device, buffer);
+            gpu->release_buffer(buffer);
     index_buffers.clear();
 
-    for (const auto& buffer : transfer_buffers | std::views::values)
-        if (buffer)
-            SDL_ReleaseGPUTransferBuffer(device, buffer);
-    transfer_buffers.clear();
-
     // clean up samplers
     for (const auto& sampler : samplers | std::views::values)
         if (sampler)
-            SDL_ReleaseGPUSampler(device, sampler);
+            gpu->release_sampler(sampler);
     samplers.clear();
 
+    // clean up textures
+    for (const auto& texture : textures | std::views::values)
+        gpu->release_texture(texture);
+    textures.clear();
+
+    graph.quit();
+
+    // clean up frame sets, the gpu is idle so every fence has signaled
+    for (Frame_resources& frame_set : frames) {
+        if (frame_set.fence)
+            gpu->release_fence(frame_set.fence);
+        for (const Dynamic_buffer* dynamic_buffer :
+             {&frame_set.mesh_instances, &frame_set.sprites, &frame_set.particles,
+              &frame_set.debug_lines})
+            if (dynamic_buffer->buffer)
+                gpu->release_buffer(dynamic_buffer->buffer);
+        frame_set = {};
+    }
+    frame_index = 0;
+
+    if (text_vertex_buffer)
+        gpu->release_buffer(text_vertex_buffer);
+    text_vertex_buffer = nullptr;
+    if (text_indices.buffer)
+        gpu->release_buffer(text_indices.buffer);
+    text_indices = {};
+    text_geometry.clear();
+    text_layout.clear();
+    text_batches.clear();
+    text_handles = {};
+    sprite_handles = {};
+    particle_handles = {};
+    debug_line_pipeline = nullptr;
+
     // clear handle references
-    mesh_to_buffers.clear();
+    gpu_meshes.clear();
+    mesh_vertex_buffer = nullptr;
+    opaque_pass = {};
+    transparent_pass = {.transparent = true};
 }
 
 auto Renderer::create_pipeline(const defs::pipelines::Desc& desc) -> utils::Result<Uint32> {
+    // buffers and samplers do not depend on the pipeline, they are made here and now
+    if (desc.type == defs::pipelines::Type::Text)
+        TRY(prepare_text_resources());
+    if (desc.type == defs::pipelines::Type::Sprite)
+        TRY(prepare_sprite_resources());
+    if (desc.type == defs::pipelines::Type::Particle)
+        TRY(prepare_particle_resources());
+    if (desc.type == defs::pipelines::Type::Debug)
+        TRY(prepare_debug_line_resources());
+
+    // the window is only queried on this thread
+    const SDL_GPUTextureFormat swapchain_format{gpu->swapchain_format()};
+
+    const Uint32 pipeline_id{next_pipeline_id++};
+    if (pending_pipelines++ == 0)
+        pipelines_requested_ns = SDL_GetTicksNS();
+
+    pipeline_jobs.submit([this, desc, swapchain_format, pipeline_id] {
+        auto built{build_pipeline(desc, swapchain_format)};
+        Built_pipeline result{built ? std::move(*built) : Built_pipeline{.error = built.error()}};
+        result.pipeline_id = pipeline_id;
+        result.type = desc.type;
+
+        const std::scoped_lock lock{built_mutex};
+        built_pipelines.push_back(std::move(result));
+    });
+
+    return {pipeline_id};
+}
+
+auto Renderer::wait_for_pipelines() -> utils::Result<> {
+    PROFILE_ZONE("Renderer::wait_for_pipelines");
+
+    pipeline_jobs.wait_idle();
+    collect_pipelines();
+
+    if (failed_pipelines > 0)
+        return std::unexpected(std::format("{} pipelines failed to build", failed_pipelines));
+
+    return {};
+}
+
+auto Renderer::collect_pipelines() -> void {
+    PROFILE_ZONE("Renderer::collect_pipelines");
+
+    if (pending_pipelines == 0)
+        return;
+
+    std::vector<Built_pipeline> finished;
+    {
+        const std::scoped_lock lock{built_mutex};
+        finished.swap(built_pipelines);
+    }
+
+    for (const Built_pipeline& built : finished) {
+        --pending_pipelines;
+        if (not built.error.empty()) {
+            ++failed_pipelines;
+            utils::log(std::format("Pipeline {} not built: {}", built.pipeline_id, built.error));
+            continue;
+        }
+
+        // store pipeline, the variants are optional
+        pipelines[built.pipeline_id] = built.pipeline;
+        if (built.instanced)
+            instanced_pipelines[built.pipeline_id] = built.instanced;
+        if (built.transparent)
+            transparent_pipelines[built.pipeline_id] = built.transparent;
+        if (built.transparent_instanced)
+            transparent_instanced_pipelines[built.pipeline_id] = built.transparent_instanced;
+
+        // dumb workaround for identifying single text pipeline
+        if (built.type == defs::pipelines::Type::Text)
+            text_handles.pipeline = built.pipeline;
+        if (built.type == defs::pipelines::Type::Sprite)
+            sprite_handles.pipeline = built.pipeline;
+        if (built.type == defs::pipelines::Type::Particle)
+            particle_handles.pipeline = built.pipeline;
+        if (built.type == defs::pipelines::Type::Debug)
+            debug_line_pipeline = built.pipeline;
+    }
+
+    if (not finished.empty() && pending_pipelines == 0) {
+        utils::log(std::format(
+            "Pipelines ready {:.1f} ms after they were requested",
+            static_cast<double>(SDL_GetTicksNS() - pipelines_requested_ns) / 1'000'000.0
+        ));
+        resource_manager->get_shader_cache().log_stats();
+    }
+}
+
+auto Renderer::build_pipeline(
+    const defs::pipelines::Desc& desc, const SDL_GPUTextureFormat swapchain_format
+) const -> utils::Result<Built_pipeline> {
+    PROFILE_ZONE("Renderer::build_pipeline");
+
+    // DEBUG - give name to pipeline
+    const SDL_PropertiesID props{SDL_CreateProperties()};
+    if (not props)
+        return std::unexpected(SDL_GetError());
+
+    SDL_SetStringProperty(
+        props, SDL_PROP_GPU_GRAPHICSPIPELINE_CREATE_NAME_STRING,
+        std::string(desc.pipeline_debug_name).c_str()
+    );
+    // DEBUG
+
     // get runtime-dependent data
-    auto shaders{
-        TRY(defs::assets::shaders::get_shader_set_file_names(std::string(desc.shader_name)))
-    };
-    SDL_GPUShader* vert_shader{TRY(resource_manager->get_shader(shaders[0]))};
-    SDL_GPUShader* frag_shader{TRY(resource_manager->get_shader(shaders[1]))};
-    const SDL_GPUTextureFormat swapchain_format{SDL_GetGPUSwapchainTextureFormat(device, window)};
+    auto shaders{TRY(defs::assets::shaders::get_shader_set_file_names(
+        std::string(desc.shader_name), std::string(desc.fragment_shader_name)
+    ))};
+    SDL_GPUShader* vert_shader{TRY(gpu->create_shader(*resource_manager, shaders[0]))};
+    auto frag_shader{gpu->create_shader(*resource_manager, shaders[1])};
+    if (not frag_shader) {
+        gpu->release_shader(vert_shader);
+        return std::unexpected(frag_shader.error());
+    }
 
     // create mutable copy of struct array and patch it
     std::vector<SDL_GPUColorTargetDescription> color_target_descriptions(
@@ -71,123 +250,336 @@ auto Renderer::create_pipeline(const defs::pipelines::Desc& desc) -> utils::Resu
     // copy top-level creation struct and patch with runtime data
     auto create_info{desc.create_info};
     create_info.vertex_shader = vert_shader;
-    create_info.fragment_shader = frag_shader;
+    create_info.fragment_shader = *frag_shader;
     create_info.target_info = target_info;
-
-    // DEBUG - give name to pipeline
-    const SDL_PropertiesID props{SDL_CreateProperties()};
-    if (not props)
-        return std::unexpected(SDL_GetError());
-
-    SDL_SetStringProperty(
-        props, SDL_PROP_GPU_GRAPHICSPIPELINE_CREATE_NAME_STRING,
-        std::string(desc.pipeline_debug_name).c_str()
-    );
-
     create_info.props = props;
-    // DEBUG
 
     // make pipeline
-    SDL_GPUGraphicsPipeline* pipeline{CHECK_PTR(SDL_CreateGPUGraphicsPipeline(device, &create_info))
-    };
+    Built_pipeline built{.pipeline = gpu->create_graphics_pipeline(create_info)};
+    const std::string error{built.pipeline ? "" : SDL_GetError()};
+
+    // the instanced variant is optional, without it the pipeline draws per command
+    if (built.pipeline && not desc.instanced_shader_name.empty()) {
+        if (auto instanced{create_instanced_pipeline(desc.instanced_shader_name, create_info)})
+            built.instanced = *instanced;
+        else
+            utils::log(std::format(
+                "No instanced '{}' pipeline, drawing per object: {}", desc.pipeline_debug_name,
+                instanced.error()
+            ));
+    }
 
-    // release shaders
-    TRY(resource_manager->release_shader(device, shaders[0]));
-    TRY(resource_manager->release_shader(device, shaders[1]));
+    if (built.pipeline && desc.transparent_variant)
+        if (auto res = create_transparent_pipelines(desc, create_info, built); not res)
+            utils::log(std::format(
+                "No transparent '{}' pipeline, drawing it opaque: {}", desc.pipeline_debug_name,
+                res.error()
+            ));
 
-    // store and return pipeline
-    const Uint32 pipeline_id{next_pipeline_id++};
-    pipelines[pipeline_id] = pipeline;
+    // release shaders, pipelines keep what they need
+    gpu->release_shader(vert_shader);
+    gpu->release_shader(*frag_shader);
 
-    // dumb workaround for identifying single text pipeline
-    if (desc.type == defs::pipelines::Type::Text) {
-        text_handles.pipeline = pipelines[pipeline_id];
-        TRY(prepare_text_resources());
+    if (not built.pipeline)
+        return std::unexpected(
+            std::format("Failed to create '{}': {}", desc.pipeline_debug_name, error)
+        );
+
+    return built;
+}
+
+auto Renderer::create_texture(const SDL_Surface& image) -> utils::Result<Uint32> {
+    const auto width{static_cast<Uint32>(image.w)};
+    const auto height{static_cast<Uint32>(image.h)};
+
+    const SDL_GPUTextureCreateInfo texture_info{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+    };
+    SDL_GPUTexture* texture{CHECK_PTR(gpu->create_texture(texture_info))};
+
+    // staged like any other upload, it reaches the gpu with the next flush
+    const size_t row_bytes{size_t{width} * 4};
+    auto pixels{upload_ring.stage_texture(texture, width, height, row_bytes * height)};
+    if (not pixels) {
+        gpu->release_texture(texture);
+        return std::unexpected(pixels.error());
     }
 
-    return {pipeline_id};
+    // surface rows may be padded, the transfer is tightly packed
+    const auto* source{static_cast<const std::byte*>(image.pixels)};
+    for (Uint32 row{0}; row < height; ++row)
+        std::memcpy(*pixels + (row * row_bytes), source + (size_t{row} * image.pitch), row_bytes);
+
+    const Uint32 texture_id{next_texture_id++};
+    textures[texture_id] = texture;
+
+    return texture_id;
 }
 
 auto Renderer::register_mesh(const Uint32 mesh_id) -> utils::Result<> {
     // silently do not register multiple times
-    if (mesh_to_buffers.contains(mesh_id))
+    if (gpu_meshes.contains(mesh_id))
         return {};
 
-    const defs::types::vertex::Mesh_data mesh_data{*resource_manager->get_mesh_data_copy(mesh_id)};
-
-    // create buffers
-    const Uint32 buffer_size{
-        static_cast<Uint32>(mesh_data.size() * sizeof(defs::types::vertex::Mesh_vertex))
+    const std::span<const defs::types::vertex::Mesh_vertex> mesh_data{
+        TRY(resource_manager->get_mesh_vertices(mesh_id))
     };
-    const Uint32 vertex_buffer_id = TRY(create_vertex_buffer(buffer_size));
-    const Uint32 transfer_buffer_id = TRY(create_transfer_buffer(buffer_size));
+    TRY(add_gpu_mesh(mesh_id, mesh_data));
 
-    // store mappings
-    mesh_to_buffers[mesh_id] = {
-        .vertex_buffer = vertex_buffers[vertex_buffer_id],
-        .transfer_buffer = transfer_buffers[transfer_buffer_id],
-    };
+    return {};
+}
+
+auto Renderer::register_meshes(const std::span<const Uint32> mesh_ids) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::register_meshes");
 
-    // upload data and release buffers (if not using again)
-    // TODO: do i want to do this here...?
-    TRY(upload_mesh_data(mesh_to_buffers[mesh_id], mesh_data));
+    const Uint64 start{SDL_GetTicksNS()};
 
-    SDL_ReleaseGPUTransferBuffer(device, mesh_to_buffers[mesh_id].transfer_buffer);
-    mesh_to_buffers[mesh_id].transfer_buffer = nullptr;
-    transfer_buffers.erase(transfer_buffer_id);
+    // gather everything first so the staging space is known before any copy
+    std::vector<std::pair<Uint32, std::span<const defs::types::vertex::Mesh_vertex>>> batch{};
+    size_t staging_bytes{0};
+    size_t total_vertices{0};
+    for (const Uint32 mesh_id : mesh_ids) {
+        if (gpu_meshes.contains(mesh_id))
+            continue;
+
+        const std::span<const defs::types::vertex::Mesh_vertex> mesh_data{
+            TRY(resource_manager->get_mesh_vertices(mesh_id))
+        };
+        batch.emplace_back(mesh_id, mesh_data);
+        staging_bytes += mesh_data.size_bytes() + Upload_ring::alignment;
+        total_vertices += mesh_data.size();
+    }
+
+    if (batch.empty())
+        return {};
+
+    // grow the pool and the ring once for the whole batch
+    if (total_vertices > mesh_allocator.largest_free())
+        TRY(grow_mesh_pool(static_cast<Uint32>(VALID_SDL_SIZE(total_vertices))));
+    TRY(upload_ring.reserve(staging_bytes));
+
+    // place every mesh in the pool and pack its vertices back to back into the ring
+    for (const auto& [mesh_id, mesh_data] : batch)
+        TRY(add_gpu_mesh(mesh_id, mesh_data));
+
+    // one copy pass and one submit for the whole batch
+    const Uint64 submit_start{SDL_GetTicksNS()};
+    TRY(submit_uploads());
+    const Uint64 end{SDL_GetTicksNS()};
+
+    // startup used to submit after every register_mesh, a command buffer and copy pass per
+    // mesh, so the saving is estimated as this submit's cost for every mesh past the first
+    const double submit_us{static_cast<double>(end - submit_start) / 1'000.0};
+    utils::log(
+        std::format(
+            "Registered {} meshes ({} bytes) in {:.1f} us, 1 submit instead of {}, "
+            "~{:.1f} us saved at {:.1f} us per submit",
+            batch.size(), staging_bytes, static_cast<double>(end - start) / 1'000.0,
+            batch.size(), submit_us * static_cast<double>(batch.size() - 1), submit_us
+        )
+    );
 
     return {};
 }
 
 auto Renderer::reregister_mesh(Uint32 mesh_id) -> utils::Result<> {
-    if (not mesh_to_buffers.contains(mesh_id))
+    if (not gpu_meshes.contains(mesh_id))
         return {};
 
-    const defs::types::vertex::Mesh_data mesh_data{*resource_manager->get_mesh_data_copy(mesh_id)};
-    const Buffer_handles* handles{TRY(get_buffers(mesh_id))};
-
-    // clean up old resources
-    if (handles->vertex_buffer) {
-        Uint32 id{0};
-        for (auto& [key, val] : vertex_buffers) {
-            if (val == handles->vertex_buffer) {
-                id = key;
-                break;
-            }
-        }
+    const std::span<const defs::types::vertex::Mesh_vertex> mesh_data{
+        TRY(resource_manager->get_mesh_vertices(mesh_id))
+    };
+    Gpu_mesh& gpu_mesh{gpu_meshes[mesh_id]};
+    const Uint32 vertex_count{static_cast<Uint32>(VALID_SDL_SIZE(mesh_data.size()))};
 
-        SDL_ReleaseGPUBuffer(device, handles->vertex_buffer);
-        if (id != 0)
-            vertex_buffers.erase(id);
+    // still fits, overwrite in place
+    if (vertex_count <= gpu_mesh.vertex_capacity) {
+        gpu_mesh.vertex_count = vertex_count;
+        return upload_mesh_range(gpu_mesh, mesh_data, 0, mesh_data.size());
     }
 
-    // create buffers
-    const Uint32 buffer_size{
-        static_cast<Uint32>(mesh_data.size() * sizeof(defs::types::vertex::Mesh_vertex))
+    // move to a bigger slot, dropping anything still queued for the old one
+    upload_ring.discard(
+        mesh_vertex_buffer, size_t{gpu_mesh.first_vertex} * gpu_mesh.vertex_stride,
+        size_t{gpu_mesh.vertex_capacity} * gpu_mesh.vertex_stride
+    );
+    // frames still in flight may draw from the old slot, it is reused once they are done
+    frame().freed_mesh_slots.emplace_back(gpu_mesh.first_vertex, gpu_mesh.vertex_capacity);
+    gpu_meshes.erase(mesh_id);
+
+    // with some headroom, meshes that grew once tend to grow again
+    TRY(add_gpu_mesh(mesh_id, mesh_data, vertex_count + vertex_count / 2));
+
+    return {};
+}
+
+auto Renderer::update_mesh_range(
+    const Uint32 mesh_id, const size_t first_vertex, const size_t vertex_count
+) -> utils::Result<> {
+    if (not gpu_meshes.contains(mesh_id))
+        return {};
+
+    const std::span<const defs::types::vertex::Mesh_vertex> mesh_data{
+        TRY(resource_manager->get_mesh_vertices(mesh_id))
     };
-    const Uint32 vertex_buffer_id{TRY(create_vertex_buffer(buffer_size))};
-    const Uint32 vertex_transfer_buffer_id{TRY(create_transfer_buffer(buffer_size))};
+    Gpu_mesh& gpu_mesh{gpu_meshes[mesh_id]};
+
+    // grew past its slot, needs a bigger one and a full upload
+    if (mesh_data.size() > gpu_mesh.vertex_capacity)
+        return reregister_mesh(mesh_id);
+
+    if (first_vertex + vertex_count > mesh_data.size())
+        return std::unexpected(
+            std::format("Mesh upload range {}+{} out of bounds", first_vertex, vertex_count)
+        );
+
+    gpu_mesh.vertex_count = static_cast<Uint32>(mesh_data.size());
+
+    return upload_mesh_range(gpu_mesh, mesh_data, first_vertex, vertex_count);
+}
+
+auto Renderer::add_gpu_mesh(
+    const Uint32 mesh_id, const std::span<const defs::types::vertex::Mesh_vertex> mesh_data,
+    const size_t capacity
+) -> utils::Result<> {
 
-    // store mappings
-    mesh_to_buffers[mesh_id] = {
-        .vertex_buffer = vertex_buffers[vertex_buffer_id],
-        .transfer_buffer = transfer_buffers[vertex_transfer_buffer_id],
+    const Uint32 vertex_count{static_cast<Uint32>(VALID_SDL_SIZE(mesh_data.size()))};
+    const Uint32 vertex_capacity{
+        static_cast<Uint32>(VALID_SDL_SIZE(std::max(capacity, mesh_data.size())))
     };
 
-    // upload data and release buffers (if not using again)
-    TRY(upload_mesh_data(mesh_to_buffers[mesh_id], mesh_data));
+    Gpu_mesh gpu_mesh{
+        .first_vertex = vertex_capacity > 0 ? TRY(allocate_mesh_slots(vertex_capacity)) : 0,
+        .vertex_count = vertex_count,
+        .vertex_capacity = vertex_capacity,
+    };
+
+    gpu_meshes[mesh_id] = gpu_mesh;
+    TRY(upload_mesh_range(gpu_mesh, mesh_data, 0, mesh_data.size()));
+
+    return {};
+}
+
+auto Renderer::allocate_mesh_slots(const Uint32 vertex_count) -> utils::Result<Uint32> {
+    if (auto first{mesh_allocator.allocate(vertex_count)}; first)
+        return first;
 
-    SDL_ReleaseGPUTransferBuffer(device, mesh_to_buffers[mesh_id].transfer_buffer);
-    mesh_to_buffers[mesh_id].transfer_buffer = nullptr;
-    transfer_buffers.erase(vertex_transfer_buffer_id);
+    TRY(grow_mesh_pool(vertex_count));
+    return mesh_allocator.allocate(vertex_count);
+}
+
+auto Renderer::grow_mesh_pool(const Uint32 extra_vertices) -> utils::Result<> {
+    constexpr size_t stride{sizeof(defs::types::vertex::Mesh_vertex)};
+
+    const Uint32 old_capacity{mesh_allocator.get_capacity()};
+    const size_t new_capacity{std::max(
+        std::max<size_t>(size_t{old_capacity} * 2, defs::pipelines::mesh_pool_vertices),
+        size_t{old_capacity} + extra_vertices
+    )};
+    const Uint32 new_buffer_id{TRY(create_vertex_buffer(VALID_SDL_SIZE(new_capacity * stride)))};
+    SDL_GPUBuffer* new_buffer{vertex_buffers[new_buffer_id]};
+
+    // slots keep their positions, so the old contents copy over as one block
+    // queued uploads still target the old buffer, record them first
+    if (mesh_vertex_buffer) {
+        SDL_GPUCommandBuffer* command_buffer{CHECK_PTR(gpu->acquire_command_buffer())};
+        TRY(upload_ring.flush(command_buffer));
+
+        SDL_GPUCopyPass* copy_pass{CHECK_PTR(gpu->begin_copy_pass(command_buffer))};
+        const SDL_GPUBufferLocation source{.buffer = mesh_vertex_buffer, .offset = 0};
+        const SDL_GPUBufferLocation destination{.buffer = new_buffer, .offset = 0};
+        gpu->copy_buffer_to_buffer(
+            copy_pass, source, destination, static_cast<Uint32>(old_capacity * stride), false
+        );
+        gpu->end_copy_pass(copy_pass);
+
+        SDL_GPUFence* fence{CHECK_PTR(gpu->submit_with_fence(command_buffer))};
+        TRY(advance_frame(fence));
+
+        gpu->release_buffer(mesh_vertex_buffer);
+        vertex_buffers.erase(mesh_vertex_buffer_id);
+    }
+
+    mesh_vertex_buffer = new_buffer;
+    mesh_vertex_buffer_id = new_buffer_id;
+    mesh_allocator.grow(static_cast<Uint32>(new_capacity));
+
+    if (old_capacity > 0)
+        utils::log(std::format("Mesh pool grown to {} vertices", new_capacity));
+
+    return {};
+}
+
+auto Renderer::submit_uploads() -> utils::Result<> {
+    SDL_GPUCommandBuffer* command_buffer{CHECK_PTR(gpu->acquire_command_buffer())};
+    TRY(upload_ring.flush(command_buffer));
+
+    SDL_GPUFence* fence{CHECK_PTR(gpu->submit_with_fence(command_buffer))};
+    TRY(advance_frame(fence));
+
+    return {};
+}
+
+auto Renderer::advance_frame(SDL_GPUFence* fence) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::advance_frame");
+
+    frame().fence = fence;
+    frame_index = (frame_index + 1) % frames.size();
+
+    // the set was last used frames_in_flight submits ago, usually long finished
+    Frame_resources& next{frame()};
+    if (next.fence) {
+        CHECK_BOOL(gpu->wait_for_fence(next.fence));
+        gpu->release_fence(next.fence);
+        next.fence = nullptr;
+    }
+
+    for (const auto& [first_vertex, vertex_count] : next.freed_mesh_slots)
+        mesh_allocator.free(first_vertex, vertex_count);
+    next.freed_mesh_slots.clear();
+    for (const auto& [first_vertex, vertex_count] : next.freed_text_slots)
+        text_allocator.free(first_vertex, vertex_count);
+    next.freed_text_slots.clear();
+
+    upload_ring.begin_frame(frame_index);
+
+    return {};
+}
+
+auto Renderer::ensure_dynamic_buffer(
+    Dynamic_buffer& dynamic_buffer, const SDL_GPUBufferUsageFlags usage, const size_t bytes
+) -> utils::Result<> {
+    if (bytes <= dynamic_buffer.capacity)
+        return {};
+
+    const size_t new_capacity{VALID_SDL_SIZE(std::max(bytes, dynamic_buffer.capacity * 2))};
+    const SDL_GPUBufferCreateInfo buffer_info{
+        .usage = usage,
+        .size = static_cast<Uint32>(new_capacity),
+    };
+    SDL_GPUBuffer* buffer{CHECK_PTR(gpu->create_buffer(buffer_info))};
+
+    // sdl defers the release until draws already submitted are done with it
+    if (dynamic_buffer.buffer) {
+        upload_ring.discard(dynamic_buffer.buffer);
+        gpu->release_buffer(dynamic_buffer.buffer);
+    }
+    dynamic_buffer = {.buffer = buffer, .capacity = new_capacity};
 
     return {};
 }
 
 auto Renderer::prepare_text_resources() -> utils::Result<> {
     // create buffers (remember to use bytes) and sampler
-    TRY(ensure_text_buffer_capacity(
-        defs::pipelines::initial_text_vertex_bytes, defs::pipelines::initial_text_index_bytes
+    TRY(create_text_arena(defs::pipelines::text_arena_vertices));
+    TRY(ensure_dynamic_buffer(
+        text_indices, SDL_GPU_BUFFERUSAGE_INDEX, defs::pipelines::initial_text_index_bytes
     ));
 
     const Uint32 sampler_id{TRY(create_sampler())};
@@ -196,70 +588,80 @@ auto Renderer::prepare_text_resources() -> utils::Result<> {
     return {};
 }
 
-auto Renderer::create_text_vertex_buffers(const size_t buffer_bytes) -> utils::Result<> {
-
-    // clean up old resources
-    if (text_handles.vertex_buffer) {
-        Uint32 id{0};
-        for (auto& [key, val] : vertex_buffers) {
-            if (val == text_handles.vertex_buffer) {
-                id = key;
-                break;
-            }
-        }
-
-        SDL_ReleaseGPUBuffer(device, text_handles.vertex_buffer);
+auto Renderer::create_text_arena(const Uint32 vertex_capacity) -> utils::Result<> {
+    const SDL_GPUBufferCreateInfo buffer_info{
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .size = static_cast<Uint32>(VALID_SDL_SIZE(
+            size_t{vertex_capacity} * sizeof(defs::types::vertex::Textured_vertex)
+        )),
+    };
+    SDL_GPUBuffer* buffer{CHECK_PTR(gpu->create_buffer(buffer_info))};
 
-        if (id != 0)
-            vertex_buffers.erase(id);
+    // sdl defers the release until draws already submitted are done with it
+    if (text_vertex_buffer) {
+        upload_ring.discard(text_vertex_buffer);
+        gpu->release_buffer(text_vertex_buffer);
     }
+    text_vertex_buffer = buffer;
+    text_allocator = Mesh_allocator{vertex_capacity};
 
-    // create buffers
-    const Uint32 vertex_buffer_id{TRY(create_vertex_buffer(buffer_bytes))};
-    const Uint32 vertex_transfer_buffer_id{TRY(create_transfer_buffer(buffer_bytes))};
-
-    text_handles.vertex_buffer = vertex_buffers[vertex_buffer_id];
-    text_handles.vertex_transfer_buffer = transfer_buffers[vertex_transfer_buffer_id];
-    text_vertex_buffer_size = buffer_bytes;
+    // slots waiting on a fence belong to the old buffer
+    text_geometry.clear();
+    text_layout.clear();
+    for (Frame_resources& frame_set : frames)
+        frame_set.freed_text_slots.clear();
 
     return {};
 }
 
-auto Renderer::create_text_index_buffers(const size_t buffer_bytes) -> utils::Result<> {
+auto Renderer::prepare_sprite_resources() -> utils::Result<> {
+    for (Frame_resources& frame_set : frames)
+        TRY(ensure_dynamic_buffer(
+            frame_set.sprites, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+            defs::pipelines::initial_sprite_count * sizeof(defs::types::shader::Sprite_instance)
+        ));
 
-    // clean up old resources
-    if (text_handles.index_buffer) {
-        Uint32 id{0};
-        for (auto& [key, val] : index_buffers) {
-            if (val == text_handles.index_buffer) {
-                id = key;
-                break;
-            }
-        }
+    const Uint32 sampler_id{TRY(create_sampler())};
+    sprite_handles.sampler = samplers[sampler_id];
 
-        SDL_ReleaseGPUBuffer(device, text_handles.index_buffer);
+    return {};
+}
 
-        if (id != 0)
-            index_buffers.erase(id);
-    }
+auto Renderer::prepare_particle_resources() -> utils::Result<> {
+    for (Frame_resources& frame_set : frames)
+        TRY(ensure_dynamic_buffer(
+            frame_set.particles, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+            defs::pipelines::initial_particle_count
+                * sizeof(defs::types::shader::Sprite_instance)
+        ));
 
-    // create buffers
-    const Uint32 index_buffer_id{TRY(create_index_buffer(buffer_bytes))};
-    const Uint32 index_transfer_buffer_id{TRY(create_transfer_buffer(buffer_bytes))};
+    const Uint32 sampler_id{TRY(create_sampler())};
+    particle_handles.sampler = samplers[sampler_id];
 
-    text_handles.index_buffer = index_buffers[index_buffer_id];
-    text_handles.index_transfer_buffer = transfer_buffers[index_transfer_buffer_id];
-    text_index_buffer_size = buffer_bytes;
+    return {};
+}
+
+auto Renderer::prepare_debug_line_resources() -> utils::Result<> {
+    for (Frame_resources& frame_set : frames)
+        TRY(ensure_dynamic_buffer(
+            frame_set.debug_lines, SDL_GPU_BUFFERUSAGE_VERTEX,
+            defs::pipelines::initial_debug_vertices * sizeof(defs::types::vertex::Mesh_vertex)
+        ));
 
     return {};
 }
 
+auto Renderer::set_render_scale(const float scale) -> void {
+    render_scale = std::clamp(scale, defs::render_graph::min_render_scale, 1.0F);
+}
+
 auto Renderer::render_frame(Render_queue& queue, const defs::types::camera::Frame_data& frame_data)
     -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_frame");
 
     // TODO: how to properly handle this?
     // TRY(begin_frame(frame_data));
-    // TRY(execute_commands(queue));
+    // TRY(execute_commands());
     // TRY(end_frame());
 
     if (auto res = begin_frame(queue, frame_data); not res) {
@@ -267,7 +669,7 @@ auto Renderer::render_frame(Render_queue& queue, const defs::types::camera::Fram
         TRY(end_frame());
     }
 
-    if (auto res = execute_commands(queue); not res)
+    if (auto res = execute_commands(); not res)
         utils::log("dbg" + res.error());
 
     if (auto res = end_frame(); not res)
@@ -278,179 +680,483 @@ auto Renderer::render_frame(Render_queue& queue, const defs::types::camera::Fram
 
 auto Renderer::begin_frame(Render_queue& queue, const defs::types::camera::Frame_data& frame_data)
     -> utils::Result<> {
+    PROFILE_ZONE("Renderer::begin_frame");
+
+    // pipelines finished since last frame start drawing from this one
+    collect_pipelines();
+    graph.reset();
 
     // get the command buffer
-    current_frame.command_buffer = CHECK_PTR(SDL_AcquireGPUCommandBuffer(device));
+    current_frame.command_buffer = CHECK_PTR(gpu->acquire_command_buffer());
 
-    // handle dynamic text data before rendering (copy pass)
-    if (not queue.text_commands.empty())
-        TRY(upload_text_data(queue.text_commands));
+    // stage dynamic text data and the rest of the frame's data, the graph's upload pass
+    // records it with everything else staged since the last frame (meshes included)
+    TRY(upload_text_data(queue.text_commands));
+    TRY(prepare_mesh_batches(queue));
+    TRY(upload_sprite_data(queue.sprite_batches));
+    TRY(upload_particle_data(queue.particle_batches));
+    TRY(upload_debug_lines(queue.debug_lines));
 
     // get camera data
     current_frame.frame_data = frame_data;
 
-    // get the swapchain texture - end frame early if not available
-    if (not SDL_WaitAndAcquireGPUSwapchainTexture(
-            current_frame.command_buffer, window, &current_frame.swapchain_texture,
-            &current_frame.width, &current_frame.height
-        )) {
-        SDL_SubmitGPUCommandBuffer(current_frame.command_buffer);
-        return {};
-    }
+    // get the swapchain texture - null when minimized, then only the uploads are recorded
+    // the command buffer is still submitted by end_frame, the copy pass has to run
+    CHECK_BOOL(gpu->acquire_swapchain_texture(
+        current_frame.command_buffer, &current_frame.swapchain_texture, &current_frame.width,
+        &current_frame.height
+    ));
 
-    // begin render pass
-    const SDL_GPUColorTargetInfo color_target_info{
-        .texture = current_frame.swapchain_texture,
-        .clear_color = {0.15F, 0.17F, 0.20F, 1.00F},
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE,
-    };
-    current_frame.render_pass = CHECK_PTR(
-        SDL_BeginGPURenderPass(current_frame.command_buffer, &color_target_info, 1, nullptr)
-    );
+    TRY(build_frame_graph(queue));
+    TRY(graph.compile());
 
     return {};
 }
 
-auto Renderer::execute_commands(const Render_queue& queue) const -> utils::Result<> {
-    // sort commands by pipeline for efficiency
-    auto sorted_opaque{queue.opaque_commands};
-    std::ranges::sort(
-        sorted_opaque.begin(), sorted_opaque.end(),
-        [](const Render_mesh_command& a, const Render_mesh_command& b) {
-            return a.pipeline_id < b.pipeline_id;
-        }
-    );
+auto Renderer::execute_commands() -> utils::Result<> {
+    PROFILE_ZONE("Renderer::execute_commands");
 
-    TRY(render_opaque(sorted_opaque));
-    // render_transparent(queue.transparent_commands);
-    // render_ui(queue.ui_commands);
-    TRY(render_text(queue.text_commands));
+    TRY(graph.execute(current_frame.command_buffer));
+
+    const Graph_stats& graph_stats{graph.get_stats()};
+    current_frame.stats.render_passes = graph_stats.render_passes;
+    current_frame.stats.copy_passes = graph_stats.copy_passes;
 
     return {};
 }
 
 auto Renderer::end_frame() -> utils::Result<> {
-    // end render pass, submit command buffer
-    SDL_EndGPURenderPass(current_frame.render_pass);
-    CHECK_BOOL(SDL_SubmitGPUCommandBuffer(current_frame.command_buffer));
+    PROFILE_ZONE("Renderer::end_frame");
+
+    // the graph ended its passes, submit command buffer
+    // the fence tells when this frame's staging memory and dynamic buffers are free again
+    SDL_GPUFence* fence{nullptr};
+    if (current_frame.command_buffer)
+        fence = CHECK_PTR(gpu->submit_with_fence(current_frame.command_buffer));
 
+    // the pass callbacks hold on to the queue, which is refilled before the next frame
+    graph.reset();
+    last_frame_stats = current_frame.stats;
     current_frame.reset();
+    TRY(advance_frame(fence));
 
     return {};
 }
 
-auto Renderer::render_opaque(const std::vector<Render_mesh_command>& commands) const
-    -> utils::Result<> {
+auto Renderer::build_frame_graph(const Render_queue& queue) -> utils::Result<> {
+    // the buffers passes draw from, all of them filled by the uploads
+    const Render_graph::Resource meshes{graph.import_buffer(mesh_vertex_buffer)};
+    const Render_graph::Resource instances{graph.import_buffer(frame().mesh_instances.buffer)};
+    const Render_graph::Resource sprites{graph.import_buffer(frame().sprites.buffer)};
+    const Render_graph::Resource particles{graph.import_buffer(frame().particles.buffer)};
+    const Render_graph::Resource debug_lines{graph.import_buffer(frame().debug_lines.buffer)};
+    const Render_graph::Resource text_vertices{graph.import_buffer(text_vertex_buffer)};
+    const Render_graph::Resource text_index_list{graph.import_buffer(text_indices.buffer)};
+
+    // textures staged for upload are not graph resources, every pass sampling one reads
+    // a buffer written here as well, so the copies still land first
+    if (upload_ring.has_pending()) {
+        Render_graph::Pass_builder uploads{
+            graph.add_copy_pass("uploads", [this](SDL_GPUCopyPass* copy_pass) -> utils::Result<> {
+                upload_ring.record(copy_pass);
+                return {};
+            })
+        };
+        for (const Render_graph::Resource buffer :
+             {meshes, instances, sprites, particles, debug_lines, text_vertices, text_index_list})
+            uploads.write(buffer);
+    }
 
-    for (const auto& cmd : commands) {
-        SDL_GPUGraphicsPipeline* pipeline{TRY(get_pipeline(cmd.pipeline_id))};
-        const Buffer_handles* buffers{TRY(get_buffers(cmd.mesh_id))};
+    if (not current_frame.swapchain_texture)
+        return {};
 
-        // check not nullptr before using a buffer
-        if (not buffers->vertex_buffer)
-            return std::unexpected(std::format("vertex buffer = nullptr"));
+    const Uint32 width{current_frame.width};
+    const Uint32 height{current_frame.height};
+    const SDL_GPUTextureFormat color_format{gpu->swapchain_format()};
+    const Graph_texture_desc swapchain_desc{
+        .format = color_format,
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+        .width = width,
+        .height = height,
+    };
+    const Render_graph::Resource swapchain{
+        graph.import_texture(current_frame.swapchain_texture, swapchain_desc)
+    };
+    // depth only matters within the frame, nothing reads it afterwards
+    const auto depth_desc{[](const Uint32 depth_width, const Uint32 depth_height) {
+        return Graph_texture_desc{
+            .format = defs::pipelines::descriptors::depth_format,
+            .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+            .width = depth_width,
+            .height = depth_height,
+        };
+    }};
+
+    // the scene goes straight to the swapchain, unless it is drawn smaller and scaled up
+    const float scale{render_scale};
+    const bool scaled{scale < 1.0F};
+    const Uint32 scene_width{std::max(static_cast<Uint32>(static_cast<float>(width) * scale), 1U)};
+    const Uint32 scene_height{
+        std::max(static_cast<Uint32>(static_cast<float>(height) * scale), 1U)
+    };
+    const Render_graph::Resource scene_color{
+        scaled ? graph.create_texture({
+                     .format = color_format,
+                     .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+                     .width = scene_width,
+                     .height = scene_height,
+                 })
+               : swapchain
+    };
+    const Render_graph::Resource scene_depth{
+        graph.create_texture(depth_desc(scene_width, scene_height))
+    };
 
-        // bind the graphics pipeline
-        SDL_BindGPUGraphicsPipeline(current_frame.render_pass, pipeline);
+    // sprites are the background layer, drawn first without touching depth
+    const auto background{[this, &queue](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_sprites(queue.sprite_batches);
+    }};
+    graph.add_render_pass("background", background)
+        .color(scene_color, defs::render_graph::clear_color)
+        .depth(scene_depth, 1.0F)
+        .read(sprites);
+
+    // mesh passes were sorted into batches by begin_frame, opaque fills the depth buffer
+    // that transparent draws then test against
+    const auto opaque{[this](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_meshes(opaque_pass);
+    }};
+    graph.add_render_pass("opaque", opaque)
+        .color(scene_color)
+        .depth(scene_depth)
+        .read(meshes)
+        .read(instances);
+
+    const auto transparent{[this](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_meshes(transparent_pass);
+    }};
+    graph.add_render_pass("transparent", transparent)
+        .color(scene_color)
+        .depth(scene_depth)
+        .read(meshes)
+        .read(instances);
+
+    // over the meshes, under the text
+    const auto particle_draws{[this, &queue](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_particles(queue.particle_batches);
+    }};
+    graph.add_render_pass("particles", particle_draws)
+        .color(scene_color)
+        .depth(scene_depth)
+        .read(particles);
+
+    // text and debug lines stay sharp at full size, they never test depth, so when the
+    // scene was scaled they get a depth target nothing needs to clear or keep
+    Render_graph::Resource overlay_depth{scene_depth};
+    if (scaled) {
+        graph.add_blit_pass("post", scene_color, swapchain);
+        overlay_depth = graph.create_texture(depth_desc(width, height));
+    }
 
-        // bind the vertex buffer
-        const SDL_GPUBufferBinding buffer_binding{
-            .buffer = buffers->vertex_buffer,
-            .offset = 0,
-        };
-        SDL_BindGPUVertexBuffers(current_frame.render_pass, 0, &buffer_binding, 1);
+    // render_ui(queue.ui_commands);
+    const auto text{[this](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_text();
+    }};
+    graph.add_render_pass("text", text)
+        .color(swapchain)
+        .depth(overlay_depth)
+        .read(text_vertices)
+        .read(text_index_list);
+
+    // over everything, text included
+    const auto debug{[this, &queue](const Graph_render_context& context) {
+        enter_render_pass(context);
+        return render_debug_lines(queue.debug_lines);
+    }};
+    graph.add_render_pass("debug", debug)
+        .color(swapchain)
+        .depth(overlay_depth)
+        .read(debug_lines);
 
-        // update uniform data (this does not necessarily need to be done here)
-        // Build 2D model matrix with translation, rotation, and scale
-        glm::mat4 mvp{
-            current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix *
-            cmd.model_matrix
-        };
+    return {};
+}
 
-        // DEBUG - this is dumb, but for now...
-        size_t vertex_count{};
-        auto mesh_data{resource_manager->get_mesh_data_copy(cmd.mesh_id)};
-        if (mesh_data)
-            vertex_count = mesh_data.value().size();
+auto Renderer::render_meshes(const Mesh_pass& pass) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_meshes");
 
-        // bind uniform data
-        SDL_PushGPUVertexUniformData(current_frame.command_buffer, 0, &mvp, sizeof(glm::mat4));
+    if (pass.batches.empty())
+        return {};
 
-        // issue draw call
-        SDL_DrawGPUPrimitives(current_frame.render_pass, vertex_count, 1, 0, 0);
+    // every mesh lives in the pool, so the vertex buffer is bound once for all of them
+    bind_vertex_buffer(mesh_vertex_buffer);
+
+    const glm::mat4 view_proj{
+        current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix
+    };
+    // mesh shaders place vertices at z = 0, the command's depth reaches clip space through
+    // the matrices instead: instances carry it in translation.z, which this passes through
+    glm::mat4 instanced_view_proj{view_proj};
+    instanced_view_proj[0][2] = 0.0F;
+    instanced_view_proj[1][2] = 0.0F;
+    instanced_view_proj[2][2] = 1.0F;
+    instanced_view_proj[3][2] = 0.0F;
+
+    // batches arrive in key order, binds only happen where the pipeline changes
+    for (const Mesh_batch& batch : pass.batches) {
+        const Gpu_mesh* gpu_mesh{TRY(get_gpu_mesh(batch.mesh_id))};
+        bind_pipeline(TRY(get_batch_pipeline(pass, batch)));
+
+        if (batch.instanced) {
+            bind_vertex_storage_buffer(frame().mesh_instances.buffer);
+
+            // one draw for the whole batch, transforms come from the instance buffer
+            const defs::types::shader::Instanced_uniforms uniforms{
+                .view_proj = instanced_view_proj,
+                .first_instance = batch.first_instance,
+            };
+            push_vertex_uniforms(&uniforms, sizeof(uniforms));
+            gpu->draw(
+                current_frame.render_pass, gpu_mesh->vertex_count, batch.command_count,
+                gpu_mesh->first_vertex, 0
+            );
+            ++current_frame.stats.draws;
+            continue;
+        }
+
+        for (const Render_mesh_command& cmd :
+             std::span{pass.commands}.subspan(batch.first_command, batch.command_count)) {
+            // update uniform data (this does not necessarily need to be done here)
+            // every vertex of the command lands on its depth
+            glm::mat4 mvp{view_proj * cmd.model_matrix};
+            mvp[0][2] = 0.0F;
+            mvp[1][2] = 0.0F;
+            mvp[2][2] = 0.0F;
+            mvp[3][2] = std::clamp(cmd.depth, 0.0F, 1.0F);
+
+            // bind uniform data
+            push_vertex_uniforms(&mvp, sizeof(glm::mat4));
+
+            // issue draw call, the mesh's slot in the pool is just a vertex offset
+            gpu->draw(
+                current_frame.render_pass, gpu_mesh->vertex_count, 1, gpu_mesh->first_vertex, 0
+            );
+            ++current_frame.stats.draws;
+        }
     }
 
     return {};
 }
+auto Renderer::render_text() -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_text");
 
-auto Renderer::render_text(const std::vector<Render_text_command>& commands) const
-    -> utils::Result<> {
-
-    if (commands.empty())
+    // still compiling
+    if (text_batches.empty() || not text_handles.pipeline)
         return {};
 
     // check not nullptr before using a buffer - necessary?
-    if (not(text_handles.vertex_buffer && text_handles.index_buffer))
+    if (not(text_vertex_buffer && text_indices.buffer))
         return std::unexpected(std::format("buffer = nullptr"));
 
     // bind text pipeline and buffers once
-    SDL_BindGPUGraphicsPipeline(current_frame.render_pass, text_handles.pipeline);
+    bind_pipeline(text_handles.pipeline);
+    bind_vertex_buffer(text_vertex_buffer);
+    bind_index_buffer(text_indices.buffer, text_index_size);
 
-    const SDL_GPUBufferBinding vertex_binding{
-        .buffer = text_handles.vertex_buffer,
-        .offset = 0,
+    // glyphs are already in world space, one matrix for every text command
+    const defs::types::shader::Text_uniforms uniforms{
+        .proj_view = current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix,
     };
-    SDL_BindGPUVertexBuffers(current_frame.render_pass, 0, &vertex_binding, 1);
+    push_vertex_uniforms(&uniforms, sizeof(uniforms));
+
+    // a draw per atlas page, however many commands and glyphs use it
+    for (const Text_batch& batch : text_batches) {
+        bind_fragment_texture(batch.atlas, text_handles.sampler);
+        gpu->draw_indexed(
+            current_frame.render_pass, batch.index_count, 1, batch.first_index, 0, 0
+        );
+        ++current_frame.stats.draws;
+    }
 
-    const SDL_GPUBufferBinding index_binding{
-        .buffer = text_handles.index_buffer,
-        .offset = 0,
+    return {};
+}
+
+auto Renderer::render_sprites(const std::vector<Render_sprite_batch>& batches)
+    -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_sprites");
+
+    if (std::ranges::all_of(batches, [](const Render_sprite_batch& batch) {
+            return batch.sprites.empty();
+        }))
+        return {};
+
+    // still compiling
+    if (not sprite_handles.pipeline)
+        return {};
+
+    // one pipeline, one storage buffer and one matrix for every sprite
+    bind_pipeline(sprite_handles.pipeline);
+    bind_vertex_storage_buffer(frame().sprites.buffer);
+
+    const glm::mat4 view_proj{
+        current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix
     };
-    SDL_BindGPUIndexBuffer(
-        current_frame.render_pass, &index_binding, SDL_GPU_INDEXELEMENTSIZE_16BIT
-    );
+    push_vertex_uniforms(&view_proj, sizeof(glm::mat4));
 
-    // render each text command
-    for (const auto& cmd : commands) {
+    // a draw per atlas, the shader builds 6 vertices per sprite from the vertex index
+    for (const Render_sprite_batch& batch : batches) {
+        if (batch.sprites.empty())
+            continue;
 
-        // update and bind uniform data
-        glm::mat4 mvp{
-            current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix *
-            cmd.model_matrix
-        };
-        SDL_PushGPUVertexUniformData(current_frame.command_buffer, 0, &mvp, sizeof(glm::mat4));
+        bind_fragment_texture(TRY(get_texture(batch.texture_id)), sprite_handles.sampler);
+        gpu->draw(
+            current_frame.render_pass, static_cast<Uint32>(batch.sprites.size()) * 6, 1,
+            batch.first_sprite * 6, 0
+        );
+        ++current_frame.stats.draws;
+    }
 
-        // iterate through each glyph in this command
-        Uint32 current_index_offset{static_cast<Uint32>(cmd.index_offset / sizeof(Uint16))};
-        for (const TTF_GPUAtlasDrawSequence* current = cmd.draw_data; current;
-             current = current->next) {
+    return {};
+}
 
-            // create and bind texture sampler for this glyph
-            const SDL_GPUTextureSamplerBinding sampler_binding{
-                .texture = current->atlas_texture,
-                .sampler = text_handles.sampler,
-            };
-            SDL_BindGPUFragmentSamplers(current_frame.render_pass, 0, &sampler_binding, 1);
+auto Renderer::render_particles(const std::vector<Render_particle_batch>& batches)
+    -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_particles");
 
-            // draw this glyph's primitives (vertex offset is already baked into indices)
-            SDL_DrawGPUIndexedPrimitives(
-                current_frame.render_pass, current->num_indices, 1, current_index_offset, 0, 0
-            );
+    // still compiling, or nothing alive
+    if (batches.empty() || not particle_handles.pipeline)
+        return {};
 
-            current_index_offset += current->num_indices;
-        }
+    bind_pipeline(particle_handles.pipeline);
+    bind_vertex_storage_buffer(frame().particles.buffer);
+
+    const glm::mat4 view_proj{
+        current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix
+    };
+    push_vertex_uniforms(&view_proj, sizeof(glm::mat4));
+
+    // a draw per material, built from the vertex index like sprites
+    for (const Render_particle_batch& batch : batches) {
+        bind_fragment_texture(TRY(get_texture(batch.texture_id)), particle_handles.sampler);
+        gpu->draw(
+            current_frame.render_pass, static_cast<Uint32>(batch.particles.size()) * 6, 1,
+            batch.first_particle * 6, 0
+        );
+        ++current_frame.stats.draws;
     }
 
     return {};
 }
 
+auto Renderer::render_debug_lines(
+    const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::render_debug_lines");
+
+    if (vertices.empty() || not debug_line_pipeline)
+        return {};
+
+    // the lines are in world space, the model part of the mvp is identity
+    bind_pipeline(debug_line_pipeline);
+    bind_vertex_buffer(frame().debug_lines.buffer);
+
+    const glm::mat4 view_proj{
+        current_frame.frame_data.proj_matrix * current_frame.frame_data.view_matrix
+    };
+    push_vertex_uniforms(&view_proj, sizeof(glm::mat4));
+
+    gpu->draw(current_frame.render_pass, static_cast<Uint32>(vertices.size()), 1, 0, 0);
+    ++current_frame.stats.draws;
+
+    return {};
+}
+
+auto Renderer::enter_render_pass(const Graph_render_context& context) -> void {
+    current_frame.render_pass = context.render_pass;
+    if (context.pass_began)
+        current_frame.reset_bindings();
+}
+
+auto Renderer::bind_pipeline(SDL_GPUGraphicsPipeline* pipeline) -> void {
+    if (pipeline == current_frame.bound_pipeline)
+        return;
+
+    gpu->bind_graphics_pipeline(current_frame.render_pass, pipeline);
+    current_frame.bound_pipeline = pipeline;
+    ++current_frame.stats.pipeline_binds;
+
+    // resource bindings belong to the pipeline's layout, rebind them for the new one
+    current_frame.bound_storage_buffer = nullptr;
+    current_frame.bound_texture = nullptr;
+}
+
+auto Renderer::bind_vertex_buffer(SDL_GPUBuffer* buffer) -> void {
+    if (buffer == current_frame.bound_vertex_buffer)
+        return;
+
+    const SDL_GPUBufferBinding buffer_binding{
+        .buffer = buffer,
+        .offset = 0,
+    };
+    gpu->bind_vertex_buffer(current_frame.render_pass, buffer_binding);
+    current_frame.bound_vertex_buffer = buffer;
+    ++current_frame.stats.buffer_binds;
+}
+
+auto Renderer::bind_index_buffer(
+    SDL_GPUBuffer* buffer, const SDL_GPUIndexElementSize element_size
+) -> void {
+    if (buffer == current_frame.bound_index_buffer &&
+        element_size == current_frame.bound_index_size)
+        return;
+
+    const SDL_GPUBufferBinding buffer_binding{
+        .buffer = buffer,
+        .offset = 0,
+    };
+    gpu->bind_index_buffer(current_frame.render_pass, buffer_binding, element_size);
+    current_frame.bound_index_buffer = buffer;
+    current_frame.bound_index_size = element_size;
+    ++current_frame.stats.buffer_binds;
+}
+
+auto Renderer::bind_vertex_storage_buffer(SDL_GPUBuffer* buffer) -> void {
+    if (buffer == current_frame.bound_storage_buffer)
+        return;
+
+    gpu->bind_vertex_storage_buffer(current_frame.render_pass, buffer);
+    current_frame.bound_storage_buffer = buffer;
+    ++current_frame.stats.buffer_binds;
+}
+
+auto Renderer::bind_fragment_texture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler) -> void {
+    if (texture == current_frame.bound_texture)
+        return;
+
+    const SDL_GPUTextureSamplerBinding sampler_binding{
+        .texture = texture,
+        .sampler = sampler,
+    };
+    gpu->bind_fragment_sampler(current_frame.render_pass, sampler_binding);
+    current_frame.bound_texture = texture;
+    ++current_frame.stats.texture_binds;
+}
+
+auto Renderer::push_vertex_uniforms(const void* data, const Uint32 bytes) -> void {
+    gpu->push_vertex_uniforms(current_frame.command_buffer, 0, data, bytes);
+    ++current_frame.stats.uniform_pushes;
+}
+
 auto Renderer::create_vertex_buffer(const size_t buffer_size) -> utils::Result<Uint32> {
     const SDL_GPUBufferCreateInfo buffer_info{
         .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
         .size = static_cast<Uint32>(buffer_size),
     };
-    SDL_GPUBuffer* vertex_buffer{CHECK_PTR(SDL_CreateGPUBuffer(device, &buffer_info))};
+    SDL_GPUBuffer* vertex_buffer{CHECK_PTR(gpu->create_buffer(buffer_info))};
 
     const Uint32 buffer_id{next_buffer_id++};
     vertex_buffers[buffer_id] = vertex_buffer;
@@ -463,7 +1169,7 @@ auto Renderer::create_index_buffer(const size_t buffer_size) -> utils::Result<Ui
         .usage = SDL_GPU_BUFFERUSAGE_INDEX,
         .size = static_cast<Uint32>(buffer_size),
     };
-    SDL_GPUBuffer* index_buffer{CHECK_PTR(SDL_CreateGPUBuffer(device, &buffer_info))};
+    SDL_GPUBuffer* index_buffer{CHECK_PTR(gpu->create_buffer(buffer_info))};
 
     const Uint32 buffer_id{next_buffer_id++};
     index_buffers[buffer_id] = index_buffer;
@@ -471,22 +1177,6 @@ auto Renderer::create_index_buffer(const size_t buffer_size) -> utils::Result<Ui
     return buffer_id;
 }
 
-auto Renderer::create_transfer_buffer(const size_t buffer_size) -> utils::Result<Uint32> {
-    // create transfer buffer to upload data with
-    const SDL_GPUTransferBufferCreateInfo transfer_info{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = static_cast<Uint32>(buffer_size),
-    };
-    SDL_GPUTransferBuffer* transfer_buffer{
-        CHECK_PTR(SDL_CreateGPUTransferBuffer(device, &transfer_info))
-    };
-
-    const Uint32 buffer_id{next_buffer_id++};
-    transfer_buffers[buffer_id] = transfer_buffer;
-
-    return buffer_id;
-}
-
 auto Renderer::create_sampler() -> utils::Result<Uint32> {
     constexpr SDL_GPUSamplerCreateInfo info{
         .min_filter = SDL_GPU_FILTER_LINEAR,
@@ -496,7 +1186,7 @@ auto Renderer::create_sampler() -> utils::Result<Uint32> {
         .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
         .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
     };
-    SDL_GPUSampler* sampler{CHECK_PTR(SDL_CreateGPUSampler(device, &info))};
+    SDL_GPUSampler* sampler{CHECK_PTR(gpu->create_sampler(info))};
 
     const Uint32 sampler_id{next_buffer_id++};
     samplers[sampler_id] = sampler;
@@ -504,224 +1194,530 @@ auto Renderer::create_sampler() -> utils::Result<Uint32> {
     return sampler_id;
 }
 
-// this acquires and uses a command buffer of its own...
-// may want to rethink how/when this does its job
-auto Renderer::upload_mesh_data(
-    const Buffer_handles& buffers, const defs::types::vertex::Mesh_data& vertex_data
-) const -> utils::Result<> {
+auto Renderer::upload_mesh_range(
+    const Gpu_mesh& gpu_mesh, const std::span<const defs::types::vertex::Mesh_vertex> vertex_data,
+    const size_t first_vertex, const size_t vertex_count
+) -> utils::Result<> {
 
-    const Uint32 buffer_size{
-        static_cast<Uint32>(vertex_data.size() * sizeof(defs::types::vertex::Mesh_vertex))
-    };
-    // map transfer buffer to a pointer
-    defs::types::vertex::Mesh_vertex* transfer_ptr{CHECK_PTR(
-        static_cast<defs::types::vertex::Mesh_vertex*>(
-            SDL_MapGPUTransferBuffer(device, buffers.transfer_buffer, false)
-        )
-    )};
+    if (vertex_count == 0)
+        return {};
 
-    // copy the data, and unmap when finished updating transfer buffer
-    SDL_memcpy(transfer_ptr, vertex_data.data(), buffer_size);
-    SDL_UnmapGPUTransferBuffer(device, buffers.transfer_buffer);
+    if (first_vertex + vertex_count > vertex_data.size() ||
+        first_vertex + vertex_count > gpu_mesh.vertex_capacity)
+        return std::unexpected(
+            std::format("Mesh upload range {}+{} out of bounds", first_vertex, vertex_count)
+        );
 
-    // start a copy pass
-    SDL_GPUCommandBuffer* command_buffer{CHECK_PTR(SDL_AcquireGPUCommandBuffer(device))};
-    SDL_GPUCopyPass* copy_pass{CHECK_PTR(SDL_BeginGPUCopyPass(command_buffer))};
+    // byte range inside the shared pool buffer
+    const size_t offset_bytes{(gpu_mesh.first_vertex + first_vertex) * gpu_mesh.vertex_stride};
+    const size_t size_bytes{vertex_count * gpu_mesh.vertex_stride};
 
-    // locate the data
-    const SDL_GPUTransferBufferLocation location{
-        .transfer_buffer = buffers.transfer_buffer,
-        .offset = 0,
-    };
+    // stage into the ring, the copy is recorded with the next frame's other uploads
+    // no cycling, every other mesh in the pool has to survive a partial write
+    std::byte* staged{TRY(upload_ring.stage(mesh_vertex_buffer, offset_bytes, size_bytes, false))};
 
-    // locate upload destination
-    const SDL_GPUBufferRegion region{
-        .buffer = buffers.vertex_buffer,
-        .offset = 0,
-        .size = buffer_size,
-    };
-
-    // upload the data, end the copy pass, and submit command buffer
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, true);
-    SDL_EndGPUCopyPass(copy_pass);
-    CHECK_BOOL(SDL_SubmitGPUCommandBuffer(command_buffer));
+    // for level meshes this reads straight from the mapped file
+    SDL_memcpy(staged, vertex_data.data() + first_vertex, size_bytes);
 
     return {};
 }
 
-auto Renderer::upload_text_data(std::vector<Render_text_command>& commands) -> utils::Result<> {
+auto Renderer::upload_text_data(const std::vector<Render_text_command>& commands)
+    -> utils::Result<> {
+    PROFILE_ZONE("Renderer::upload_text_data");
+
+    // drop glyphs of texts that changed, their slots are reused once no frame in flight
+    // can still draw them
+    bool layout_changed{commands.size() != text_layout.size()};
+    for (size_t i{0}; i < commands.size(); ++i) {
+        const Render_text_command& cmd{commands[i]};
+        layout_changed = layout_changed || text_layout[i] != cmd.text_id;
+
+        const auto it{text_geometry.find(cmd.text_id)};
+        if (it == text_geometry.end() ||
+            (it->second.revision == cmd.revision && it->second.model_matrix == cmd.model_matrix))
+            continue;
 
-    // calculate total vertices needed for ALL text
-    size_t total_vertices{0};
-    size_t total_indices{0};
-    for (const auto& cmd : commands)
-        if (cmd.draw_data) {
-            const TTF_GPUAtlasDrawSequence* current{cmd.draw_data};
-            while (current) {
-                total_vertices += cmd.draw_data->num_vertices;
-                total_indices += cmd.draw_data->num_indices;
-
-                current = current->next;
-            }
+        frame().freed_text_slots.emplace_back(it->second.first_vertex, it->second.vertex_count);
+        text_geometry.erase(it);
+    }
+
+    // regenerate only what is missing, a full (or too fragmented) arena is compacted
+    for (const Render_text_command& cmd : commands) {
+        if (text_geometry.contains(cmd.text_id))
+            continue;
+        layout_changed = true;
+
+        const Uint32 vertex_count{count_text_vertices(cmd)};
+        const auto first_vertex{
+            vertex_count > 0 ? text_allocator.allocate(vertex_count) : utils::Result<Uint32>{0}
+        };
+        if (not first_vertex) {
+            TRY(compact_text_arena(commands));
+            break;
         }
+        TRY(emit_text_geometry(cmd, *first_vertex));
+    }
 
-    if (total_vertices == 0)
-        return {};
+    if (layout_changed)
+        TRY(write_text_indices(commands));
 
-    // ensure buffers are large enough
-    TRY(ensure_text_buffer_capacity(total_vertices, total_indices));
+    return {};
+}
 
-    // map transfer buffers
-    void* vertex_ptr{
-        CHECK_PTR(SDL_MapGPUTransferBuffer(device, text_handles.vertex_transfer_buffer, false))
-    };
-    void* index_ptr{
-        CHECK_PTR(SDL_MapGPUTransferBuffer(device, text_handles.index_transfer_buffer, false))
+auto Renderer::emit_text_geometry(const Render_text_command& command, const Uint32 first_vertex)
+    -> utils::Result<> {
+
+    Text_geometry geometry{
+        .first_vertex = first_vertex,
+        .vertex_count = count_text_vertices(command),
+        .revision = command.revision,
+        .model_matrix = command.model_matrix,
     };
 
-    // copy all text data into transfer buffers
-    size_t vertex_offset{0};    // byte offsets
-    size_t index_offset{0};
-    for (auto& cmd : commands) {
-        if (not cmd.draw_data)
+    if (geometry.vertex_count > 0) {
+        constexpr size_t stride{sizeof(defs::types::vertex::Textured_vertex)};
+        const std::span vertices{
+            reinterpret_cast<defs::types::vertex::Textured_vertex*>(TRY(upload_ring.stage(
+                text_vertex_buffer, size_t{first_vertex} * stride,
+                size_t{geometry.vertex_count} * stride, false
+            ))),
+            geometry.vertex_count
+        };
+
+        // glyph indices count from the glyph's first vertex, rebase them onto the arena
+        Uint32 base_vertex{0};
+        for (const TTF_GPUAtlasDrawSequence* glyph{command.draw_data}; glyph;
+             glyph = glyph->next) {
+            write_glyph_vertices(*glyph, command.model_matrix, vertices.subspan(base_vertex));
+
+            auto run{std::ranges::find(geometry.runs, glyph->atlas_texture, &Text_run::atlas)};
+            if (run == geometry.runs.end())
+                run = geometry.runs.insert(geometry.runs.end(), {.atlas = glyph->atlas_texture});
+
+            // a plain add over contiguous memory, the compiler vectorizes it
+            const size_t first_index{run->indices.size()};
+            run->indices.resize(first_index + static_cast<size_t>(glyph->num_indices));
+            Uint32* rebased{run->indices.data() + first_index};
+            const Uint32 glyph_base{first_vertex + base_vertex};
+            for (int i{0}; i < glyph->num_indices; ++i)
+                rebased[i] = glyph_base + static_cast<Uint32>(glyph->indices[i]);
+
+            base_vertex += static_cast<Uint32>(glyph->num_vertices);
+        }
+    }
+
+    text_geometry[command.text_id] = std::move(geometry);
+
+    return {};
+}
+
+auto Renderer::compact_text_arena(const std::vector<Render_text_command>& commands)
+    -> utils::Result<> {
+
+    size_t needed_vertices{0};
+    for (const Render_text_command& cmd : commands)
+        needed_vertices += count_text_vertices(cmd);
+
+    // room for the live texts to change a few times before the next compaction
+    const Uint32 capacity{static_cast<Uint32>(VALID_SDL_SIZE(std::max(
+        size_t{std::max(text_allocator.get_capacity(), defs::pipelines::text_arena_vertices)},
+        needed_vertices * 2
+    )))};
+    TRY(create_text_arena(capacity));
+
+    for (const Render_text_command& cmd : commands) {
+        if (text_geometry.contains(cmd.text_id))
             continue;
 
-        // byte offsets - store where this command's data starts
-        cmd.vertex_offset = vertex_offset;
-        cmd.index_offset = index_offset;
+        const Uint32 vertex_count{count_text_vertices(cmd)};
+        const Uint32 first_vertex{
+            vertex_count > 0 ? TRY(text_allocator.allocate(vertex_count)) : 0
+        };
+        TRY(emit_text_geometry(cmd, first_vertex));
+    }
 
-        size_t command_vertex_count{0};
-        size_t command_index_count{0};
+    utils::log(std::format(
+        "Text arena compacted, {} of {} vertices used", text_allocator.get_used(), capacity
+    ));
 
-        // iterate through all glyphs in this command
-        const TTF_GPUAtlasDrawSequence* current_glyph{cmd.draw_data};
-        while (current_glyph) {
+    return {};
+}
 
-            // create glyph's vertices
-            const std::vector<defs::types::vertex::Textured_vertex> vertices{
-                make_glyph_vertices(*current_glyph)
-            };
+auto Renderer::write_text_indices(const std::vector<Render_text_command>& commands)
+    -> utils::Result<> {
 
-            // copy vertices - destination: buffer + byte offset, source: vertex data, size in bytes
-            SDL_memcpy(
-                static_cast<char*>(vertex_ptr) + vertex_offset, vertices.data(),
-                vertices.size() * sizeof(defs::types::vertex::Textured_vertex)
-            );
+    // count the indices each atlas page needs across all texts
+    text_layout.clear();
+    text_batches.clear();
+    size_t total_indices{0};
+    for (const Render_text_command& cmd : commands) {
+        text_layout.push_back(cmd.text_id);
+        for (const Text_run& run : text_geometry.at(cmd.text_id).runs) {
+            auto batch{std::ranges::find(text_batches, run.atlas, &Text_batch::atlas)};
+            if (batch == text_batches.end())
+                batch = text_batches.insert(text_batches.end(), {.atlas = run.atlas});
+
+            batch->index_count += static_cast<Uint32>(run.indices.size());
+            total_indices += run.indices.size();
+        }
+    }
+
+    if (total_indices == 0) {
+        text_batches.clear();
+        return {};
+    }
+    VALID_SDL_SIZE(total_indices);
 
-            // copy and adjust indices for batching
-            /* left side:
-             * static_cast<Uint16*>(index_ptr)
-             * treat buffer as an array of Uint16s
-             * index_offset / sizeof(Uint16)
-             * convert byte offset to element offset (how many Uint16s in)
-             * + i
-             * add current index being processed
-             *
-             * right side:
-             * cmd.draw_data->indices[i]
-             * original index (0, 1, 2, etc.)
-             * vertex_offset / sizeof(defs::types::vertex::Textured_vertex)
-             * how many vertices came before this text
-             * adding them together adjusts the index to point to correct vertex in combined buffer
-             */
-            for (int i = 0; i < current_glyph->num_indices; ++i) {
-                static_cast<Uint16*>(index_ptr)[(index_offset / sizeof(Uint16)) + i] =
-                    current_glyph->indices[i] +
-                    (vertex_offset / sizeof(defs::types::vertex::Textured_vertex));
-            }
-
-            // update offsets for next glyph
-            vertex_offset +=
-                current_glyph->num_vertices * sizeof(defs::types::vertex::Textured_vertex);
-            index_offset += current_glyph->num_indices * sizeof(Uint16);
-
-            // track totals for this command
-            command_vertex_count += current_glyph->num_vertices;
-            command_index_count += current_glyph->num_indices;
-
-            // move to next glyph
-            current_glyph = current_glyph->next;
+    // every page gets one contiguous index range, index_count restarts as its write cursor
+    Uint32 first_index{0};
+    for (Text_batch& batch : text_batches) {
+        batch.first_index = first_index;
+        first_index += std::exchange(batch.index_count, 0);
+    }
+
+    // 16 bit indices as long as every arena slot is reachable with them
+    const bool wide_indices{text_allocator.get_capacity() > Uint32{1} << 16};
+    text_index_size = wide_indices ? SDL_GPU_INDEXELEMENTSIZE_32BIT
+                                   : SDL_GPU_INDEXELEMENTSIZE_16BIT;
+
+    // the whole list is replaced, so it cycles rather than waiting on frames in flight
+    const size_t index_bytes{total_indices * (wide_indices ? sizeof(Uint32) : sizeof(Uint16))};
+    TRY(ensure_dynamic_buffer(text_indices, SDL_GPU_BUFFERUSAGE_INDEX, index_bytes));
+    std::byte* indices{TRY(upload_ring.stage(text_indices.buffer, 0, index_bytes, true))};
+
+    const auto write{[](auto* destination, const std::vector<Uint32>& source) {
+        using Index = std::remove_pointer_t<decltype(destination)>;
+        for (size_t i{0}; i < source.size(); ++i)
+            destination[i] = static_cast<Index>(source[i]);
+    }};
+
+    for (const Render_text_command& cmd : commands)
+        for (const Text_run& run : text_geometry.at(cmd.text_id).runs) {
+            auto batch{std::ranges::find(text_batches, run.atlas, &Text_batch::atlas)};
+            const Uint32 cursor{batch->first_index + batch->index_count};
+            if (wide_indices)
+                write(reinterpret_cast<Uint32*>(indices) + cursor, run.indices);
+            else
+                write(reinterpret_cast<Uint16*>(indices) + cursor, run.indices);
+
+            batch->index_count += static_cast<Uint32>(run.indices.size());
         }
 
-        // store total counts (all glyphs) for entire command
-        cmd.vertex_count = command_vertex_count;
-        cmd.index_count = command_index_count;
+    return {};
+}
+
+auto Renderer::count_text_vertices(const Render_text_command& command) -> Uint32 {
+    Uint32 vertex_count{0};
+    for (const TTF_GPUAtlasDrawSequence* glyph{command.draw_data}; glyph; glyph = glyph->next)
+        vertex_count += static_cast<Uint32>(glyph->num_vertices);
+    return vertex_count;
+}
+
+auto Renderer::upload_sprite_data(std::vector<Render_sprite_batch>& batches) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::upload_sprite_data");
+
+    size_t total_sprites{0};
+    for (const Render_sprite_batch& batch : batches)
+        total_sprites += batch.sprites.size();
+
+    if (total_sprites == 0)
+        return {};
+
+    // only this frame reads its sprite buffer, no cycling needed
+    const size_t sprite_bytes{total_sprites * sizeof(defs::types::shader::Sprite_instance)};
+    Frame_resources& frame_set{frame()};
+    TRY(ensure_dynamic_buffer(
+        frame_set.sprites, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, sprite_bytes
+    ));
+    auto* sprites{reinterpret_cast<defs::types::shader::Sprite_instance*>(
+        TRY(upload_ring.stage(frame_set.sprites.buffer, 0, sprite_bytes, false))
+    )};
+
+    // batches already hold the shader layout, each one is a single copy
+    Uint32 first_sprite{0};
+    for (Render_sprite_batch& batch : batches) {
+        batch.first_sprite = first_sprite;
+        std::ranges::copy(batch.sprites, sprites + first_sprite);
+        first_sprite += static_cast<Uint32>(batch.sprites.size());
     }
 
-    SDL_UnmapGPUTransferBuffer(device, text_handles.vertex_transfer_buffer);
-    SDL_UnmapGPUTransferBuffer(device, text_handles.index_transfer_buffer);
+    return {};
+}
 
-    // perform copy pass
-    SDL_GPUCopyPass* copy_pass{CHECK_PTR(SDL_BeginGPUCopyPass(current_frame.command_buffer))};
+auto Renderer::upload_particle_data(std::vector<Render_particle_batch>& batches)
+    -> utils::Result<> {
+    PROFILE_ZONE("Renderer::upload_particle_data");
 
-    // locate the data/source
-    const SDL_GPUTransferBufferLocation vertex_source{
-        .transfer_buffer = text_handles.vertex_transfer_buffer,
-        .offset = 0,
-    };
-    const SDL_GPUTransferBufferLocation index_source{
-        .transfer_buffer = text_handles.index_transfer_buffer,
-        .offset = 0,
-    };
+    size_t total_particles{0};
+    for (const Render_particle_batch& batch : batches)
+        total_particles += batch.particles.size();
 
-    // locate upload destination
-    const SDL_GPUBufferRegion vertex_destination{
-        .buffer = text_handles.vertex_buffer,
-        .offset = 0,
-        .size = static_cast<Uint32>(total_vertices * sizeof(defs::types::vertex::Textured_vertex)),
-    };
-    const SDL_GPUBufferRegion index_destination{
-        .buffer = text_handles.index_buffer,
-        .offset = 0,
-        .size = static_cast<Uint32>(total_indices * sizeof(Uint16)),
-    };
+    if (total_particles == 0)
+        return {};
+
+    const size_t particle_bytes{total_particles * sizeof(defs::types::shader::Sprite_instance)};
+    Frame_resources& frame_set{frame()};
+    TRY(ensure_dynamic_buffer(
+        frame_set.particles, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, particle_bytes
+    ));
+    auto* particles{reinterpret_cast<defs::types::shader::Sprite_instance*>(
+        TRY(upload_ring.stage(frame_set.particles.buffer, 0, particle_bytes, false))
+    )};
+
+    Uint32 first_particle{0};
+    for (Render_particle_batch& batch : batches) {
+        batch.first_particle = first_particle;
+        std::ranges::copy(batch.particles, particles + first_particle);
+        first_particle += static_cast<Uint32>(batch.particles.size());
+    }
 
-    // upload the data, end the copy pass, and submit command buffer
-    SDL_UploadToGPUBuffer(copy_pass, &vertex_source, &vertex_destination, true);
-    SDL_UploadToGPUBuffer(copy_pass, &index_source, &index_destination, true);
-    SDL_EndGPUCopyPass(copy_pass);
+    return {};
+}
+
+auto Renderer::upload_debug_lines(
+    const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::upload_debug_lines");
+
+    if (vertices.empty() || not debug_line_pipeline)
+        return {};
+
+    const size_t line_bytes{vertices.size_bytes()};
+    Frame_resources& frame_set{frame()};
+    TRY(ensure_dynamic_buffer(frame_set.debug_lines, SDL_GPU_BUFFERUSAGE_VERTEX, line_bytes));
+    std::byte* staged{TRY(upload_ring.stage(frame_set.debug_lines.buffer, 0, line_bytes, false))};
+    std::memcpy(staged, vertices.data(), line_bytes);
 
     return {};
 }
 
-auto Renderer::make_glyph_vertices(const TTF_GPUAtlasDrawSequence& glyph)
-    -> std::vector<defs::types::vertex::Textured_vertex> {
+auto Renderer::write_glyph_vertices(
+    const TTF_GPUAtlasDrawSequence& glyph, const glm::mat4& model_matrix,
+    const std::span<defs::types::vertex::Textured_vertex> destination
+) -> void {
+    static_assert(sizeof(defs::types::vertex::Textured_vertex) == 8 * sizeof(float));
+
+    // glyphs sit at z = 0, only the 2d affine part of the model matrix reaches them
+    const glm::vec2 axis_x{model_matrix[0]};
+    const glm::vec2 axis_y{model_matrix[1]};
+    const glm::vec2 origin{model_matrix[3]};
+    const auto vertex_count{static_cast<size_t>(glyph.num_vertices)};
+
+    size_t i{0};
+#if defined(GLYPH_SSE2)
+    // two vertices per step, both positions transform in one register, then each is
+    // interleaved with the constant color and its uv into two 16 byte stores
+    const __m128 column_x{_mm_setr_ps(axis_x.x, axis_x.y, axis_x.x, axis_x.y)};
+    const __m128 column_y{_mm_setr_ps(axis_y.x, axis_y.y, axis_y.x, axis_y.y)};
+    const __m128 translation{_mm_setr_ps(origin.x, origin.y, origin.x, origin.y)};
+    const __m128 white{_mm_set1_ps(1.0F)};
+    auto* out{reinterpret_cast<float*>(destination.data())};
+
+    for (; i + 2 <= vertex_count; i += 2) {
+        const __m128 xy{_mm_loadu_ps(&glyph.xy[i].x)};    // x0 y0 x1 y1
+        const __m128 uv{_mm_loadu_ps(&glyph.uv[i].x)};
+        const __m128 xx{_mm_shuffle_ps(xy, xy, _MM_SHUFFLE(2, 2, 0, 0))};
+        const __m128 yy{_mm_shuffle_ps(xy, xy, _MM_SHUFFLE(3, 3, 1, 1))};
+        const __m128 world{_mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(xx, column_x), _mm_mul_ps(yy, column_y)), translation
+        )};
+
+        float* vertex{out + (i * 8)};
+        _mm_storeu_ps(vertex, _mm_movelh_ps(world, white));         // x0 y0 r g
+        _mm_storeu_ps(vertex + 4, _mm_movelh_ps(white, uv));        // b a u0 v0
+        _mm_storeu_ps(vertex + 8, _mm_movehl_ps(white, world));     // x1 y1 r g
+        _mm_storeu_ps(vertex + 12, _mm_shuffle_ps(white, uv, _MM_SHUFFLE(3, 2, 1, 0)));
+    }
+#endif
 
-    std::vector<defs::types::vertex::Textured_vertex> vertices{};
-    for (int i = 0; i < glyph.num_vertices; ++i) {
-        const defs::types::vertex::Textured_vertex vertex{
-            .position = {glyph.xy[i].x, glyph.xy[i].y},
+    for (; i < vertex_count; ++i) {
+        const glm::vec2 xy{glyph.xy[i].x, glyph.xy[i].y};
+        destination[i] = {
+            .position = origin + (axis_x * xy.x) + (axis_y * xy.y),
             .color = {1.0F, 1.0F, 1.0F, 1.0F},    // TODO: how to get color data? do i?
             .uv = {glyph.uv[i].x, glyph.uv[i].y},
         };
-
-        vertices.push_back(vertex);
     }
-    return vertices;
 }
 
-auto Renderer::ensure_text_buffer_capacity(const size_t vertex_count, const size_t index_count)
-    -> utils::Result<> {
-    const size_t needed_vertex_size{vertex_count * sizeof(defs::types::vertex::Textured_vertex)};
-    const size_t needed_index_size{index_count * sizeof(Uint16)};
+auto Renderer::create_instanced_pipeline(
+    const std::string_view shader_name, const SDL_GPUGraphicsPipelineCreateInfo& create_info
+) const -> utils::Result<SDL_GPUGraphicsPipeline*> {
+
+    // only the vertex stage differs, the fragment stage comes from create_info
+    const auto shaders{
+        TRY(defs::assets::shaders::get_shader_set_file_names(std::string(shader_name)))
+    };
+    SDL_GPUShader* vert_shader{TRY(gpu->create_shader(*resource_manager, shaders[0]))};
+
+    auto instanced_info{create_info};
+    instanced_info.vertex_shader = vert_shader;
+    SDL_GPUGraphicsPipeline* pipeline{gpu->create_graphics_pipeline(instanced_info)};
+
+    gpu->release_shader(vert_shader);
+    if (not pipeline)
+        return std::unexpected(SDL_GetError());
+
+    return pipeline;
+}
 
-    // grow buffers if needed (with some headroom)
-    if (needed_vertex_size > text_vertex_buffer_size) {
+auto Renderer::create_transparent_pipelines(
+    const defs::pipelines::Desc& desc, const SDL_GPUGraphicsPipelineCreateInfo& create_info,
+    Built_pipeline& built
+) const -> utils::Result<> {
+
+    // same shaders and targets, blended and without depth writes
+    std::vector<SDL_GPUColorTargetDescription> color_target_descriptions(
+        create_info.target_info.color_target_descriptions,
+        create_info.target_info.color_target_descriptions +
+            create_info.target_info.num_color_targets
+    );
+    for (auto& [_, blend_state] : color_target_descriptions)
+        blend_state = defs::pipelines::descriptors::blend::alpha;
+
+    auto transparent_info{create_info};
+    transparent_info.target_info.color_target_descriptions = color_target_descriptions.data();
+    transparent_info.depth_stencil_state = defs::pipelines::descriptors::depth::transparent;
+
+    built.transparent = CHECK_PTR(gpu->create_graphics_pipeline(transparent_info));
+
+    if (built.instanced)
+        built.transparent_instanced =
+            TRY(create_instanced_pipeline(desc.instanced_shader_name, transparent_info));
+
+    return {};
+}
 
-        // size_t new_size{needed_vertex_size * 2};
-        // if (new_size >= UINT32_MAX)
-        //     return std::unexpected("Buffer size exceeds SDL limits");
+auto Renderer::prepare_mesh_batches(const Render_queue& queue) -> utils::Result<> {
+    PROFILE_ZONE("Renderer::prepare_mesh_batches");
 
-        const size_t new_size{VALID_SDL_SIZE(needed_vertex_size * 2)};
-        TRY(create_text_vertex_buffers(new_size));
+    // both passes share the instance buffer, transparent instances follow the opaque ones
+    Uint32 instance_count{0};
+    sort_mesh_pass(queue.opaque_commands, queue.opaque_order, opaque_pass, instance_count);
+    sort_mesh_pass(queue.transparent_commands, {}, transparent_pass, instance_count);
+
+    if (instance_count == 0)
+        return {};
+
+    // only this frame reads its instance buffer, no cycling needed
+    const size_t instance_bytes{instance_count * sizeof(defs::types::shader::Mesh_instance)};
+    Frame_resources& frame_set{frame()};
+    TRY(ensure_dynamic_buffer(
+        frame_set.mesh_instances, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, instance_bytes
+    ));
+    auto* instances{reinterpret_cast<defs::types::shader::Mesh_instance*>(
+        TRY(upload_ring.stage(frame_set.mesh_instances.buffer, 0, instance_bytes, false))
+    )};
+
+    for (const Mesh_pass* pass : {&opaque_pass, &transparent_pass})
+        for (const Mesh_batch& batch : pass->batches) {
+            if (not batch.instanced)
+                continue;
+
+            for (Uint32 i{0}; i < batch.command_count; ++i)
+                instances[batch.first_instance + i] =
+                    make_mesh_instance(pass->commands[batch.first_command + i]);
+        }
+
+    return {};
+}
+
+auto Renderer::sort_mesh_pass(
+    const std::vector<Render_mesh_command>& commands,
+    const std::span<const sort_key::Entry> presorted, Mesh_pass& pass, Uint32& instance_count
+) -> void {
+
+    pass.batches.clear();
+    pass.commands.clear();
+    if (commands.empty())
+        return;
+
+    // commands whose pipeline is still compiling are skipped this frame
+    if (presorted.size() == commands.size()) {
+        for (const sort_key::Entry& entry : presorted)
+            if (pipelines.contains(commands[entry.index].pipeline_id))
+                pass.commands.push_back(commands[entry.index]);
+    } else {
+        // a key per command, sorted without allocating once the buffers have grown
+        sort_entries.clear();
+        for (size_t i{0}; i < commands.size(); ++i) {
+            const Render_mesh_command& cmd{commands[i]};
+            if (not pipelines.contains(cmd.pipeline_id))
+                continue;
+
+            const Uint32 depth{sort_key::quantize_depth(cmd.depth)};
+            sort_entries.push_back({
+                .key = pass.transparent ? sort_key::encode_back_to_front(
+                                              sort_key::Pass::Transparent, cmd.pipeline_id, 0,
+                                              cmd.mesh_id, depth
+                                          )
+                                        : sort_key::encode(
+                                              sort_key::Pass::Opaque, cmd.pipeline_id, 0,
+                                              cmd.mesh_id, depth
+                                          ),
+                .index = static_cast<Uint32>(i),
+            });
+        }
+        sort_scratch.resize(sort_entries.size());
+        sort_key::radix_sort(sort_entries, sort_scratch);
+
+        for (const sort_key::Entry& entry : sort_entries)
+            pass.commands.push_back(commands[entry.index]);
     }
 
-    if (needed_index_size > text_index_buffer_size) {
-        const size_t new_size{VALID_SDL_SIZE(needed_index_size * 2)};
-        TRY(create_text_index_buffers(new_size));
+    // every run of consecutive commands sharing pipeline and mesh becomes one batch, real
+    // ids are compared in case they were too wide for their key fields
+    const auto& instanced{pass.transparent ? transparent_instanced_pipelines : instanced_pipelines};
+    for (size_t first{0}; first < pass.commands.size();) {
+        const Render_mesh_command& head{pass.commands[first]};
+        size_t last{first + 1};
+        while (last < pass.commands.size() &&
+               pass.commands[last].pipeline_id == head.pipeline_id &&
+               pass.commands[last].mesh_id == head.mesh_id)
+            ++last;
+
+        const bool batch_instanced{instanced.contains(head.pipeline_id)};
+        pass.batches.push_back({
+            .pipeline_id = head.pipeline_id,
+            .mesh_id = head.mesh_id,
+            .first_command = static_cast<Uint32>(first),
+            .command_count = static_cast<Uint32>(last - first),
+            .first_instance = instance_count,
+            .instanced = batch_instanced,
+        });
+        if (batch_instanced)
+            instance_count += static_cast<Uint32>(last - first);
+
+        first = last;
     }
+}
 
-    return {};
+auto Renderer::get_batch_pipeline(const Mesh_pass& pass, const Mesh_batch& batch) const
+    -> utils::Result<SDL_GPUGraphicsPipeline*> {
+
+    if (batch.instanced)
+        return (pass.transparent ? transparent_instanced_pipelines : instanced_pipelines)
+            .at(batch.pipeline_id);
+
+    // pipelines without a transparent variant still draw, just without blending
+    if (pass.transparent)
+        if (const auto it{transparent_pipelines.find(batch.pipeline_id)};
+            it != transparent_pipelines.end())
+            return it->second;
+
+    return get_pipeline(batch.pipeline_id);
+}
+auto Renderer::make_mesh_instance(const Render_mesh_command& command)
+    -> defs::types::shader::Mesh_instance {
+
+    // 2d objects only use the upper left 2x2 and the translation column
+    const glm::mat4& model{command.model_matrix};
+    return {
+        .basis = {model[0].x, model[0].y, model[1].x, model[1].y},
+        .translation = {model[3].x, model[3].y, std::clamp(command.depth, 0.0F, 1.0F), 0.0F},
+        .tint = command.tint,
+    };
 }
 
 auto Renderer::get_pipeline(Uint32 pipeline_id) const -> utils::Result<SDL_GPUGraphicsPipeline*> {
@@ -731,9 +1727,16 @@ auto Renderer::get_pipeline(Uint32 pipeline_id) const -> utils::Result<SDL_GPUGr
                : std::unexpected(std::format("Pipeline '{}' not found", pipeline_id));
 }
 
-auto Renderer::get_buffers(Uint32 mesh_id) const -> utils::Result<const Buffer_handles*> {
-    const auto mesh_it{mesh_to_buffers.find(mesh_id)};
-    return (mesh_it != mesh_to_buffers.end())
-               ? utils::Result<const Buffer_handles*>{&mesh_it->second}
+auto Renderer::get_gpu_mesh(Uint32 mesh_id) const -> utils::Result<const Gpu_mesh*> {
+    const auto mesh_it{gpu_meshes.find(mesh_id)};
+    return (mesh_it != gpu_meshes.end())
+               ? utils::Result<const Gpu_mesh*>{&mesh_it->second}
                : std::unexpected(std::format("Mesh ID '{}' not found", mesh_id));
 }
+
+auto Renderer::get_texture(Uint32 texture_id) const -> utils::Result<SDL_GPUTexture*> {
+    const auto texture_it{textures.find(texture_id)};
+    return (texture_it != textures.end())
+               ? utils::Result<SDL_GPUTexture*>{texture_it->second}
+               : std::unexpected(std::format("Texture '{}' not found", texture_id));
+}
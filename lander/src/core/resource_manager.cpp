@@ -1,11 +1,17 @@
 
 
+#include <profiler.h>
 #include <resource_manager.h>
 
+#include <glm/glm/common.hpp>
+#include <glm/glm/geometric.hpp>
+#include <cmath>
+
 auto Resource_manager::init() -> utils::Result<> {
     // loaded_files = {};
     fonts = {};
     sounds = {};
+    shader_cache.init(defs::paths::base_path / defs::paths::shader_cache_path);
 
     return {};
 }
@@ -19,12 +25,23 @@ auto Resource_manager::quit(SDL_GPUDevice* gpu_device) -> void {
         TTF_CloseFont(font);
     fonts.clear();
 
+    for (auto& [name, image] : images)
+        SDL_DestroySurface(image);
+    images.clear();
+
     for (auto& [name, shader] : shaders)
         SDL_ReleaseGPUShader(gpu_device, shader);
+
+    // views point into the mapped files, drop them first
+    mesh_views.clear();
+    levels.clear();
+    level_files.clear();
 }
 
 auto Resource_manager::load_font(const std::string& file_name, float size)
     -> utils::Result<TTF_Font*> {
+    PROFILE_ZONE("Resource_manager::load_font");
+
     TTF_Font* font{
         CHECK_PTR(TTF_OpenFont(defs::paths::get_full_path(file_name)->string().c_str(), size))
     };
@@ -33,6 +50,8 @@ auto Resource_manager::load_font(const std::string& file_name, float size)
 }
 
 auto Resource_manager::load_sound(const std::string& file_name) -> utils::Result<MIX_Audio*> {
+    PROFILE_ZONE("Resource_manager::load_sound");
+
     // may need to specify mixer here...
     MIX_Audio* sound{CHECK_PTR(
         MIX_LoadAudio(nullptr, defs::paths::get_full_path(file_name)->string().c_str(), true)
@@ -42,9 +61,35 @@ auto Resource_manager::load_sound(const std::string& file_name) -> utils::Result
     return sound;
 }
 
+auto Resource_manager::load_image(const std::string& file_name) -> utils::Result<SDL_Surface*> {
+    PROFILE_ZONE("Resource_manager::load_image");
+
+    SDL_Surface* loaded{
+        CHECK_PTR(IMG_Load(TRY(defs::paths::get_full_path(file_name)).string().c_str()))
+    };
+
+    // gpu textures want one known layout, whatever the file stored
+    SDL_Surface* image{SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_ABGR8888)};
+    SDL_DestroySurface(loaded);
+    if (not image)
+        return std::unexpected(SDL_GetError());
+
+    images[file_name] = image;
+    return image;
+}
+
 auto Resource_manager::load_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
     -> utils::Result<SDL_GPUShader*> {
 
+    SDL_GPUShader* shader{TRY(create_shader(gpu_device, file_name))};
+    shaders[file_name] = shader;
+    return shader;
+}
+
+auto Resource_manager::create_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
+    -> utils::Result<SDL_GPUShader*> {
+    PROFILE_ZONE("Resource_manager::create_shader");
+
     // auto-detect the shader stage from file name for convenience
     SDL_ShaderCross_ShaderStage stage;
     if (file_name.contains(".vert"))
@@ -62,34 +107,36 @@ auto Resource_manager::load_shader(SDL_GPUDevice* gpu_device, const std::string&
         CHECK_PTR(SDL_LoadFile(defs::paths::get_full_path(file_name)->string().c_str(), &code_size))
     };
 
-    // create the vertex/fragment shader
-    SDL_ShaderCross_SPIRV_Info shader_info{
-        .bytecode = static_cast<Uint8*>(code),
-        .bytecode_size = code_size,
-        .entrypoint = "main",
-        .shader_stage = stage,
-    };
-
-    // figure out shader metadata
-    SDL_ShaderCross_GraphicsShaderMetadata* shader_metadata{
-        SDL_ShaderCross_ReflectGraphicsSPIRV(shader_info.bytecode, shader_info.bytecode_size, 0)
-    };
-
-    // cross compile to appropriate format and create object
-    SDL_GPUShader* shader{CHECK_PTR(
-        SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(
-            gpu_device, &shader_info, shader_metadata, 0
-        ),
-        "Failed to create shader"
+    // create the vertex/fragment shader, reflection and cross compiling only happen when
+    // the cache has no entry for this code on this backend
+    auto shader{shader_cache.load(
+        gpu_device, file_name, {static_cast<const Uint8*>(code), code_size}, stage
     )};
     // free resources no longer needed
-    SDL_free(shader_metadata);
     SDL_free(code);
 
-    shaders[file_name] = shader;
     return shader;
 }
 
+auto Resource_manager::load_level(const std::string& file_name)
+    -> utils::Result<const level_file::Level_view*> {
+    PROFILE_ZONE("Resource_manager::load_level");
+
+    if (const auto it{levels.find(file_name)}; it != levels.end())
+        return &it->second;
+
+    // TRY would copy, and the mapping is move only
+    auto file{Mapped_file::open(TRY(defs::paths::get_full_path(file_name)))};
+    if (not file)
+        return std::unexpected(file.error());
+
+    const level_file::Level_view view{TRY(level_file::read(file->bytes()))};
+
+    // moving the mapping keeps its address, so the view stays valid
+    level_files[file_name] = std::move(*file);
+    return &(levels[file_name] = view);
+}
+
 auto Resource_manager::create_mesh(
     const std::string& mesh_name, const defs::types::vertex::Mesh_data& vertices
 ) -> utils::Result<Uint32> {
@@ -101,6 +148,7 @@ auto Resource_manager::create_mesh(
     const Uint32 mesh_id{next_mesh_id++};
     mesh_ids[mesh_name] = mesh_id;
     meshes[mesh_id] = vertices;
+    fit_mesh_bounds(mesh_id, vertices, true);
 
     return utils::Result<Uint32>{mesh_id};
 }
@@ -109,6 +157,13 @@ auto Resource_manager::update_mesh(
     const Uint32 mesh_id, const defs::types::vertex::Mesh_data& vertices
 ) -> utils::Result<Uint32> {
 
+    // a view is replaced outright, no point copying it first
+    if (mesh_views.erase(mesh_id) != 0) {
+        meshes[mesh_id] = vertices;
+        fit_mesh_bounds(mesh_id, vertices, true);
+        return mesh_id;
+    }
+
     auto data{get_mesh_data(mesh_id)};
 
     if (not data)
@@ -117,6 +172,71 @@ auto Resource_manager::update_mesh(
     data.value()->clear();
     // data.value() = {vertices};
     data.value()->assign(vertices.begin(), vertices.end());
+    fit_mesh_bounds(mesh_id, vertices, true);
+
+    return mesh_id;
+}
+
+auto Resource_manager::update_mesh_range(
+    const Uint32 mesh_id, const size_t first_vertex, const size_t replaced_count,
+    const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> utils::Result<size_t> {
+
+    defs::types::vertex::Mesh_data* data{TRY(get_mesh_data(mesh_id))};
+
+    if (first_vertex + replaced_count > data->size())
+        return std::unexpected(
+            std::format(
+                "Mesh '{}' range {}+{} out of bounds ({} vertices)", mesh_id, first_vertex,
+                replaced_count, data->size()
+            )
+        );
+
+    const auto first{data->begin() + static_cast<ptrdiff_t>(first_vertex)};
+
+    // only widens, the replaced vertices may have been the extremes but culling stays safe
+    fit_mesh_bounds(mesh_id, vertices, false);
+
+    // same size is an in place copy, otherwise everything after the range shifts
+    if (vertices.size() == replaced_count) {
+        std::ranges::copy(vertices, first);
+        return vertices.size();
+    }
+
+    data->erase(first, first + static_cast<ptrdiff_t>(replaced_count));
+    data->insert(
+        data->begin() + static_cast<ptrdiff_t>(first_vertex), vertices.begin(), vertices.end()
+    );
+
+    return data->size() - first_vertex;
+}
+
+auto Resource_manager::create_mesh_view(
+    const std::string& mesh_name, const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> utils::Result<Uint32> {
+
+    // only create new, do not overwrite
+    if (get_mesh_id(mesh_name))
+        return std::unexpected(std::format("Mesh '{}' already registered", mesh_name));
+
+    const Uint32 mesh_id{next_mesh_id++};
+    mesh_ids[mesh_name] = mesh_id;
+    mesh_views[mesh_id] = vertices;
+    fit_mesh_bounds(mesh_id, vertices, true);
+
+    return utils::Result<Uint32>{mesh_id};
+}
+
+auto Resource_manager::set_mesh_view(
+    const Uint32 mesh_id, const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> utils::Result<Uint32> {
+
+    if (not meshes.contains(mesh_id) && not mesh_views.contains(mesh_id))
+        return std::unexpected(std::format("Mesh '{}' not found", mesh_id));
+
+    meshes.erase(mesh_id);
+    mesh_views[mesh_id] = vertices;
+    fit_mesh_bounds(mesh_id, vertices, true);
 
     return mesh_id;
 }
@@ -133,20 +253,52 @@ auto Resource_manager::get_sound(const std::string& file_name) -> utils::Result<
                                 : std::unexpected(std::format("Sound '{}' not found", file_name));
 }
 
+auto Resource_manager::get_image(const std::string& file_name) -> utils::Result<SDL_Surface*> {
+    const auto it{images.find(file_name)};
+    return (it != images.end()) ? utils::Result<SDL_Surface*>{it->second}
+                                : std::unexpected(std::format("Image '{}' not found", file_name));
+}
+
 auto Resource_manager::get_shader(const std::string& file_name) -> utils::Result<SDL_GPUShader*> {
     const auto it{shaders.find(file_name)};
     return (it != shaders.end()) ? utils::Result<SDL_GPUShader*>{it->second}
                                  : std::unexpected(std::format("Shader '{}' not found", file_name));
 }
 
+auto Resource_manager::get_level(const std::string& file_name) const
+    -> utils::Result<const level_file::Level_view*> {
+    const auto it{levels.find(file_name)};
+    return (it != levels.end()) ? utils::Result<const level_file::Level_view*>{&it->second}
+                                : std::unexpected(std::format("Level '{}' not found", file_name));
+}
+
 auto Resource_manager::get_mesh_id(const std::string& mesh_name) -> utils::Result<Uint32> {
     const auto it{mesh_ids.find(mesh_name)};
     return (it != mesh_ids.end()) ? utils::Result<Uint32>{it->second}
                                   : std::unexpected(std::format("Mesh '{}' not found", mesh_name));
 }
 
+auto Resource_manager::get_mesh_vertices(const Uint32 mesh_id) const
+    -> utils::Result<std::span<const defs::types::vertex::Mesh_vertex>> {
+    if (const auto it{mesh_views.find(mesh_id)}; it != mesh_views.end())
+        return it->second;
+
+    const auto it{meshes.find(mesh_id)};
+    return (it != meshes.end())
+               ? utils::Result<std::span<const defs::types::vertex::Mesh_vertex>>{it->second}
+               : std::unexpected(std::format("Mesh '{}' not found", mesh_id));
+}
+
 auto Resource_manager::get_mesh_data(const Uint32 mesh_id)
     -> utils::Result<defs::types::vertex::Mesh_data*> {
+    // copy on write, the mapped file is read only
+    if (const auto view{mesh_views.find(mesh_id)}; view != mesh_views.end()) {
+        defs::types::vertex::Mesh_data& data{meshes[mesh_id]};
+        data.assign(view->second.begin(), view->second.end());
+        mesh_views.erase(view);
+        return &data;
+    }
+
     const auto it{meshes.find(mesh_id)};
     return (it != meshes.end()) ? utils::Result<defs::types::vertex::Mesh_data*>{&it->second}
                                 : std::unexpected(std::format("Mesh '{}' not found", mesh_id));
@@ -154,9 +306,10 @@ auto Resource_manager::get_mesh_data(const Uint32 mesh_id)
 
 auto Resource_manager::get_mesh_data_copy(const Uint32 mesh_id) const
     -> utils::Result<defs::types::vertex::Mesh_data> {
-    const auto it{meshes.find(mesh_id)};
-    return (it != meshes.end()) ? utils::Result<defs::types::vertex::Mesh_data>{it->second}
-                                : std::unexpected(std::format("Mesh '{}' not found", mesh_id));
+    const std::span<const defs::types::vertex::Mesh_vertex> vertices{
+        TRY(get_mesh_vertices(mesh_id))
+    };
+    return defs::types::vertex::Mesh_data{vertices.begin(), vertices.end()};
 }
 
 // auto Renderer::get_buffers(Uint32 mesh_id) const -> utils::Result<const Buffer_handles*> {
@@ -166,6 +319,33 @@ auto Resource_manager::get_mesh_data_copy(const Uint32 mesh_id) const
 //     : std::unexpected(std::format("Mesh ID '{}' not found", mesh_id));
 // }
 
+auto Resource_manager::fit_mesh_bounds(
+    const Uint32 mesh_id, const std::span<const defs::types::vertex::Mesh_vertex> vertices,
+    const bool reset
+) -> void {
+    if (mesh_bounds.size() <= mesh_id)
+        mesh_bounds.resize(size_t{mesh_id} + 1);
+
+    defs::types::vertex::Mesh_bounds& bounds{mesh_bounds[mesh_id]};
+    if (reset)
+        bounds = {};
+    if (vertices.empty())
+        return;
+
+    // nothing fitted yet starts from the first vertex rather than the origin
+    const bool fitted{not std::isinf(bounds.radius)};
+    glm::vec2 low{fitted ? bounds.min : vertices.front().position};
+    glm::vec2 high{fitted ? bounds.max : vertices.front().position};
+    for (const auto& [position, _] : vertices) {
+        low = glm::min(low, position);
+        high = glm::max(high, position);
+    }
+
+    bounds.min = low;
+    bounds.max = high;
+    bounds.radius = glm::length(high - bounds.center());
+}
+
 auto Resource_manager::release_shader(SDL_GPUDevice* gpu_device, const std::string& file_name)
     -> utils::Result<SDL_GPUShader*> {
     SDL_GPUShader* shader{TRY(get_shader(file_name))};
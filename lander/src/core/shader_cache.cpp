@@ -0,0 +1,295 @@
+
+
+#include <mapped_file.h>
+#include <profiler.h>
+#include <shader_cache.h>
+
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+    // fnv-1a, only has to tell shader versions apart, not resist anyone
+    constexpr Uint64 fnv_offset{0xCBF29CE484222325};
+    constexpr Uint64 fnv_prime{0x100000001B3};
+
+    auto hash_bytes(const std::span<const Uint8> bytes, Uint64 hash = fnv_offset) -> Uint64 {
+        for (const Uint8 byte : bytes)
+            hash = (hash ^ byte) * fnv_prime;
+        return hash;
+    }
+
+    auto hash_string(const std::string_view text, const Uint64 hash) -> Uint64 {
+        return hash_bytes({reinterpret_cast<const Uint8*>(text.data()), text.size()}, hash);
+    }
+
+    auto hash_value(const Uint32 value, const Uint64 hash) -> Uint64 {
+        return hash_bytes({reinterpret_cast<const Uint8*>(&value), sizeof(value)}, hash);
+    }
+
+    // the native formats we can produce ourselves, in order of preference
+    // vulkan takes the spir-v as is, the cache then only saves the reflection
+    auto pick_format(SDL_GPUDevice* gpu_device) -> SDL_GPUShaderFormat {
+        const SDL_GPUShaderFormat formats{SDL_GetGPUShaderFormats(gpu_device)};
+        for (const SDL_GPUShaderFormat format :
+             {SDL_GPU_SHADERFORMAT_SPIRV, SDL_GPU_SHADERFORMAT_DXIL, SDL_GPU_SHADERFORMAT_MSL})
+            if (formats & format)
+                return format;
+
+        return SDL_GPU_SHADERFORMAT_INVALID;
+    }
+
+    auto to_gpu_stage(const SDL_ShaderCross_ShaderStage stage)
+        -> utils::Result<SDL_GPUShaderStage> {
+        switch (stage) {
+            case SDL_SHADERCROSS_SHADERSTAGE_VERTEX:
+                return SDL_GPU_SHADERSTAGE_VERTEX;
+            case SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT:
+                return SDL_GPU_SHADERSTAGE_FRAGMENT;
+            default:
+                return std::unexpected("Only graphics shaders can be cached");
+        }
+    }
+
+    // spirv-cross renames main, msl reserves it
+    auto entrypoint(const SDL_GPUShaderFormat format) -> const char* {
+        return format == SDL_GPU_SHADERFORMAT_MSL ? "main0" : "main";
+    }
+
+    auto create_shader(
+        SDL_GPUDevice* gpu_device, const Shader_cache::Entry_header& header, const void* code
+    ) -> utils::Result<SDL_GPUShader*> {
+
+        const SDL_GPUShaderCreateInfo shader_info{
+            .code_size = static_cast<size_t>(header.code_bytes),
+            .code = static_cast<const Uint8*>(code),
+            .entrypoint = entrypoint(header.format),
+            .format = header.format,
+            .stage = static_cast<SDL_GPUShaderStage>(header.stage),
+            .num_samplers = header.num_samplers,
+            .num_storage_textures = header.num_storage_textures,
+            .num_storage_buffers = header.num_storage_buffers,
+            .num_uniform_buffers = header.num_uniform_buffers,
+        };
+        return CHECK_PTR(SDL_CreateGPUShader(gpu_device, &shader_info), "Failed to create shader");
+    }
+
+    auto to_us(const Uint64 ns) -> double {
+        return static_cast<double>(ns) / 1'000.0;
+    }
+
+}    // namespace
+
+auto Shader_cache::init(const std::filesystem::path& cache_directory) -> void {
+    std::error_code error{};
+    std::filesystem::create_directories(cache_directory, error);
+    if (error) {
+        utils::log(std::format(
+            "Shader cache disabled, failed to create '{}': {}", cache_directory.string(),
+            error.message()
+        ));
+        directory.clear();
+        return;
+    }
+
+    directory = cache_directory;
+}
+
+auto Shader_cache::load(
+    SDL_GPUDevice* gpu_device, const std::string& name, const std::span<const Uint8> spirv,
+    const SDL_ShaderCross_ShaderStage stage
+) -> utils::Result<SDL_GPUShader*> {
+    PROFILE_ZONE("Shader_cache::load");
+
+    const Uint64 start{SDL_GetTicksNS()};
+    const SDL_GPUShaderFormat format{pick_format(gpu_device)};
+    const SDL_GPUShaderStage gpu_stage{TRY(to_gpu_stage(stage))};
+
+    // nothing we can store for this backend, let shadercross handle it every time
+    if (directory.empty() || format == SDL_GPU_SHADERFORMAT_INVALID) {
+        SDL_ShaderCross_GraphicsShaderMetadata* metadata{CHECK_PTR(
+            SDL_ShaderCross_ReflectGraphicsSPIRV(spirv.data(), spirv.size(), 0),
+            "Failed to reflect shader"
+        )};
+        const SDL_ShaderCross_SPIRV_Info shader_info{
+            .bytecode = spirv.data(),
+            .bytecode_size = spirv.size(),
+            .entrypoint = "main",
+            .shader_stage = stage,
+        };
+        SDL_GPUShader* shader{
+            SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(gpu_device, &shader_info, metadata, 0)
+        };
+        SDL_free(metadata);
+        return CHECK_PTR(shader, "Failed to create shader");
+    }
+
+    Uint64 key{hash_bytes(spirv)};
+    key = hash_value(static_cast<Uint32>(gpu_stage), key);
+    key = hash_value(format, key);
+    key = hash_string(SDL_GetGPUDeviceDriver(gpu_device), key);
+    // another shadercross release may translate the same spir-v differently
+    key = hash_value(SDL_SHADERCROSS_MAJOR_VERSION, key);
+    key = hash_value(SDL_SHADERCROSS_MINOR_VERSION, key);
+    key = hash_value(SDL_SHADERCROSS_MICRO_VERSION, key);
+    const std::filesystem::path path{directory / std::format("{:016x}.shader", key)};
+
+    // a hit only trusts entries that match the key exactly, anything else is rebuilt
+    if (std::filesystem::exists(path)) {
+        auto file{Mapped_file::open(path)};
+        if (file && file->bytes().size() >= sizeof(Entry_header)) {
+            Entry_header header{};
+            std::memcpy(&header, file->bytes().data(), sizeof(Entry_header));
+
+            if (header.magic == magic && header.version == version && header.key == key &&
+                header.format == format && header.stage == gpu_stage &&
+                header.code_bytes == file->bytes().size() - sizeof(Entry_header)) {
+
+                SDL_GPUShader* shader{TRY(
+                    create_shader(gpu_device, header, file->bytes().data() + sizeof(Entry_header))
+                )};
+
+                const Uint64 elapsed{SDL_GetTicksNS() - start};
+                const Uint64 saved{header.compile_ns > elapsed ? header.compile_ns - elapsed : 0};
+                {
+                    const std::scoped_lock lock{stats_mutex};
+                    ++hits;
+                    saved_ns += saved;
+                }
+                utils::log(std::format(
+                    "Shader '{}' cache hit in {:.1f} us, saved {:.1f} us", name, to_us(elapsed),
+                    to_us(saved)
+                ));
+                return shader;
+            }
+        }
+    }
+
+    Compiled compiled{TRY(compile(spirv, stage, format))};
+    compiled.header.key = key;
+    compiled.header.stage = gpu_stage;
+
+    auto shader{create_shader(gpu_device, compiled.header, compiled.code)};
+    if (shader) {
+        compiled.header.compile_ns = SDL_GetTicksNS() - start;
+        // a failed write only costs the next launch a miss
+        if (auto written = write_entry(path, compiled); not written)
+            utils::log(std::format("Shader '{}' not cached: {}", name, written.error()));
+    }
+    SDL_free(compiled.code);
+
+    if (not shader)
+        return std::unexpected(shader.error());
+
+    {
+        const std::scoped_lock lock{stats_mutex};
+        ++misses;
+    }
+    utils::log(std::format(
+        "Shader '{}' cache miss, compiled in {:.1f} us", name, to_us(compiled.header.compile_ns)
+    ));
+    return *shader;
+}
+
+auto Shader_cache::log_stats() const -> void {
+    const std::scoped_lock lock{stats_mutex};
+    utils::log(std::format(
+        "Shader cache: {} hits, {} misses, {:.1f} ms saved", hits, misses,
+        static_cast<double>(saved_ns) / 1'000'000.0
+    ));
+}
+
+auto Shader_cache::hit_count() const -> int {
+    const std::scoped_lock lock{stats_mutex};
+    return hits;
+}
+
+auto Shader_cache::miss_count() const -> int {
+    const std::scoped_lock lock{stats_mutex};
+    return misses;
+}
+
+auto Shader_cache::compile(
+    const std::span<const Uint8> spirv, const SDL_ShaderCross_ShaderStage stage,
+    const SDL_GPUShaderFormat format
+) -> utils::Result<Compiled> {
+    PROFILE_ZONE("Shader_cache::compile");
+
+    SDL_ShaderCross_GraphicsShaderMetadata* metadata{CHECK_PTR(
+        SDL_ShaderCross_ReflectGraphicsSPIRV(spirv.data(), spirv.size(), 0),
+        "Failed to reflect shader"
+    )};
+    Compiled compiled{
+        .header = {
+            .magic = magic,
+            .version = version,
+            .format = format,
+            .num_samplers = metadata->num_samplers,
+            .num_storage_textures = metadata->num_storage_textures,
+            .num_storage_buffers = metadata->num_storage_buffers,
+            .num_uniform_buffers = metadata->num_uniform_buffers,
+        },
+    };
+    SDL_free(metadata);
+
+    const SDL_ShaderCross_SPIRV_Info shader_info{
+        .bytecode = spirv.data(),
+        .bytecode_size = spirv.size(),
+        .entrypoint = "main",
+        .shader_stage = stage,
+    };
+
+    size_t code_bytes{0};
+    if (format == SDL_GPU_SHADERFORMAT_SPIRV) {
+        compiled.code = SDL_malloc(spirv.size());
+        if (compiled.code)
+            std::memcpy(compiled.code, spirv.data(), spirv.size());
+        code_bytes = spirv.size();
+    } else if (format == SDL_GPU_SHADERFORMAT_DXIL) {
+        compiled.code = SDL_ShaderCross_CompileDXILFromSPIRV(&shader_info, &code_bytes);
+    } else if (format == SDL_GPU_SHADERFORMAT_MSL) {
+        compiled.code = SDL_ShaderCross_TranspileMSLFromSPIRV(&shader_info);
+        if (compiled.code)
+            code_bytes = std::strlen(static_cast<const char*>(compiled.code));
+    }
+
+    if (not compiled.code)
+        return std::unexpected(std::format("Failed to cross compile shader: {}", SDL_GetError()));
+    compiled.header.code_bytes = code_bytes;
+
+    return compiled;
+}
+
+auto Shader_cache::write_entry(const std::filesystem::path& path, const Compiled& compiled) const
+    -> utils::Result<> {
+
+    // written aside and renamed, a crash mid write never leaves a truncated entry behind
+    // the temp name is per thread, two pipelines may compile the same shader at once
+    std::filesystem::path temp_path{path};
+    temp_path += std::format(
+        ".{:x}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id())
+    );
+    {
+        std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+        if (not file)
+            return std::unexpected(std::format("Failed to create '{}'", temp_path.string()));
+
+        file.write(reinterpret_cast<const char*>(&compiled.header), sizeof(Entry_header));
+        file.write(
+            static_cast<const char*>(compiled.code),
+            static_cast<std::streamsize>(compiled.header.code_bytes)
+        );
+        if (not file)
+            return std::unexpected(std::format("Failed to write '{}'", temp_path.string()));
+    }
+
+    std::error_code error{};
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+        return std::unexpected(
+            std::format("Failed to rename '{}': {}", temp_path.string(), error.message())
+        );
+
+    return {};
+}
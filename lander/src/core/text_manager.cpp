@@ -1,5 +1,6 @@
 
 
+#include <profiler.h>
 #include <text_manager.h>
 
 auto Text_manager::init(SDL_GPUDevice* device, Resource_manager* res_manager) -> utils::Result<> {
@@ -38,11 +39,12 @@ auto Text_manager::create_text(
         .color = color,
         .ttf_text = ttf_text,
         .draw_data = draw_data,
+        .id = next_text_id++,
         .needs_regen = false,
         .visible = true,
     };
 
-    Uint32 id{next_text_id++};
+    const Uint32 id{text.id};
     id_to_text[id] = text;
     name_to_id[ui_element_name] = id;
 
@@ -100,6 +102,8 @@ auto Text_manager::update_text_color(Uint32 text_id, const glm::vec4& new_color)
 }
 
 auto Text_manager::get_text_objects() -> std::vector<defs::types::text::Text> {
+    PROFILE_ZONE("Text_manager::get_text_objects");
+
     std::vector<defs::types::text::Text> visible_texts{};
 
     for (auto& [id, text] : id_to_text) {
@@ -143,6 +147,8 @@ auto Text_manager::get_matrix(const defs::types::text::Text& text) -> glm::mat4
 }
 
 auto Text_manager::regenerate_text_if_needed(defs::types::text::Text& text) -> utils::Result<> {
+    PROFILE_ZONE("Text_manager::regenerate_text_if_needed");
+
     // need to update?
     if (not text.needs_regen)
         return {};
@@ -168,6 +174,8 @@ auto Text_manager::regenerate_text_if_needed(defs::types::text::Text& text) -> u
 
     text.draw_data = CHECK_PTR(TTF_GetGPUTextDrawData(text.ttf_text));
 
+    // tells the renderer its retained glyphs are stale
+    ++text.revision;
     text.needs_regen = false;
     return {};
 }
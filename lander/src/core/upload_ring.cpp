@@ -0,0 +1,229 @@
+
+
+#include <profiler.h>
+#include <upload_ring.h>
+
+#include <algorithm>
+
+namespace {
+
+    auto align_up(const size_t value) -> size_t {
+        return (value + Upload_ring::alignment - 1) & ~(Upload_ring::alignment - 1);
+    }
+
+}    // namespace
+
+auto Upload_ring::init(
+    Gpu_device* gpu_device, const size_t ring_bytes, const size_t frame_count
+) -> utils::Result<> {
+    gpu = gpu_device;
+    frames_in_flight = frame_count;
+    TRY(create_buffer(ring_bytes));
+
+    return {};
+}
+
+auto Upload_ring::quit() -> void {
+    if (not gpu)
+        return;
+
+    unmap();
+    if (transfer_buffer)
+        gpu->release_transfer_buffer(transfer_buffer);
+    transfer_buffer = nullptr;
+
+    for (SDL_GPUTransferBuffer* buffer : retired)
+        gpu->release_transfer_buffer(buffer);
+    retired.clear();
+
+    pending.clear();
+    capacity = 0;
+    head = 0;
+}
+
+auto Upload_ring::stage(
+    SDL_GPUBuffer* destination, const size_t destination_offset, const size_t bytes,
+    const bool cycle
+) -> utils::Result<std::byte*> {
+
+    if (not destination || bytes == 0)
+        return std::unexpected("Empty upload");
+    VALID_SDL_SIZE(destination_offset + bytes);
+
+    const size_t ring_offset{TRY(allocate(bytes))};
+    pending.push_back({
+        .source = transfer_buffer,
+        .source_offset = static_cast<Uint32>(ring_offset),
+        .destination = destination,
+        .destination_offset = static_cast<Uint32>(destination_offset),
+        .size = static_cast<Uint32>(bytes),
+        .cycle = cycle,
+    });
+
+    return mapped + ring_offset;
+}
+
+auto Upload_ring::stage_texture(
+    SDL_GPUTexture* texture, const Uint32 width, const Uint32 height, const size_t bytes
+) -> utils::Result<std::byte*> {
+
+    if (not texture || bytes == 0)
+        return std::unexpected("Empty upload");
+    VALID_SDL_SIZE(bytes);
+
+    const size_t ring_offset{TRY(allocate(bytes))};
+    pending.push_back({
+        .source = transfer_buffer,
+        .source_offset = static_cast<Uint32>(ring_offset),
+        .size = static_cast<Uint32>(bytes),
+        .texture = texture,
+        .width = width,
+        .height = height,
+    });
+
+    return mapped + ring_offset;
+}
+
+auto Upload_ring::reserve(const size_t bytes) -> utils::Result<> {
+    if (align_up(head) + bytes > partition_bytes())
+        TRY(grow(bytes));
+
+    return {};
+}
+
+auto Upload_ring::discard(
+    const SDL_GPUBuffer* destination, const size_t first_byte, const size_t bytes
+) -> void {
+    const size_t last_byte{bytes > std::numeric_limits<size_t>::max() - first_byte
+                               ? std::numeric_limits<size_t>::max()
+                               : first_byte + bytes};
+
+    // uploads never straddle a range that gets dropped, so containment is enough
+    std::erase_if(pending, [&](const Pending_upload& upload) {
+        return upload.destination == destination && upload.destination_offset >= first_byte &&
+               size_t{upload.destination_offset} + upload.size <= last_byte;
+    });
+}
+
+auto Upload_ring::flush(SDL_GPUCommandBuffer* command_buffer) -> utils::Result<> {
+    if (pending.empty())
+        return {};
+
+    SDL_GPUCopyPass* copy_pass{CHECK_PTR(gpu->begin_copy_pass(command_buffer))};
+    record(copy_pass);
+    gpu->end_copy_pass(copy_pass);
+
+    return {};
+}
+
+auto Upload_ring::record(SDL_GPUCopyPass* copy_pass) -> void {
+    PROFILE_ZONE("Upload_ring::record");
+
+    if (pending.empty())
+        return;
+
+    // transfer buffers must be unmapped before a copy pass reads them
+    unmap();
+
+    for (const Pending_upload& upload : pending) {
+        if (upload.texture) {
+            const SDL_GPUTextureTransferInfo transfer_info{
+                .transfer_buffer = upload.source,
+                .offset = upload.source_offset,
+                .pixels_per_row = upload.width,
+                .rows_per_layer = upload.height,
+            };
+            const SDL_GPUTextureRegion texture_region{
+                .texture = upload.texture,
+                .w = upload.width,
+                .h = upload.height,
+                .d = 1,
+            };
+            gpu->upload_to_texture(copy_pass, transfer_info, texture_region, false);
+            continue;
+        }
+
+        const SDL_GPUTransferBufferLocation location{
+            .transfer_buffer = upload.source,
+            .offset = upload.source_offset,
+        };
+        const SDL_GPUBufferRegion region{
+            .buffer = upload.destination,
+            .offset = upload.destination_offset,
+            .size = upload.size,
+        };
+        gpu->upload_to_buffer(copy_pass, location, region, upload.cycle);
+    }
+    pending.clear();
+
+    // sdl defers the actual release until the recorded copies are done
+    for (SDL_GPUTransferBuffer* buffer : retired)
+        gpu->release_transfer_buffer(buffer);
+    retired.clear();
+}
+
+auto Upload_ring::begin_frame(const size_t frame) -> void {
+    partition = frame % frames_in_flight;
+    head = 0;
+}
+
+auto Upload_ring::allocate(const size_t bytes) -> utils::Result<size_t> {
+    // outgrowing a partition replaces the ring, staged data stays in the old buffer
+    size_t offset{align_up(head)};
+    if (offset + bytes > partition_bytes()) {
+        TRY(grow(offset + bytes));
+        offset = 0;
+    }
+
+    // no cycling, the renderer's fences already guarantee this partition is free
+    if (not mapped)
+        mapped = static_cast<std::byte*>(
+            CHECK_PTR(gpu->map_transfer_buffer(transfer_buffer, false))
+        );
+
+    head = offset + bytes;
+    peak_bytes = std::max(peak_bytes, head);
+
+    return (partition * partition_bytes()) + offset;
+}
+
+auto Upload_ring::create_buffer(const size_t ring_bytes) -> utils::Result<> {
+    // every partition starts aligned
+    const size_t size{VALID_SDL_SIZE(align_up(ring_bytes / frames_in_flight) * frames_in_flight)};
+
+    const SDL_GPUTransferBufferCreateInfo transfer_info{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = static_cast<Uint32>(size),
+    };
+    transfer_buffer = CHECK_PTR(gpu->create_transfer_buffer(transfer_info));
+    capacity = size;
+
+    return {};
+}
+
+auto Upload_ring::grow(const size_t needed_bytes) -> utils::Result<> {
+    PROFILE_ZONE("Upload_ring::grow");
+
+    unmap();
+
+    // keep the old buffer alive while copies out of it are still queued
+    if (pending.empty())
+        gpu->release_transfer_buffer(transfer_buffer);
+    else
+        retired.push_back(transfer_buffer);
+    transfer_buffer = nullptr;
+
+    const size_t new_partition{std::max(partition_bytes() * 2, align_up(needed_bytes))};
+    TRY(create_buffer(new_partition * frames_in_flight));
+    head = 0;
+
+    utils::log(std::format("Upload ring grown to {} bytes", capacity));
+
+    return {};
+}
+
+auto Upload_ring::unmap() -> void {
+    if (mapped)
+        gpu->unmap_transfer_buffer(transfer_buffer);
+    mapped = nullptr;
+}
@@ -12,6 +12,7 @@
 #include <glm/glm/vec2.hpp>
 #include <glm/glm/vec3.hpp>
 #include <glm/glm/vec4.hpp>
+#include <limits>
 #include <ranges>
 #include <string>
 #include <vector>
@@ -22,7 +23,38 @@ namespace defs {
 
         // uniform buffer structures
         namespace shader {
-            // TODO: uniform buffer data structures
+            // One instance in the instanced mesh storage buffer, a 2d affine transform and a
+            // tint, laid out to match lander_instanced.vert.hlsl
+            struct Mesh_instance {
+                glm::vec4 basis;          // model x axis in xy, y axis in zw
+                glm::vec4 translation;    // xy, z is depth, w unused
+                glm::vec4 tint;           // multiplies the vertex color
+            };
+
+            // One sprite in the sprite storage buffer, matches SpriteData in
+            // pull_sprite_batch.vert.hlsl, the quad's corner sits at position
+            struct Sprite_instance {
+                glm::vec3 position;    // z is depth
+                float rotation;        // radians
+                glm::vec2 scale;       // world units
+                glm::vec2 padding;
+                glm::vec4 uv_rect;    // u, v, width, height in the atlas
+                glm::vec4 color;      // multiplies the texel
+            };
+
+            // Per batch uniforms for the instanced mesh shader
+            struct Instanced_uniforms {
+                glm::mat4 view_proj;
+                Uint32 first_instance;    // the batch's first entry in the storage buffer
+                Uint32 padding[3];
+            };
+
+            // Uniforms for text.vert.hlsl, glyphs are staged in world space so model stays
+            // identity and one push covers every text command
+            struct Text_uniforms {
+                glm::mat4 proj_view;
+                glm::mat4 model{1.0F};
+            };
         }    // namespace shader
 
         // vertex data definitions
@@ -41,6 +73,17 @@ namespace defs {
             };
 
             using Mesh_data = std::vector<Mesh_vertex>;
+
+            // Model space box around a mesh and the circle around its center that holds it,
+            // the circle survives rotation so culling tests that
+            // The default (nothing fitted yet, or no vertices) is never culled
+            struct Mesh_bounds {
+                glm::vec2 min{0.0F};
+                glm::vec2 max{0.0F};
+                float radius{std::numeric_limits<float>::infinity()};
+
+                [[nodiscard]] auto center() const -> glm::vec2 { return (min + max) * 0.5F; }
+            };
         }    // namespace vertex
 
         namespace text {
@@ -57,6 +100,8 @@ namespace defs {
                 TTF_Text* ttf_text{nullptr};
                 TTF_GPUAtlasDrawSequence* draw_data{nullptr};
 
+                Uint32 id{0};
+                Uint32 revision{0};    // bumped whenever draw_data is regenerated
                 bool needs_regen{true};
                 bool visible{true};
             };
@@ -67,6 +112,7 @@ namespace defs {
                 glm::mat4 view_matrix;
                 glm::mat4 proj_matrix;
                 glm::vec3 camera_pos;
+                float pixels_per_unit{1.0F};    // screen pixels per world unit, for lod selection
             };
         }    // namespace camera
 
@@ -78,14 +124,36 @@ namespace defs {
                 int score_value;
             };
 
+            // Simplified version of the terrain, indices into the full resolution points
+            struct Terrain_lod {
+                std::vector<Uint32> indices;
+                float max_error;    // max deviation from full resolution, world units
+            };
+
             struct Terrain_data {
                 std::vector<glm::vec2> points;
                 std::vector<Landing_zone> landing_zones;
+                std::vector<size_t> anchors;      // indices that must survive simplification
+                std::vector<Terrain_lod> lods;    // finest first, level 0 is full resolution
                 float world_width;
                 float min_height;
                 float max_height;
             };
 
+            struct Crater {
+                float x{0.0F};
+                float radius{0.0F};
+                float depth{0.0F};
+                float floor{0.0F};    // lowest height the crater can carve down to
+            };
+
+            // Replacement for a vertex range of one lod level's mesh
+            struct Terrain_patch {
+                size_t first_vertex{0};
+                size_t replaced_count{0};    // vertices replaced in the current mesh
+                vertex::Mesh_data vertices;
+            };
+
             using Landing_zones = std::vector<Landing_zone>;
         }    // namespace terrain
 
@@ -118,10 +186,6 @@ namespace defs {
                 std::string_view file_name;
             };
 
-            struct Shader_set_def {
-                std::string_view shader_set_name;
-            };
-
             struct Mesh_def {
                 std::string_view mesh_name;
                 std::span<const vertex::Mesh_vertex> vertices;
@@ -140,6 +204,12 @@ namespace defs {
         inline const std::filesystem::path font_path{"assets\\font"};
         inline const std::filesystem::path audio_path{"assets\\audio"};
         inline const std::filesystem::path shader_path{"assets\\shader"};
+        inline const std::filesystem::path level_path{"assets\\level"};
+        inline const std::filesystem::path image_path{"assets\\image"};
+        // written at runtime, safe to delete
+        inline const std::filesystem::path shader_cache_path{"cache\\shader"};
+        // chrome trace of the last run's profiler zones, written on quit
+        inline const std::filesystem::path profile_trace_path{"profile_trace.json"};
 
         // Helper to get full path
         [[nodiscard]] inline auto get_full_path(const std::string& file_name)
@@ -153,6 +223,10 @@ namespace defs {
                 full_path = full_path / audio_path;
             else if (file_name.contains(".spv"))
                 full_path = full_path / shader_path;
+            else if (file_name.contains(".lvl"))
+                full_path = full_path / level_path;
+            else if (file_name.contains(".png"))
+                full_path = full_path / image_path;
             else
                 return "Unrecognized file type";
 
@@ -192,28 +266,37 @@ namespace defs {
 
             inline constexpr std::string_view shader_lander_name{"lander"};
             inline constexpr std::string_view shader_text_name{"text"};
-
-            inline constexpr auto startup_shaders = std::to_array<types::assets::Shader_set_def>({
-                {shader_lander_name},
-                {shader_text_name},
-            });
-
-            // Helper to get full file names
-            [[nodiscard]] inline auto get_shader_set_file_names(const std::string& shader_name)
-                -> utils::Result<std::array<std::string, 2>> {
-
+            // vertex stage only, pairs with the lander fragment stage, optional at runtime
+            inline constexpr std::string_view shader_lander_instanced_name{"lander_instanced"};
+            // vertex pulling sprites, drawn with the textured quad fragment stage
+            inline constexpr std::string_view shader_sprite_name{"pull_sprite_batch"};
+            inline constexpr std::string_view shader_textured_quad_name{"textured_quad_color"};
+
+            // Helper to get full file names, fragment_name picks another set's fragment stage
+            [[nodiscard]] inline auto get_shader_set_file_names(
+                const std::string& shader_name, const std::string& fragment_name = {}
+            ) -> utils::Result<std::array<std::string, 2>> {
+
+                const std::string& frag_name{fragment_name.empty() ? shader_name : fragment_name};
                 return std::array<std::string, 2>{
                     std::string{
                         std::string(shader_name) + std::string(vert_stage) + std::string(file_type)
                     },
                     std::string{
-                        std::string(shader_name) + std::string(frag_stage) + std::string(file_type)
+                        std::string(frag_name) + std::string(frag_stage) + std::string(file_type)
                     },
                 };
             }
 
         }    // namespace shaders
 
+        namespace images {
+            // soft white dot, tinted per sprite
+            inline constexpr std::string_view image_star{"star.png"};
+
+            inline constexpr auto startup_images = std::to_array<std::string_view>({image_star});
+        }    // namespace images
+
         namespace meshes {
             inline constexpr std::string_view mesh_lander{"lander"};
             // inline const std::string mesh_ground{"ground"};
@@ -232,6 +315,15 @@ namespace defs {
             });
 
         }    // namespace meshes
+
+        namespace levels {
+            // curated terrain set, baked with --bake-levels and loaded in order
+            inline constexpr int level_count{8};
+
+            [[nodiscard]] inline auto level_file_name(const int index) -> std::string {
+                return std::format("level_{:02}.lvl", index);
+            }
+        }    // namespace levels
     }    // namespace assets
 
     namespace startup {
@@ -240,6 +332,158 @@ namespace defs {
         inline constexpr std::string_view window_name{"lander"};
     }    // namespace startup
 
+    namespace background {
+        inline constexpr int star_count{400};
+        inline constexpr float star_min_size{2.0F};    // world units
+        inline constexpr float star_max_size{6.0F};
+        inline constexpr Uint32 star_seed{7};    // same sky every run
+    }    // namespace background
+
+    namespace particles {
+        // One pool and one draw each
+        enum class Material {
+            Exhaust = 0,
+            Dust,
+            Explosion,
+            Count,
+        };
+
+        inline constexpr size_t material_count{static_cast<size_t>(Material::Count)};
+
+        // How a material's particles spawn and age, colors are straight alpha and blend from
+        // start to end over a particle's life
+        // glow 1 adds the color to what is behind, 0 covers it, anything between mixes
+        struct Material_desc {
+            size_t max_particles;
+            float lifetime_min;    // seconds
+            float lifetime_max;
+            float speed_min;    // world units per second
+            float speed_max;
+            float spread;    // radians either side of the emit direction
+            float size_start;    // world units
+            float size_end;
+            glm::vec4 color_start;
+            glm::vec4 color_end;
+            float glow;
+            float drag;             // share of velocity lost per second
+            float gravity_scale;    // of particles::gravity
+        };
+
+        inline constexpr auto materials = std::to_array<Material_desc>({
+            // Exhaust
+            {
+                .max_particles = 256 * 1024,
+                .lifetime_min = 0.25F,
+                .lifetime_max = 0.5F,
+                .speed_min = 80.0F,
+                .speed_max = 140.0F,
+                .spread = 0.2F,
+                .size_start = 3.0F,
+                .size_end = 9.0F,
+                .color_start = {1.0F, 0.85F, 0.4F, 1.0F},
+                .color_end = {0.8F, 0.2F, 0.05F, 0.0F},
+                .glow = 1.0F,
+                .drag = 2.0F,
+                .gravity_scale = 0.0F,
+            },
+            // Dust
+            {
+                .max_particles = 256 * 1024,
+                .lifetime_min = 0.6F,
+                .lifetime_max = 1.4F,
+                .speed_min = 20.0F,
+                .speed_max = 70.0F,
+                .spread = 1.3F,
+                .size_start = 4.0F,
+                .size_end = 12.0F,
+                .color_start = {0.6F, 0.58F, 0.55F, 0.7F},
+                .color_end = {0.5F, 0.48F, 0.45F, 0.0F},
+                .glow = 0.0F,
+                .drag = 2.5F,
+                .gravity_scale = 0.3F,
+            },
+            // Explosion
+            {
+                .max_particles = 512 * 1024,
+                .lifetime_min = 0.4F,
+                .lifetime_max = 1.5F,
+                .speed_min = 40.0F,
+                .speed_max = 220.0F,
+                .spread = 3.14159265F,
+                .size_start = 5.0F,
+                .size_end = 1.5F,
+                .color_start = {1.0F, 0.95F, 0.7F, 1.0F},
+                .color_end = {0.7F, 0.1F, 0.0F, 0.0F},
+                .glow = 1.0F,
+                .drag = 0.8F,
+                .gravity_scale = 1.0F,
+            },
+        });
+        static_assert(materials.size() == material_count);
+
+        inline constexpr size_t max_particles{1024 * 1024};    // across every material
+        static_assert([] {
+            size_t total{0};
+            for (const Material_desc& desc : materials)
+                total += desc.max_particles;
+            return total <= max_particles;
+        }());
+
+        inline constexpr float gravity{-40.0F};    // world units per second squared
+        inline constexpr Uint32 seed{11};
+
+        // update workers, and the fewest particles worth a chunk of their own
+        inline constexpr size_t max_threads{4};
+        inline constexpr size_t chunk_particles{16 * 1024};
+        // pools start this large and double up to their material's limit, never shrinking
+        inline constexpr size_t initial_capacity{1024};
+
+        // soft round dot every material is drawn with, premultiplied
+        inline constexpr int texture_size{32};
+
+        // lander effects
+        inline constexpr float exhaust_rate{900.0F};    // per second while thrusting
+        inline constexpr glm::vec2 exhaust_offset{0.0F, -10.0F};    // base of the lander mesh
+        inline constexpr Uint32 crash_dust{600};
+        inline constexpr Uint32 crash_explosion{2500};
+    }    // namespace particles
+
+    namespace debug_draw {
+        // line list vertices kept per simulation step, two per line
+        inline constexpr Uint32 max_vertices{512 * 1024};
+        inline constexpr Uint32 circle_segments{16};
+        inline constexpr float label_height{8.0F};    // world units
+
+        // the built in overlays, toggled with g
+        inline constexpr glm::vec4 collider_color{0.2F, 1.0F, 0.4F, 1.0F};
+        inline constexpr glm::vec4 bounds_color{1.0F, 1.0F, 0.2F, 0.5F};
+        inline constexpr glm::vec4 velocity_color{0.3F, 0.8F, 1.0F, 1.0F};
+        inline constexpr glm::vec4 terrain_color{0.4F, 0.6F, 1.0F, 0.8F};
+        inline constexpr glm::vec4 anchor_color{1.0F, 0.3F, 0.8F, 1.0F};
+        inline constexpr glm::vec4 landing_zone_color{1.0F, 0.6F, 0.1F, 1.0F};
+        inline constexpr float anchor_radius{2.0F};
+        inline constexpr Uint32 anchor_segments{8};
+        inline constexpr float velocity_scale{0.5F};    // seconds of travel drawn
+    }    // namespace debug_draw
+
+    namespace render_graph {
+        // passes per frame, dependencies are kept as one 64 bit mask per pass
+        inline constexpr size_t max_passes{64};
+        // buffers and textures a pass may read besides its attachments
+        inline constexpr size_t max_pass_reads{8};
+        // pooled transient textures nothing has used for this many frames are released
+        inline constexpr Uint32 transient_idle_frames{8};
+
+        // the scene is drawn at this fraction of the window and scaled up by the post pass,
+        // at 1 it goes straight to the swapchain and text and debug lines share its pass
+        // the renderer starts at render_scale, set_render_scale changes it between frames
+        inline constexpr float render_scale{1.0F};
+        inline constexpr float min_render_scale{0.25F};
+        static_assert(min_render_scale > 0.0F && min_render_scale <= render_scale);
+        static_assert(render_scale <= 1.0F);
+        inline constexpr SDL_FColor clear_color{0.15F, 0.17F, 0.20F, 1.00F};
+    }    // namespace render_graph
+
     namespace colors {
         inline constexpr glm::vec4 white{1.0F, 1.0F, 1.0F, 1.0F};
     }    // namespace colors
@@ -260,6 +504,11 @@ namespace defs {
         inline constexpr std::string_view debug_text{"debug"};
         inline constexpr std::string_view score_text{"score"};
         inline constexpr std::string_view fuel_text{"fuel"};
+        inline constexpr std::string_view profile_text{"profile"};
+
+        // slowest profiler zones shown on screen, refreshed a few times a second
+        inline constexpr size_t profile_zones{6};
+        inline constexpr Uint64 profile_interval_ns{500'000'000};
 
         inline constexpr auto default_elements =
             std::to_array<std::string_view>({debug_text, score_text, fuel_text});
@@ -299,11 +548,29 @@ namespace defs {
 
         inline constexpr int num_base_curve_points{60};
         inline constexpr int num_terrain_points{120};
-        inline constexpr float base_curve_noise{0.25F};
         inline constexpr float terrain_noise{0.01F};
 
+        // procedural noise - frequencies are in cycles across the world width
+        inline constexpr int curve_noise_octaves{4};
+        inline constexpr float curve_noise_frequency{2.5F};
+        inline constexpr float curve_noise_amplitude{0.2F};
+        inline constexpr float curve_warp_strength{0.08F};
+        inline constexpr int detail_noise_octaves{3};
+        inline constexpr float detail_noise_frequency{24.0F};
+
         inline constexpr float line_thickness{2.0F};
 
+        // level of detail - each level allows lod_error_factor times the deviation of the last
+        inline constexpr int num_lod_levels{5};
+        inline constexpr float lod_base_error{line_thickness * 0.25F};
+        inline constexpr float lod_error_factor{4.0F};
+        inline constexpr float lod_max_screen_error{0.75F};    // pixels
+        inline constexpr size_t lod_max_span_points{4096};
+
+        // deformation
+        inline constexpr float crater_radius{assets::meshes::lander_width * 1.5F};
+        inline constexpr float crater_depth{assets::meshes::lander_width * 0.75F};
+
         // TODO: proper const for scoring values...
         inline constexpr std::pair<float, int> zone_1{assets::meshes::lander_width * 1.2F, 100};
         inline constexpr std::pair<float, int> zone_2{assets::meshes::lander_width * 2.2F, 50};
@@ -319,15 +586,46 @@ namespace defs {
             Line = 2,
             Text = 3,
             Particle = 4,
+            Sprite = 5,
+            Debug = 6,
         };
 
-        inline constexpr size_t initial_text_vertex_bytes{2000};
+        // frames the cpu may record ahead of the gpu, each with its own dynamic buffers
+        // 2 keeps latency down, 3 absorbs uneven frame times
+        inline constexpr size_t frames_in_flight{3};
+        static_assert(frames_in_flight >= 2 && frames_in_flight <= 3);
+
+        // pipeline compile workers, fewer when the machine has fewer spare cores
+        inline constexpr size_t max_pipeline_threads{4};
+        // render command collection workers, and the fewest objects worth a chunk of their own
+        inline constexpr size_t max_collect_threads{8};
+        inline constexpr size_t collect_chunk_objects{4096};
+
+        // starting size of the retained text geometry, compacted and grown when full
+        inline constexpr Uint32 text_arena_vertices{4 * 1024};
         inline constexpr size_t initial_text_index_bytes{2000};
+        // shared staging for all uploads, split between frames in flight, grows if outrun
+        inline constexpr size_t upload_ring_bytes{frames_in_flight * 256 * 1024};
+        // starting size of the shared mesh vertex buffer, doubles when full
+        inline constexpr Uint32 mesh_pool_vertices{16 * 1024};
+        // starting size of the per frame instance storage buffer, doubles when full
+        inline constexpr Uint32 initial_mesh_instances{1024};
+        // starting size of the per frame sprite storage buffer, doubles when full
+        inline constexpr Uint32 initial_sprite_count{4096};
+        // same for particles, which share the sprite layout
+        inline constexpr Uint32 initial_particle_count{16 * 1024};
+        // starting size of the per frame debug line vertex buffer, doubles when full
+        inline constexpr Uint32 initial_debug_vertices{16 * 1024};
 
         struct Desc {
             Type type;
             std::string_view pipeline_debug_name;
             std::string_view shader_name;
+            std::string_view fragment_shader_name;    // defaults to shader_name's
+            // when set, also builds a variant drawing whole batches from the instance buffer
+            std::string_view instanced_shader_name;
+            // also build a blended, depth read only variant for the transparent pass
+            bool transparent_variant{false};
             std::span<const SDL_GPUVertexBufferDescription> vertex_buffer_descriptions;
             std::span<const SDL_GPUVertexAttribute> vertex_attributes;
             std::span<const SDL_GPUColorTargetDescription> color_target_descriptions;
@@ -337,6 +635,48 @@ namespace defs {
         };
 
         namespace descriptors {
+            // every pass draws into the one depth buffer, so every pipeline declares it
+            // 16 bits matches the depth resolution of the sort keys
+            inline constexpr SDL_GPUTextureFormat depth_format{SDL_GPU_TEXTUREFORMAT_D16_UNORM};
+
+            // depth is in [0, 1], 0 nearest, the buffer clears to 1
+            namespace depth {
+                // opaque meshes, drawn near to far so hidden fragments fail early
+                inline constexpr SDL_GPUDepthStencilState opaque{
+                    .compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+                    .enable_depth_test = true,
+                    .enable_depth_write = true,
+                };
+
+                // blended meshes, hidden by opaque ones but never hiding each other
+                inline constexpr SDL_GPUDepthStencilState transparent{
+                    .compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+                    .enable_depth_test = true,
+                    .enable_depth_write = false,
+                };
+
+                // background sprites and text, layered by draw order alone
+                inline constexpr SDL_GPUDepthStencilState overlay{
+                    .compare_op = SDL_GPU_COMPAREOP_ALWAYS,
+                    .enable_depth_test = false,
+                    .enable_depth_write = false,
+                };
+            }    // namespace depth
+
+            namespace blend {
+                // straight alpha, for the transparent variants of mesh pipelines
+                inline constexpr SDL_GPUColorTargetBlendState alpha{
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_write_mask = 0xF,
+                    .enable_blend = true,
+                };
+            }    // namespace blend
+
             namespace lander {
                 inline constexpr std::string_view debug_name{"lander"};
                 inline constexpr auto vertex_buffer_descriptions =
@@ -374,6 +714,8 @@ namespace defs {
                 inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
                     .color_target_descriptions = color_target_descriptions.data(),
                     .num_color_targets = 1,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
                 };
 
                 inline constexpr SDL_GPUVertexInputState vertex_input_state{
@@ -388,6 +730,7 @@ namespace defs {
                     .fragment_shader = nullptr,    // manual
                     .vertex_input_state = vertex_input_state,
                     .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    .depth_stencil_state = depth::opaque,
                     .target_info = pipeline_target_info,
                     // .props = manual
                 };
@@ -431,6 +774,8 @@ namespace defs {
                 inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
                     .color_target_descriptions = color_target_descriptions.data(),
                     .num_color_targets = 1,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
                 };
 
                 inline constexpr SDL_GPUVertexInputState vertex_input_state{
@@ -445,6 +790,7 @@ namespace defs {
                     .fragment_shader = nullptr,    // manual
                     .vertex_input_state = vertex_input_state,
                     .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP,
+                    .depth_stencil_state = depth::opaque,
                     .target_info = pipeline_target_info,
                     // .props = manual
                 };
@@ -506,7 +852,8 @@ namespace defs {
                 inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
                     .color_target_descriptions = color_target_descriptions.data(),
                     .num_color_targets = 1,
-                    .has_depth_stencil_target = false,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
                 };
 
                 inline constexpr SDL_GPUVertexInputState vertex_input_state{
@@ -521,16 +868,139 @@ namespace defs {
                     .fragment_shader = nullptr,    // manual
                     .vertex_input_state = vertex_input_state,
                     .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    .depth_stencil_state = depth::overlay,
                     .target_info = pipeline_target_info,
                     // .props = manual
                 };
             }    // namespace text
+
+            namespace sprite {
+                inline constexpr std::string_view debug_name{"sprite"};
+
+                inline constexpr SDL_GPUColorTargetBlendState color_target_blend_state{
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_write_mask = 0xF,
+                    .enable_blend = true,
+                };
+
+                inline constexpr auto color_target_descriptions =
+                    std::to_array<SDL_GPUColorTargetDescription>({
+                        {
+                            .format = SDL_GPU_TEXTUREFORMAT_INVALID,    // manual
+                            .blend_state = color_target_blend_state,
+                        },
+                    });
+
+                inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
+                    .color_target_descriptions = color_target_descriptions.data(),
+                    .num_color_targets = 1,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
+                };
+
+                // no vertex buffers, the shader pulls quads from the sprite storage buffer
+                inline constexpr SDL_GPUVertexInputState vertex_input_state{
+                    .vertex_buffer_descriptions = nullptr,
+                    .num_vertex_buffers = 0,
+                    .vertex_attributes = nullptr,
+                    .num_vertex_attributes = 0,
+                };
+
+                inline constexpr SDL_GPUGraphicsPipelineCreateInfo pipeline_create_info{
+                    .vertex_shader = nullptr,      // manual
+                    .fragment_shader = nullptr,    // manual
+                    .vertex_input_state = vertex_input_state,
+                    .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    .depth_stencil_state = depth::overlay,
+                    .target_info = pipeline_target_info,
+                    // .props = manual
+                };
+            }    // namespace sprite
+
+            // the sprite shaders with premultiplied blending, a particle with zero alpha adds
+            // its color and one with full alpha covers, so every material shares the pipeline
+            namespace particle {
+                inline constexpr std::string_view debug_name{"particle"};
+
+                inline constexpr SDL_GPUColorTargetBlendState color_target_blend_state{
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_write_mask = 0xF,
+                    .enable_blend = true,
+                };
+
+                inline constexpr auto color_target_descriptions =
+                    std::to_array<SDL_GPUColorTargetDescription>({
+                        {
+                            .format = SDL_GPU_TEXTUREFORMAT_INVALID,    // manual
+                            .blend_state = color_target_blend_state,
+                        },
+                    });
+
+                inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
+                    .color_target_descriptions = color_target_descriptions.data(),
+                    .num_color_targets = 1,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
+                };
+
+                inline constexpr SDL_GPUGraphicsPipelineCreateInfo pipeline_create_info{
+                    .vertex_shader = nullptr,      // manual
+                    .fragment_shader = nullptr,    // manual
+                    .vertex_input_state = sprite::vertex_input_state,
+                    .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    .depth_stencil_state = depth::overlay,
+                    .target_info = pipeline_target_info,
+                    // .props = manual
+                };
+            }    // namespace particle
+
+            // debug_draw's stream, mesh vertices as a line list over everything else
+            namespace debug_lines {
+                inline constexpr std::string_view debug_name{"debug lines"};
+
+                inline constexpr auto color_target_descriptions =
+                    std::to_array<SDL_GPUColorTargetDescription>({
+                        {
+                            .format = SDL_GPU_TEXTUREFORMAT_INVALID,    // manual
+                            .blend_state = blend::alpha,
+                        },
+                    });
+
+                inline constexpr SDL_GPUGraphicsPipelineTargetInfo pipeline_target_info{
+                    .color_target_descriptions = color_target_descriptions.data(),
+                    .num_color_targets = 1,
+                    .depth_stencil_format = depth_format,
+                    .has_depth_stencil_target = true,
+                };
+
+                inline constexpr SDL_GPUGraphicsPipelineCreateInfo pipeline_create_info{
+                    .vertex_shader = nullptr,      // manual
+                    .fragment_shader = nullptr,    // manual
+                    .vertex_input_state = lander::vertex_input_state,
+                    .primitive_type = SDL_GPU_PRIMITIVETYPE_LINELIST,
+                    .depth_stencil_state = depth::overlay,
+                    .target_info = pipeline_target_info,
+                    // .props = manual
+                };
+            }    // namespace debug_lines
         }    // namespace descriptors
 
         inline constexpr Desc lander_desc{
             .type = Type::Mesh,
             .pipeline_debug_name = descriptors::lander::debug_name,
             .shader_name = assets::shaders::shader_lander_name,
+            .instanced_shader_name = assets::shaders::shader_lander_instanced_name,
+            .transparent_variant = true,
             .vertex_buffer_descriptions = descriptors::lander::vertex_buffer_descriptions,
             .vertex_attributes = descriptors::lander::vertex_attributes,
             .color_target_descriptions = descriptors::lander::color_target_descriptions,
@@ -544,6 +1014,7 @@ namespace defs {
             .type = Type::Line,
             .pipeline_debug_name = descriptors::terrain::debug_name,
             .shader_name = assets::shaders::shader_lander_name,
+            .transparent_variant = true,
             .vertex_buffer_descriptions = descriptors::terrain::vertex_buffer_descriptions,
             .vertex_attributes = descriptors::terrain::vertex_attributes,
             .color_target_descriptions = descriptors::terrain::color_target_descriptions,
@@ -564,10 +1035,48 @@ namespace defs {
             .create_info = descriptors::text::pipeline_create_info,
         };
 
+        inline constexpr Desc sprite_desc{
+            .type = Type::Sprite,
+            .pipeline_debug_name = descriptors::sprite::debug_name,
+            .shader_name = assets::shaders::shader_sprite_name,
+            .fragment_shader_name = assets::shaders::shader_textured_quad_name,
+            .color_target_descriptions = descriptors::sprite::color_target_descriptions,
+            .target_info = descriptors::sprite::pipeline_target_info,
+            .vertex_input_state = descriptors::sprite::vertex_input_state,
+            .create_info = descriptors::sprite::pipeline_create_info,
+        };
+
+        inline constexpr Desc particle_desc{
+            .type = Type::Particle,
+            .pipeline_debug_name = descriptors::particle::debug_name,
+            .shader_name = assets::shaders::shader_sprite_name,
+            .fragment_shader_name = assets::shaders::shader_textured_quad_name,
+            .color_target_descriptions = descriptors::particle::color_target_descriptions,
+            .target_info = descriptors::particle::pipeline_target_info,
+            .vertex_input_state = descriptors::sprite::vertex_input_state,
+            .create_info = descriptors::particle::pipeline_create_info,
+        };
+
+        // the lander shaders with an identity model, the stream is already in world space
+        inline constexpr Desc debug_lines_desc{
+            .type = Type::Debug,
+            .pipeline_debug_name = descriptors::debug_lines::debug_name,
+            .shader_name = assets::shaders::shader_lander_name,
+            .vertex_buffer_descriptions = descriptors::lander::vertex_buffer_descriptions,
+            .vertex_attributes = descriptors::lander::vertex_attributes,
+            .color_target_descriptions = descriptors::debug_lines::color_target_descriptions,
+            .target_info = descriptors::debug_lines::pipeline_target_info,
+            .vertex_input_state = descriptors::lander::vertex_input_state,
+            .create_info = descriptors::debug_lines::pipeline_create_info,
+        };
+
         inline constexpr auto default_pipelines = std::to_array<Desc>({
             lander_desc,
             terrain_desc,
             text_desc,
+            sprite_desc,
+            particle_desc,
+            debug_lines_desc,
         });
 
     }    // namespace pipelines
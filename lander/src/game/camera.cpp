@@ -7,9 +7,18 @@ auto Camera::get_view_matrix() -> glm::mat4 {
 }
 
 auto Camera::get_projection_matrix() -> glm::mat4 {
-    return glm::mat4{glm::ortho(0.0F, 800.0F, 0.0F, 800.0F)};
+    const glm::vec2 view_size{get_view_size()};
+    return glm::mat4{glm::ortho(0.0F, view_size.x, 0.0F, view_size.y)};
 }
 
 auto Camera::get_position() -> glm::vec3 {
     return {0.0F, 0.0F, 0.0F};
 }
+
+auto Camera::set_zoom(const float new_zoom) -> void {
+    zoom = std::max(new_zoom, 0.01F);
+}
+
+auto Camera::get_view_size() const -> glm::vec2 {
+    return glm::vec2{800.0F, 800.0F} / zoom;
+}
@@ -3,6 +3,7 @@
 #ifndef SDL3_GAME_CAMERA_H
 #define SDL3_GAME_CAMERA_H
 
+#include <algorithm>
 #include <glm/glm/ext/matrix_clip_space.hpp>
 #include <glm/glm/ext/matrix_transform.hpp>
 #include <glm/glm/glm.hpp>
@@ -16,6 +17,7 @@ private:
     glm::mat4 view;
     glm::mat4 projection;
     glm::vec2 position;
+    float zoom{1.0F};
 
 public:
     Camera() = default;
@@ -24,6 +26,12 @@ public:
     auto get_view_matrix() -> glm::mat4;
     auto get_projection_matrix() -> glm::mat4;
     auto get_position() -> glm::vec3;
+
+    auto set_zoom(float new_zoom) -> void;
+    [[nodiscard]] auto get_zoom() const -> float { return zoom; }
+
+    // world units visible across the view
+    [[nodiscard]] auto get_view_size() const -> glm::vec2;
 };
 
 #endif    // SDL3_GAME_CAMERA_H
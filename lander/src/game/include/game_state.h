@@ -8,6 +8,7 @@
 #include <graphics_context.h>
 #include <input_manager.h>
 #include <input_system.h>
+#include <particle_system.h>
 #include <physics_system.h>
 #include <player_control_system.h>
 #include <renderer.h>
@@ -32,6 +33,7 @@ struct Game_state {
     std::unique_ptr<Input_system> input_system;
     std::unique_ptr<Player_control_system> player_control_system;
     std::unique_ptr<Physics_system> physics_system;
+    std::unique_ptr<Particle_system> particle_system;
 
     // Owned objects - unique
     std::vector<std::unique_ptr<Game_object>> game_objects;
@@ -8,6 +8,8 @@ struct Input_state {
     bool is_a{false};
     bool is_d{false};
     bool is_zero{false};
+    bool is_c{false};
+    bool is_g{false};
 };
 
 #endif    // SDL3_GAME_INPUT_STATE_H
@@ -0,0 +1,21 @@
+
+
+#ifndef SDL3_GAME_LEVEL_BAKER_H
+#define SDL3_GAME_LEVEL_BAKER_H
+
+#include <definitions.h>
+#include <utils.h>
+
+#include <filesystem>
+
+// Generates the curated level set offline, level i always uses seed i so a rebake
+// reproduces the same set on the same build
+namespace level_baker {
+
+    auto bake(
+        const std::filesystem::path& directory, int count = defs::assets::levels::level_count
+    ) -> utils::Result<>;
+
+}    // namespace level_baker
+
+#endif    // SDL3_GAME_LEVEL_BAKER_H
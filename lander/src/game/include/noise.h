@@ -0,0 +1,59 @@
+
+
+#ifndef SDL3_GAME_NOISE_H
+#define SDL3_GAME_NOISE_H
+
+#include <SDL3/SDL.h>
+
+#include <span>
+
+// Hash based procedural noise, no permutation tables so any seed is free to use
+// Batch versions take SoA spans and run branchless fixed size blocks that the
+// compiler vectorizes, prefer them whenever more than a handful of samples are needed
+// All noise returns roughly [-1, 1]
+namespace noise {
+
+    struct Fbm_params {
+        int octaves{4};
+        float frequency{1.0F};
+        float lacunarity{2.0F};    // frequency multiplier per octave
+        float gain{0.5F};          // amplitude multiplier per octave
+    };
+
+    // single samples
+    auto value_1d(float x, Uint32 seed) -> float;
+    auto gradient_1d(float x, Uint32 seed) -> float;
+    auto gradient_2d(float x, float y, Uint32 seed) -> float;
+    auto simplex_2d(float x, float y, Uint32 seed) -> float;
+
+    // batches, out[i] = noise(xs[i], ys[i]), all spans must be the same length
+    // out may be the same span as an input
+    auto value_1d(std::span<const float> xs, Uint32 seed, std::span<float> out) -> void;
+    auto gradient_1d(std::span<const float> xs, Uint32 seed, std::span<float> out) -> void;
+    auto gradient_2d(
+        std::span<const float> xs, std::span<const float> ys, Uint32 seed, std::span<float> out
+    ) -> void;
+    auto simplex_2d(
+        std::span<const float> xs, std::span<const float> ys, Uint32 seed, std::span<float> out
+    ) -> void;
+
+    // fractal brownian motion, 1d sums gradient noise and 2d sums simplex noise
+    auto fbm_1d(
+        std::span<const float> xs, const Fbm_params& params, Uint32 seed, std::span<float> out
+    ) -> void;
+    auto fbm_2d(
+        std::span<const float> xs, std::span<const float> ys, const Fbm_params& params,
+        Uint32 seed, std::span<float> out
+    ) -> void;
+
+    // domain warp, offsets coordinates in place by strength * fbm
+    auto warp_1d(std::span<float> xs, float strength, const Fbm_params& params, Uint32 seed)
+        -> void;
+    auto warp_2d(
+        std::span<float> xs, std::span<float> ys, float strength, const Fbm_params& params,
+        Uint32 seed
+    ) -> void;
+
+}    // namespace noise
+
+#endif    // SDL3_GAME_NOISE_H
@@ -0,0 +1,22 @@
+
+
+#ifndef SDL3_GAME_RENDER_BENCHMARK_H
+#define SDL3_GAME_RENDER_BENCHMARK_H
+
+#include <utils.h>
+
+// Renders a synthetic scene against the null gpu device and logs the cpu cost per frame
+// (sorting, batching, instance and sprite uploads) along with the recorded command counts,
+// checks the frame graph at a render scale below 1, then times render command collection
+// for a large object list on one thread and on the collect workers, needs no gpu or window
+// so it runs on any build box
+namespace render_benchmark {
+
+    auto run(
+        int mesh_count = 10'000, int sprite_count = 2'000, int frames = 100,
+        int collect_count = 100'000
+    ) -> utils::Result<>;
+
+}    // namespace render_benchmark
+
+#endif    // SDL3_GAME_RENDER_BENCHMARK_H
@@ -0,0 +1,21 @@
+
+
+#ifndef SDL3_GAME_TERRAIN_BENCHMARK_H
+#define SDL3_GAME_TERRAIN_BENCHMARK_H
+
+#include <utils.h>
+
+#include <array>
+#include <span>
+
+// Times terrain generation across point counts and logs per point cost,
+// cost per point should stay flat (or grow by log n) as the count increases
+namespace terrain_benchmark {
+
+    inline constexpr std::array<int, 5> default_sizes{100, 1'000, 10'000, 100'000, 1'000'000};
+
+    auto run(std::span<const int> sizes = default_sizes, int repeats = 3) -> utils::Result<>;
+
+}    // namespace terrain_benchmark
+
+#endif    // SDL3_GAME_TERRAIN_BENCHMARK_H
@@ -4,6 +4,7 @@
 #define SDL3_GAME_TERRAIN_GENERATOR_H
 
 #include <definitions.h>
+#include <noise.h>
 
 #include <algorithm>
 #include <chrono>
@@ -13,19 +14,43 @@ class Terrain_generator {
 private:
     float world_width;
     float world_height;
+    int num_points;
+
+    std::mt19937 random_engine;
 
 public:
-    Terrain_generator(const float screen_w, const float screen_h) :
-        world_width{screen_w}, world_height{screen_h} {}
+    // a fixed seed always produces the same terrain, used for baking level sets
+    Terrain_generator(
+        const float screen_w, const float screen_h,
+        const int points = defs::terrain::num_terrain_points,
+        const Uint32 seed = std::random_device{}()
+    ) :
+        world_width{screen_w}, world_height{screen_h}, num_points{std::max(points, 2)},
+        random_engine{seed} {}
 
     auto generate_terrain() -> utils::Result<defs::types::terrain::Terrain_data>;
     auto generate_vertices(const defs::types::terrain::Terrain_data& terrain_data)
         -> utils::Result<defs::types::vertex::Mesh_data>;
+    auto generate_vertices(const std::vector<glm::vec2>& points)
+        -> utils::Result<defs::types::vertex::Mesh_data>;
+
+    // One triangle strip per lod level, finest first
+    auto generate_lod_vertices(const defs::types::terrain::Terrain_data& terrain_data)
+        -> utils::Result<std::vector<defs::types::vertex::Mesh_data>>;
+
+    // Carves a bowl into the points around crater.x, anchors (ends and landing zone edges)
+    // never move, each lod is re-simplified only between the kept points around the change
+    // Returns one patch per lod level, or nothing when no point moved
+    static auto carve_crater(
+        std::vector<glm::vec2>& points, const std::vector<size_t>& anchors,
+        std::vector<defs::types::terrain::Terrain_lod>& lods,
+        const defs::types::terrain::Crater& crater
+    ) -> utils::Result<std::vector<defs::types::terrain::Terrain_patch>>;
 
 private:
     auto create_base_curve(defs::terrain::Shape shape, int num_points) -> std::vector<float>;
-    auto mark_landing_zones() -> defs::types::terrain::Landing_zones;
-    auto generate_valid_landing_x(const defs::types::terrain::Landing_zones& zones) -> float;
+    static auto apply_shape(defs::terrain::Shape shape, std::vector<float>& heights) -> void;
+    auto mark_landing_zones() -> utils::Result<defs::types::terrain::Landing_zones>;
     auto generate_detailed_points(const std::vector<float>& base_curve) -> std::vector<glm::vec2>;
     auto integrate_landing_zones(
         const std::vector<glm::vec2>& source_terrain, defs::types::terrain::Landing_zones& zones
@@ -36,9 +61,26 @@ private:
     ) -> void;
     auto add_noise_to_curve(std::vector<float>& heights) -> void;
     auto rescale_curve(std::vector<float>& heights) -> void;
-    auto interpolate_height(const std::vector<glm::vec2>& terrain, float x) -> float;
+    static auto interpolate_height(const std::vector<glm::vec2>& terrain, float x) -> float;
+
+    auto build_lod_chain(const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors)
+        -> std::vector<defs::types::terrain::Terrain_lod>;
+    static auto simplify_span(
+        const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors, size_t first,
+        size_t last, float tolerance, std::vector<Uint32>& kept
+    ) -> void;
+    static auto simplify_range(
+        const std::vector<glm::vec2>& points, size_t first, size_t last, float tolerance,
+        std::vector<Uint32>& kept
+    ) -> void;
+
+    static auto patch_lod(
+        const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors,
+        defs::types::terrain::Terrain_lod& lod, bool full_resolution, size_t changed_first,
+        size_t changed_last
+    ) -> defs::types::terrain::Terrain_patch;
 
-    [[nodiscard]] auto random_shape() const -> defs::terrain::Shape;
+    [[nodiscard]] auto random_shape() -> defs::terrain::Shape;
 
     [[nodiscard]] auto max_height() const -> float {
         return world_height * defs::terrain::max_height_percent;
@@ -0,0 +1,56 @@
+
+
+#include <level_baker.h>
+#include <level_file.h>
+#include <mapped_file.h>
+#include <terrain_generator.h>
+
+#include <format>
+
+namespace level_baker {
+
+    auto bake(const std::filesystem::path& directory, const int count) -> utils::Result<> {
+
+        std::error_code error{};
+        std::filesystem::create_directories(directory, error);
+        if (error)
+            return std::unexpected(
+                std::format("Failed to create '{}': {}", directory.string(), error.message())
+            );
+
+        for (int i = 0; i < count; ++i) {
+            // levels are laid out for the default window, like a fresh start
+            Terrain_generator generator{
+                static_cast<float>(defs::startup::window_width),
+                static_cast<float>(defs::startup::window_height),
+                defs::terrain::num_terrain_points, static_cast<Uint32>(i)
+            };
+            const defs::types::terrain::Terrain_data terrain_data{
+                TRY(generator.generate_terrain())
+            };
+            const std::vector<defs::types::vertex::Mesh_data> lod_vertices{
+                TRY(generator.generate_lod_vertices(terrain_data))
+            };
+
+            const std::filesystem::path path{directory / defs::assets::levels::level_file_name(i)};
+            TRY(level_file::write(path, terrain_data, lod_vertices));
+
+            // read it back so a bad bake fails here rather than at startup
+            auto mapped{Mapped_file::open(path)};
+            if (not mapped)
+                return std::unexpected(mapped.error());
+            const level_file::Level_view view{TRY(level_file::read(mapped->bytes()))};
+
+            utils::log(
+                std::format(
+                    "Baked '{}': {} points, {} lods, {} vertices, {} bytes", path.string(),
+                    view.points.size(), view.lods.size(), view.vertices.size(),
+                    mapped->bytes().size()
+                )
+            );
+        }
+
+        return {};
+    }
+
+}    // namespace level_baker
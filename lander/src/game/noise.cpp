@@ -0,0 +1,429 @@
+
+
+#include <noise.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// kernels have to be inlined into the block loops to vectorize
+#if defined(_MSC_VER)
+#define NOISE_INLINE __forceinline
+#else
+#define NOISE_INLINE [[gnu::always_inline]] inline
+#endif
+
+namespace noise {
+
+    namespace {
+
+        // inputs are copied into local blocks first, the blocks can't alias anything
+        // so the kernel loops vectorize without runtime alias checks
+        constexpr size_t block_size{64};
+        using Block = std::array<float, block_size>;
+
+        // per octave seed offset so octaves don't line up
+        constexpr Uint32 octave_seed_step{0x9E3779B9U};
+
+        // offsets fbm samples used by the warp so they aren't correlated with the source
+        constexpr float warp_offset_x{17.31F};
+        constexpr float warp_offset_y{-41.77F};
+
+        constexpr float simplex_f2{0.36602540378F};    // (sqrt(3) - 1) / 2
+        constexpr float simplex_g2{0.21132486540F};    // (3 - sqrt(3)) / 6
+        constexpr float simplex_scale{75.0F};
+        constexpr float gradient_2d_scale{1.4F};
+
+        // lowbias32, integer only so it vectorizes on any simd width
+        NOISE_INLINE constexpr auto hash(Uint32 x) -> Uint32 {
+            x ^= x >> 16;
+            x *= 0x7FEB352DU;
+            x ^= x >> 15;
+            x *= 0x846CA68BU;
+            x ^= x >> 16;
+            return x;
+        }
+
+        NOISE_INLINE constexpr auto hash_1d(const Sint32 x, const Uint32 seed) -> Uint32 {
+            return hash(static_cast<Uint32>(x) ^ hash(seed));
+        }
+
+        NOISE_INLINE constexpr auto hash_2d(const Sint32 x, const Sint32 y, const Uint32 seed)
+            -> Uint32 {
+            return hash(
+                (static_cast<Uint32>(x) * 0x8DA6B343U) ^ (static_cast<Uint32>(y) * 0xD8163841U) ^
+                hash(seed)
+            );
+        }
+
+        // top 24 bits of a hash mapped to [-1, 1]
+        NOISE_INLINE constexpr auto to_unit(const Uint32 h) -> float {
+            return static_cast<float>(static_cast<Sint32>(h >> 8)) * (2.0F / 16777215.0F) - 1.0F;
+        }
+
+        // branchless floor, the compare becomes a mask in simd code
+        NOISE_INLINE constexpr auto fast_floor(const float x) -> Sint32 {
+            const auto truncated{static_cast<Sint32>(x)};
+            return truncated - static_cast<Sint32>(x < static_cast<float>(truncated));
+        }
+
+        NOISE_INLINE constexpr auto fade(const float t) -> float {
+            return t * t * t * (t * (t * 6.0F - 15.0F) + 10.0F);
+        }
+
+        NOISE_INLINE constexpr auto lerp(const float a, const float b, const float t) -> float {
+            return a + t * (b - a);
+        }
+
+        // plain selects, std::clamp takes references and can leave a branch behind
+        NOISE_INLINE constexpr auto clamp_unit(const float x) -> float {
+            const float low{x < -1.0F ? -1.0F : x};
+            return low > 1.0F ? 1.0F : low;
+        }
+
+        NOISE_INLINE constexpr auto value_kernel(const float x, const Uint32 seed) -> float {
+            const Sint32 xi{fast_floor(x)};
+            const float f{x - static_cast<float>(xi)};
+            return lerp(to_unit(hash_1d(xi, seed)), to_unit(hash_1d(xi + 1, seed)), fade(f));
+        }
+
+        NOISE_INLINE constexpr auto gradient_1d_kernel(const float x, const Uint32 seed) -> float {
+            const Sint32 xi{fast_floor(x)};
+            const float f{x - static_cast<float>(xi)};
+
+            // slopes at both lattice points, max of the blend is 0.5
+            const float d0{to_unit(hash_1d(xi, seed)) * f};
+            const float d1{to_unit(hash_1d(xi + 1, seed)) * (f - 1.0F)};
+            return 2.0F * lerp(d0, d1, fade(f));
+        }
+
+        // gradient from two bytes of the hash, no table lookup needed
+        NOISE_INLINE constexpr auto grad_dot(const Uint32 h, const float dx, const float dy)
+            -> float {
+            const float gx{
+                static_cast<float>(static_cast<Sint32>(h & 0xFFU)) * (2.0F / 255.0F) - 1.0F
+            };
+            const float gy{
+                static_cast<float>(static_cast<Sint32>((h >> 8) & 0xFFU)) * (2.0F / 255.0F) - 1.0F
+            };
+            return gx * dx + gy * dy;
+        }
+
+        NOISE_INLINE constexpr auto gradient_2d_kernel(
+            const float x, const float y, const Uint32 seed
+        ) -> float {
+            const Sint32 xi{fast_floor(x)};
+            const Sint32 yi{fast_floor(y)};
+            const float fx{x - static_cast<float>(xi)};
+            const float fy{y - static_cast<float>(yi)};
+
+            const float n00{grad_dot(hash_2d(xi, yi, seed), fx, fy)};
+            const float n10{grad_dot(hash_2d(xi + 1, yi, seed), fx - 1.0F, fy)};
+            const float n01{grad_dot(hash_2d(xi, yi + 1, seed), fx, fy - 1.0F)};
+            const float n11{grad_dot(hash_2d(xi + 1, yi + 1, seed), fx - 1.0F, fy - 1.0F)};
+
+            const float u{fade(fx)};
+            const float v{fade(fy)};
+            const float n{lerp(lerp(n00, n10, u), lerp(n01, n11, u), v)};
+            return clamp_unit(n * gradient_2d_scale);
+        }
+
+        NOISE_INLINE constexpr auto simplex_corner(const Uint32 h, const float dx, const float dy)
+            -> float {
+            float t{0.5F - dx * dx - dy * dy};
+            t = (t + std::abs(t)) * 0.5F;    // max(t, 0) without a compare
+            t *= t;
+            return t * t * grad_dot(h, dx, dy);
+        }
+
+        NOISE_INLINE constexpr auto simplex_2d_kernel(
+            const float x, const float y, const Uint32 seed
+        ) -> float {
+            // skew to find the simplex cell
+            const float s{(x + y) * simplex_f2};
+            const Sint32 i{fast_floor(x + s)};
+            const Sint32 j{fast_floor(y + s)};
+
+            const float t{static_cast<float>(i + j) * simplex_g2};
+            const float x0{x - (static_cast<float>(i) - t)};
+            const float y0{y - (static_cast<float>(j) - t)};
+
+            // lower or upper triangle, as a select not a branch
+            const float lower{x0 > y0 ? 1.0F : 0.0F};
+            const Sint32 i1{static_cast<Sint32>(lower)};
+            const Sint32 j1{1 - i1};
+
+            const float x1{x0 - lower + simplex_g2};
+            const float y1{y0 - (1.0F - lower) + simplex_g2};
+            const float x2{x0 - 1.0F + 2.0F * simplex_g2};
+            const float y2{y0 - 1.0F + 2.0F * simplex_g2};
+
+            const float n{
+                simplex_corner(hash_2d(i, j, seed), x0, y0) +
+                simplex_corner(hash_2d(i + i1, j + j1, seed), x1, y1) +
+                simplex_corner(hash_2d(i + 1, j + 1, seed), x2, y2)
+            };
+            return clamp_unit(n * simplex_scale);
+        }
+
+        // kernel over a full block, the constant trip count lets it vectorize without
+        // a scalar tail, lanes past the end of the input are zero and never copied out
+        template <typename Kernel>
+        NOISE_INLINE auto eval_block(const Block& in_x, Block& result, Kernel kernel) -> void {
+            for (size_t i{0}; i < block_size; ++i)
+                result[i] = kernel(in_x[i]);
+        }
+
+        template <typename Kernel>
+        NOISE_INLINE auto eval_block(
+            const Block& in_x, const Block& in_y, Block& result, Kernel kernel
+        ) -> void {
+            for (size_t i{0}; i < block_size; ++i)
+                result[i] = kernel(in_x[i], in_y[i]);
+        }
+
+        auto load_block(const std::span<const float> src, const size_t base, Block& block)
+            -> size_t {
+            const size_t count{std::min(block_size, src.size() - base)};
+            std::copy_n(src.begin() + static_cast<ptrdiff_t>(base), count, block.begin());
+            std::fill(block.begin() + static_cast<ptrdiff_t>(count), block.end(), 0.0F);
+            return count;
+        }
+
+        auto store_block(
+            const Block& block, const size_t count, const std::span<float> dst, const size_t base
+        ) -> void {
+            std::copy_n(block.begin(), count, dst.begin() + static_cast<ptrdiff_t>(base));
+        }
+
+        template <typename Kernel>
+        auto for_each_block(
+            const std::span<const float> xs, const std::span<float> out, Kernel kernel
+        ) -> void {
+            Block in_x{};
+            Block result{};
+
+            for (size_t base{0}; base < out.size(); base += block_size) {
+                const size_t count{load_block(xs, base, in_x)};
+                eval_block(in_x, result, kernel);
+                store_block(result, count, out, base);
+            }
+        }
+
+        template <typename Kernel>
+        auto for_each_block(
+            const std::span<const float> xs, const std::span<const float> ys,
+            const std::span<float> out, Kernel kernel
+        ) -> void {
+            Block in_x{};
+            Block in_y{};
+            Block result{};
+
+            for (size_t base{0}; base < out.size(); base += block_size) {
+                const size_t count{load_block(xs, base, in_x)};
+                load_block(ys, base, in_y);
+                eval_block(in_x, in_y, result, kernel);
+                store_block(result, count, out, base);
+            }
+        }
+
+        auto total_amplitude(const Fbm_params& params) -> float {
+            float total{0.0F};
+            float amplitude{1.0F};
+            for (int octave{0}; octave < params.octaves; ++octave) {
+                total += amplitude;
+                amplitude *= params.gain;
+            }
+            return total > 0.0F ? total : 1.0F;
+        }
+
+    }    // namespace
+
+    auto value_1d(const float x, const Uint32 seed) -> float {
+        return value_kernel(x, seed);
+    }
+
+    auto gradient_1d(const float x, const Uint32 seed) -> float {
+        return gradient_1d_kernel(x, seed);
+    }
+
+    auto gradient_2d(const float x, const float y, const Uint32 seed) -> float {
+        return gradient_2d_kernel(x, y, seed);
+    }
+
+    auto simplex_2d(const float x, const float y, const Uint32 seed) -> float {
+        return simplex_2d_kernel(x, y, seed);
+    }
+
+    auto value_1d(const std::span<const float> xs, const Uint32 seed, const std::span<float> out)
+        -> void {
+        for_each_block(xs, out, [seed](const float x) { return value_kernel(x, seed); });
+    }
+
+    auto gradient_1d(const std::span<const float> xs, const Uint32 seed, const std::span<float> out)
+        -> void {
+        for_each_block(xs, out, [seed](const float x) { return gradient_1d_kernel(x, seed); });
+    }
+
+    auto gradient_2d(
+        const std::span<const float> xs, const std::span<const float> ys, const Uint32 seed,
+        const std::span<float> out
+    ) -> void {
+        for_each_block(xs, ys, out, [seed](const float x, const float y) {
+            return gradient_2d_kernel(x, y, seed);
+        });
+    }
+
+    auto simplex_2d(
+        const std::span<const float> xs, const std::span<const float> ys, const Uint32 seed,
+        const std::span<float> out
+    ) -> void {
+        for_each_block(xs, ys, out, [seed](const float x, const float y) {
+            return simplex_2d_kernel(x, y, seed);
+        });
+    }
+
+    // octaves run inside each block so the block stays in cache between octaves
+    auto fbm_1d(
+        const std::span<const float> xs, const Fbm_params& params, const Uint32 seed,
+        const std::span<float> out
+    ) -> void {
+
+        const float normalize{1.0F / total_amplitude(params)};
+
+        Block in_x{};
+        Block scaled_x{};
+        Block result{};
+        Block sum{};
+
+        for (size_t base{0}; base < out.size(); base += block_size) {
+            const size_t count{load_block(xs, base, in_x)};
+            sum.fill(0.0F);
+
+            float frequency{params.frequency};
+            float amplitude{normalize};
+            Uint32 octave_seed{seed};
+
+            for (int octave{0}; octave < params.octaves; ++octave) {
+                for (size_t i{0}; i < block_size; ++i)
+                    scaled_x[i] = in_x[i] * frequency;
+
+                eval_block(scaled_x, result, [octave_seed](const float x) {
+                    return gradient_1d_kernel(x, octave_seed);
+                });
+
+                for (size_t i{0}; i < block_size; ++i)
+                    sum[i] += amplitude * result[i];
+
+                frequency *= params.lacunarity;
+                amplitude *= params.gain;
+                octave_seed += octave_seed_step;
+            }
+
+            store_block(sum, count, out, base);
+        }
+    }
+
+    auto fbm_2d(
+        const std::span<const float> xs, const std::span<const float> ys, const Fbm_params& params,
+        const Uint32 seed, const std::span<float> out
+    ) -> void {
+
+        const float normalize{1.0F / total_amplitude(params)};
+
+        Block in_x{};
+        Block in_y{};
+        Block scaled_x{};
+        Block scaled_y{};
+        Block result{};
+        Block sum{};
+
+        for (size_t base{0}; base < out.size(); base += block_size) {
+            const size_t count{load_block(xs, base, in_x)};
+            load_block(ys, base, in_y);
+            sum.fill(0.0F);
+
+            float frequency{params.frequency};
+            float amplitude{normalize};
+            Uint32 octave_seed{seed};
+
+            for (int octave{0}; octave < params.octaves; ++octave) {
+                for (size_t i{0}; i < block_size; ++i) {
+                    scaled_x[i] = in_x[i] * frequency;
+                    scaled_y[i] = in_y[i] * frequency;
+                }
+
+                eval_block(scaled_x, scaled_y, result, [octave_seed](const float x, const float y) {
+                    return simplex_2d_kernel(x, y, octave_seed);
+                });
+
+                for (size_t i{0}; i < block_size; ++i)
+                    sum[i] += amplitude * result[i];
+
+                frequency *= params.lacunarity;
+                amplitude *= params.gain;
+                octave_seed += octave_seed_step;
+            }
+
+            store_block(sum, count, out, base);
+        }
+    }
+
+    auto warp_1d(
+        const std::span<float> xs, const float strength, const Fbm_params& params,
+        const Uint32 seed
+    ) -> void {
+
+        Block shifted{};
+        Block offset{};
+
+        for (size_t base{0}; base < xs.size(); base += block_size) {
+            const size_t count{std::min(block_size, xs.size() - base)};
+            const auto block{xs.subspan(base, count)};
+
+            for (size_t i{0}; i < count; ++i)
+                shifted[i] = block[i] + warp_offset_x;
+
+            fbm_1d(
+                std::span{shifted}.first(count), params, seed, std::span{offset}.first(count)
+            );
+
+            for (size_t i{0}; i < count; ++i)
+                block[i] += strength * offset[i];
+        }
+    }
+
+    auto warp_2d(
+        const std::span<float> xs, const std::span<float> ys, const float strength,
+        const Fbm_params& params, const Uint32 seed
+    ) -> void {
+
+        Block shifted_x{};
+        Block shifted_y{};
+        Block offset_x{};
+        Block offset_y{};
+
+        for (size_t base{0}; base < xs.size(); base += block_size) {
+            const size_t count{std::min(block_size, xs.size() - base)};
+            const auto block_x{xs.subspan(base, count)};
+            const auto block_y{ys.subspan(base, count)};
+
+            // both offsets sample the unwarped position
+            for (size_t i{0}; i < count; ++i) {
+                shifted_x[i] = block_x[i] + warp_offset_x;
+                shifted_y[i] = block_y[i] + warp_offset_y;
+            }
+
+            const auto sx{std::span{shifted_x}.first(count)};
+            const auto sy{std::span{shifted_y}.first(count)};
+            fbm_2d(sx, sy, params, seed, std::span{offset_x}.first(count));
+            fbm_2d(sy, sx, params, seed + octave_seed_step, std::span{offset_y}.first(count));
+
+            for (size_t i{0}; i < count; ++i) {
+                block_x[i] += strength * offset_x[i];
+                block_y[i] += strength * offset_y[i];
+            }
+        }
+    }
+
+}    // namespace noise
@@ -0,0 +1,111 @@
+
+
+#include <noise.h>
+#include <terrain_benchmark.h>
+#include <terrain_generator.h>
+
+#include <algorithm>
+#include <format>
+#include <numbers>
+#include <random>
+
+namespace terrain_benchmark {
+
+    namespace {
+
+        template <typename Fn>
+        auto samples_per_second(const size_t samples, Fn fn) -> double {
+            const Uint64 start{SDL_GetTicksNS()};
+            fn();
+            const Uint64 elapsed{std::max<Uint64>(SDL_GetTicksNS() - start, 1)};
+            return static_cast<double>(samples) * 1e9 / static_cast<double>(elapsed);
+        }
+
+        // per sample sine + jitter the curve noise used before, against the noise module
+        auto log_noise_throughput() -> void {
+            constexpr size_t samples{1 << 20};
+            constexpr double million{1e6};
+
+            std::vector<float> xs(samples);
+            std::vector<float> ys(samples);
+            std::vector<float> out(samples);
+            for (size_t i = 0; i < samples; ++i) {
+                xs[i] = static_cast<float>(i) * 0.013F;
+                ys[i] = static_cast<float>(i) * 0.007F;
+            }
+
+            std::mt19937 random_engine{1};
+            const double scalar{samples_per_second(samples, [&] {
+                std::uniform_real_distribution<float> jitter(-0.0025F, 0.0025F);
+                std::uniform_real_distribution<float> phase(0.0F, std::numbers::pi_v<float> / 8.0F);
+                for (size_t i = 0; i < samples; ++i)
+                    out[i] = std::sin(xs[i] * std::numbers::pi_v<float> + phase(random_engine)) *
+                                 0.2F +
+                             jitter(random_engine);
+            })};
+
+            const double gradient{
+                samples_per_second(samples, [&] { noise::gradient_1d(xs, 1, out); })
+            };
+            const double simplex{
+                samples_per_second(samples, [&] { noise::simplex_2d(xs, ys, 1, out); })
+            };
+            const double fbm{samples_per_second(samples, [&] {
+                noise::fbm_1d(xs, {.octaves = defs::terrain::curve_noise_octaves}, 1, out);
+            })};
+
+            utils::log(
+                std::format(
+                    "noise Msamples/s: scalar sine {:.1f} | gradient 1d {:.1f} | simplex 2d {:.1f} "
+                    "| fbm 1d x{} {:.1f}",
+                    scalar / million, gradient / million, simplex / million,
+                    defs::terrain::curve_noise_octaves, fbm / million
+                )
+            );
+        }
+
+    }    // namespace
+
+    auto run(const std::span<const int> sizes, const int repeats) -> utils::Result<> {
+        constexpr Uint64 ns_per_ms{1'000'000};
+
+        utils::log("terrain benchmark: points | generate ms | vertices ms | ns/point");
+
+        for (const int size : sizes) {
+            Uint64 best_generate{UINT64_MAX};
+            Uint64 best_vertices{UINT64_MAX};
+
+            // keep the best run to filter out scheduling noise
+            for (int i{0}; i < std::max(repeats, 1); ++i) {
+                Terrain_generator generator{
+                    static_cast<float>(defs::startup::window_width),
+                    static_cast<float>(defs::startup::window_height), size
+                };
+
+                const Uint64 start{SDL_GetTicksNS()};
+                const defs::types::terrain::Terrain_data terrain{TRY(generator.generate_terrain())};
+                const Uint64 generated{SDL_GetTicksNS()};
+                const auto lods{TRY(generator.generate_lod_vertices(terrain))};
+                const Uint64 finished{SDL_GetTicksNS()};
+
+                best_generate = std::min(best_generate, generated - start);
+                best_vertices = std::min(best_vertices, finished - generated);
+            }
+
+            const Uint64 total{best_generate + best_vertices};
+            utils::log(
+                std::format(
+                    "{:>9} | {:>11.3f} | {:>11.3f} | {:>8.1f}", size,
+                    static_cast<double>(best_generate) / ns_per_ms,
+                    static_cast<double>(best_vertices) / ns_per_ms,
+                    static_cast<double>(total) / static_cast<double>(size)
+                )
+            );
+        }
+
+        log_noise_throughput();
+
+        return {};
+    }
+
+}    // namespace terrain_benchmark
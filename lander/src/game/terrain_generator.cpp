@@ -1,10 +1,104 @@
 
 
+#include <profiler.h>
 #include <terrain_generator.h>
 
-// TODO: cleanup debug utils::log in here
+namespace {
+
+    // Appends the two strip vertices for points [first, last) of a line with 'count' points,
+    // offset along the averaged normal of the neighbouring segments
+    template <typename Point_at>
+    auto append_strip_vertices(
+        const size_t count, const size_t first, const size_t last, Point_at point_at,
+        defs::types::vertex::Mesh_data& vertices
+    ) -> void {
+
+        constexpr float half_width{defs::terrain::line_thickness * 0.5F};
+
+        for (size_t i = first; i < last; ++i) {
+            const glm::vec2 current_point{point_at(i)};
+            glm::vec2 normal{};
+
+            if (i == 0) {
+                const glm::vec2 dir{glm::normalize(point_at(i + 1) - current_point)};
+                normal = {-dir.y, dir.x};
+            } else if (i == count - 1) {
+                const glm::vec2 dir{glm::normalize(current_point - point_at(i - 1))};
+                normal = {-dir.y, dir.x};
+            } else {
+                const glm::vec2 dir1{glm::normalize(current_point - point_at(i - 1))};
+                const glm::vec2 dir2{glm::normalize(point_at(i + 1) - current_point)};
+
+                const glm::vec2 normal1{-dir1.y, dir1.x};
+                const glm::vec2 normal2{-dir2.y, dir2.x};
+
+                normal = glm::normalize(normal1 + normal2);
+            }
+
+            const glm::vec2 vertex_a{current_point + normal * half_width};
+            const glm::vec2 vertex_b{current_point - normal * half_width};
+
+            // TODO: color based on height maybe?
+            vertices.push_back({vertex_a, defs::colors::white});
+            vertices.push_back({vertex_b, defs::colors::white});
+        }
+    }
+
+    // Squared distance from point to the segment a-b
+    auto segment_distance_sq(const glm::vec2 point, const glm::vec2 a, const glm::vec2 b)
+        -> float {
+        const glm::vec2 segment{b - a};
+        const glm::vec2 offset{point - a};
+        const float length_sq{glm::dot(segment, segment)};
+        const float t{
+            length_sq > 0.0F ? std::clamp(glm::dot(offset, segment) / length_sq, 0.0F, 1.0F)
+                             : 0.0F
+        };
+        const glm::vec2 delta{offset - segment * t};
+        return glm::dot(delta, delta);
+    }
+
+    // Keeps more of [kept.front(), last) until count indices are kept, each time the point
+    // furthest from the kept line, so the extra points only ever lower the error
+    auto fill_kept(
+        const std::vector<glm::vec2>& points, const size_t last, const size_t count,
+        std::vector<Uint32>& kept
+    ) -> void {
+
+        const auto next{[&](const size_t k) -> size_t {
+            return k + 1 < kept.size() ? kept[k + 1] : last;
+        }};
+
+        while (kept.size() < count) {
+            float furthest{-1.0F};
+            size_t furthest_index{0};
+            size_t insert_at{0};
+            for (size_t k = 0; k < kept.size(); ++k) {
+                for (size_t i = kept[k] + 1; i < next(k); ++i) {
+                    const float dist_sq{
+                        segment_distance_sq(points[i], points[kept[k]], points[next(k)])
+                    };
+                    if (dist_sq > furthest) {
+                        furthest = dist_sq;
+                        furthest_index = i;
+                        insert_at = k + 1;
+                    }
+                }
+            }
+            // every point is already kept
+            if (furthest < 0.0F)
+                return;
+            kept.insert(
+                kept.begin() + static_cast<ptrdiff_t>(insert_at),
+                static_cast<Uint32>(furthest_index)
+            );
+        }
+    }
+
+}    // namespace
 
 auto Terrain_generator::generate_terrain() -> utils::Result<defs::types::terrain::Terrain_data> {
+    PROFILE_ZONE("Terrain_generator::generate_terrain");
 
     // create base shape curve
     const defs::terrain::Shape shape{random_shape()};
@@ -13,12 +107,8 @@ auto Terrain_generator::generate_terrain() -> utils::Result<defs::types::terrain
         create_base_curve(shape, defs::terrain::num_base_curve_points)
     };
 
-    // DEBUG
-    // utils::log("\ngenerate_terrain():");
-    // utils::log(std::format("Shape: {}", static_cast<int>(shape)));
-
     // place landing zones at random x positions
-    defs::types::terrain::Landing_zones landing_zones{mark_landing_zones()};
+    defs::types::terrain::Landing_zones landing_zones{TRY(mark_landing_zones())};
 
     // generate detailed points (respecting landing zones)
     auto [points, anchors]{
@@ -26,72 +116,176 @@ auto Terrain_generator::generate_terrain() -> utils::Result<defs::types::terrain
     };
     add_noise_to_points(points, anchors);
 
-    const defs::types::terrain::Terrain_data terrain_data{
-        .points = points,
-        .landing_zones = landing_zones,
+    auto lods{build_lod_chain(points, anchors)};
+
+    defs::types::terrain::Terrain_data terrain_data{
+        .points = std::move(points),
+        .landing_zones = std::move(landing_zones),
+        .anchors = std::move(anchors),
+        .lods = std::move(lods),
         .world_width = world_width,
         .min_height = min_height(),
         .max_height = max_height(),
     };
 
-    return {terrain_data};
+    return terrain_data;
 }
 
 auto Terrain_generator::generate_vertices(const defs::types::terrain::Terrain_data& terrain_data)
     -> utils::Result<defs::types::vertex::Mesh_data> {
+    return generate_vertices(terrain_data.points);
+}
+
+auto Terrain_generator::generate_vertices(const std::vector<glm::vec2>& points)
+    -> utils::Result<defs::types::vertex::Mesh_data> {
 
     defs::types::vertex::Mesh_data vertices{};
 
-    if (terrain_data.points.size() < 2)
+    if (points.size() < 2)
         return vertices;
 
-    vertices.reserve(terrain_data.points.size() * 2);
+    vertices.reserve(points.size() * 2);
+    append_strip_vertices(
+        points.size(), 0, points.size(), [&points](const size_t i) { return points[i]; }, vertices
+    );
+
+    return vertices;
+}
+
+auto Terrain_generator::generate_lod_vertices(
+    const defs::types::terrain::Terrain_data& terrain_data
+) -> utils::Result<std::vector<defs::types::vertex::Mesh_data>> {
+    PROFILE_ZONE("Terrain_generator::generate_lod_vertices");
+
+    std::vector<defs::types::vertex::Mesh_data> levels{};
+    levels.reserve(terrain_data.lods.size());
+
+    std::vector<glm::vec2> lod_points{};
+    for (const auto& lod : terrain_data.lods) {
+        lod_points.clear();
+        lod_points.reserve(lod.indices.size());
+        for (const Uint32 index : lod.indices)
+            lod_points.push_back(terrain_data.points[index]);
+
+        levels.push_back(TRY(generate_vertices(lod_points)));
+    }
+
+    return levels;
+}
+
+auto Terrain_generator::carve_crater(
+    std::vector<glm::vec2>& points, const std::vector<size_t>& anchors,
+    std::vector<defs::types::terrain::Terrain_lod>& lods, const defs::types::terrain::Crater& crater
+) -> utils::Result<std::vector<defs::types::terrain::Terrain_patch>> {
+    PROFILE_ZONE("Terrain_generator::carve_crater");
+
+    if (points.size() < 2 || lods.empty())
+        return std::unexpected("Terrain has no points to deform");
+
+    std::vector<defs::types::terrain::Terrain_patch> patches{};
 
-    constexpr float half_width{defs::terrain::line_thickness * 0.5F};
+    // points under the crater, x is ascending so this is two binary searches
+    const auto begin{std::ranges::lower_bound(points, crater.x - crater.radius, {}, &glm::vec2::x)};
+    const auto end{std::ranges::upper_bound(points, crater.x + crater.radius, {}, &glm::vec2::x)};
 
-    for (size_t i = 0; i < terrain_data.points.size(); ++i) {
-        const glm::vec2 current_point{terrain_data.points[i]};
-        glm::vec2 normal{};
+    // the two end points are anchors, keeping them out also keeps lod brackets valid
+    const size_t first{std::max<size_t>(std::distance(points.begin(), begin), 1)};
+    const size_t last{std::min<size_t>(std::distance(points.begin(), end), points.size() - 1)};
+    if (first >= last)
+        return patches;
 
-        if (i == 0) {
-            const glm::vec2 dir{glm::normalize(terrain_data.points[i + 1] - current_point)};
-            normal = {-dir.y, dir.x};
-        } else if (i == terrain_data.points.size() - 1) {
-            const glm::vec2 dir{glm::normalize(current_point - terrain_data.points[i - 1])};
-            normal = {-dir.y, dir.x};
-        } else {
-            const glm::vec2 dir1{glm::normalize(current_point - terrain_data.points[i - 1])};
-            const glm::vec2 dir2{glm::normalize(terrain_data.points[i + 1] - current_point)};
+    const float center_height{interpolate_height(points, crater.x)};
 
-            const glm::vec2 normal1{-dir1.y, dir1.x};
-            const glm::vec2 normal2{-dir2.y, dir2.x};
+    size_t changed_first{last};
+    size_t changed_last{first};
+    auto anchor{std::ranges::lower_bound(anchors, first)};
 
-            normal = glm::normalize(normal1 + normal2);
+    for (size_t i = first; i < last; ++i) {
+        // landing zones only have anchor points, so skipping anchors keeps them flat
+        if (anchor != anchors.end() && *anchor == i) {
+            ++anchor;
+            continue;
         }
 
-        const glm::vec2 vertex_a{current_point + normal * half_width};
-        const glm::vec2 vertex_b{current_point - normal * half_width};
+        const float dx{(points[i].x - crater.x) / crater.radius};
+        const float bowl{center_height - crater.depth * std::sqrt(std::max(1.0F - dx * dx, 0.0F))};
+        const float carved{std::min(points[i].y, std::max(bowl, crater.floor))};
 
-        // TODO: color based on height maybe?
-        vertices.push_back({vertex_a, defs::colors::white});
-        vertices.push_back({vertex_b, defs::colors::white});
+        if (carved < points[i].y) {
+            points[i].y = carved;
+            changed_first = std::min(changed_first, i);
+            changed_last = std::max(changed_last, i + 1);
+        }
     }
 
-    // DEBUG
-    // int count{0};
-    // for (const auto& point : terrain_data.points) {
-    //     utils::log(std::format("{}:\t{:.2f}, {:.2f}", count, point.x, point.y));
-    //     ++count;
-    // }
-    //
-    // count = 0;
-    // for (const auto& point : vertices) {
-    //     utils::log(std::format("{}:\t{:.2f}, {:.2f}", count, point.position.x,
-    //     point.position.y));
-    //     ++count;
-    // }
+    if (changed_first >= changed_last)
+        return patches;
 
-    return vertices;
+    patches.reserve(lods.size());
+    for (size_t level = 0; level < lods.size(); ++level)
+        patches.push_back(
+            patch_lod(points, anchors, lods[level], level == 0, changed_first, changed_last)
+        );
+
+    return patches;
+}
+
+// Re-simplifies one level between the kept points around [changed_first, changed_last),
+// work is bounded by the change plus at most two lod windows
+// A coarse window that simplifies to fewer points than it had keeps extra ones instead, so
+// the level's mesh is patched in place rather than shifting everything after the crater,
+// only a window that needs more points to stay within max_error grows the mesh
+auto Terrain_generator::patch_lod(
+    const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors,
+    defs::types::terrain::Terrain_lod& lod, const bool full_resolution, const size_t changed_first,
+    const size_t changed_last
+) -> defs::types::terrain::Terrain_patch {
+
+    std::vector<Uint32>& indices{lod.indices};
+    const size_t old_size{indices.size()};
+
+    // point 0 and the last point are always kept, so both brackets exist
+    const auto low{std::ranges::lower_bound(indices, static_cast<Uint32>(changed_first)) - 1};
+    const auto high{std::ranges::lower_bound(indices, static_cast<Uint32>(changed_last))};
+    const size_t low_position{static_cast<size_t>(std::distance(indices.begin(), low))};
+    const size_t high_position{static_cast<size_t>(std::distance(indices.begin(), high))};
+
+    // kept indices in [low, high), starting with low
+    std::vector<Uint32> replacement{};
+    if (full_resolution) {
+        for (Uint32 i{*low}; i < *high; ++i)
+            replacement.push_back(i);
+    } else {
+        simplify_span(points, anchors, *low, *high, lod.max_error, replacement);
+        fill_kept(points, *high, high_position - low_position, replacement);
+    }
+
+    if (replacement.size() == high_position - low_position) {
+        std::ranges::copy(replacement, low);
+    } else {
+        indices.erase(low, high);
+        indices.insert(
+            indices.begin() + static_cast<ptrdiff_t>(low_position), replacement.begin(),
+            replacement.end()
+        );
+    }
+
+    // low's normal depends on its new neighbour, and so does high's
+    const size_t old_last{std::min(high_position + 1, old_size)};
+    const size_t new_last{std::min(low_position + replacement.size() + 1, indices.size())};
+
+    defs::types::terrain::Terrain_patch patch{
+        .first_vertex = low_position * 2,
+        .replaced_count = (old_last - low_position) * 2,
+        .vertices = {},
+    };
+    patch.vertices.reserve((new_last - low_position) * 2);
+    append_strip_vertices(
+        indices.size(), low_position, new_last,
+        [&](const size_t i) { return points[indices[i]]; }, patch.vertices
+    );
+
+    return patch;
 }
 
 auto Terrain_generator::create_base_curve(defs::terrain::Shape shape, int num_points)
@@ -99,122 +293,119 @@ auto Terrain_generator::create_base_curve(defs::terrain::Shape shape, int num_po
 
     std::vector<float> heights(num_points);
 
-    for (int i = 0; i < num_points; ++i) {
-        // calculate normalized progress 't', 0.0 - 1.0
-        const float t{static_cast<float>(i) / static_cast<float>(num_points - 1)};
-        float y{0.0F};
-
-        switch (shape) {
-            case defs::terrain::Shape::U_normal:
-                y = 4.0F * std::pow(t - 0.5F, 2.0F);
-                break;
-            case defs::terrain::Shape::U_inverted:
-                y = 1.0F - (4.0F * std::pow(t - 0.5F, 2.0F));
-                break;
-            case defs::terrain::Shape::Linear_ramp_up:
-                y = t;
-                break;
-            case defs::terrain::Shape::Linear_ramp_down:
-                y = 1.0F - t;
-                break;
-            case defs::terrain::Shape::S_curve:
-                y = t * t * (3.0F - 2.0F * t);
-                break;
-            case defs::terrain::Shape::Rolling_hills:
-                y = 0.5f - std::cos(t * 2.0f * std::numbers::pi_v<float>) * 0.5f;
-                break;
-            case defs::terrain::Shape::Ease_in_exp:
-                y = std::pow(t, 3.0f);
-                break;
-            case defs::terrain::Shape::Ease_out_exp:
-                y = 1.0f - std::pow(1.0f - t, 3.0f);
-                break;
-            case defs::terrain::Shape::Tent_pole:
-                y = 1.0f - std::abs(t - 0.5f) * 2.0f;
-                break;
-            default:
-                y = 0.0F;
-                break;
-        }
-
-        heights[i] = y;
-    }
+    // normalized progress 't', 0.0 - 1.0
+    const float step{1.0F / static_cast<float>(num_points - 1)};
+    for (int i = 0; i < num_points; ++i)
+        heights[i] = static_cast<float>(i) * step;
 
+    apply_shape(shape, heights);
     add_noise_to_curve(heights);
     rescale_curve(heights);
 
     return heights;
 }
 
-auto Terrain_generator::mark_landing_zones() -> defs::types::terrain::Landing_zones {
+// Maps t to the shape in place, switch is outside the loop so each case is one tight loop
+auto Terrain_generator::apply_shape(const defs::terrain::Shape shape, std::vector<float>& heights)
+    -> void {
 
-    defs::types::terrain::Landing_zones zones{};
+    const auto apply{[&heights](auto&& fn) {
+        for (float& y : heights)
+            y = fn(y);
+    }};
 
-    for (const auto& [width, score] : defs::terrain::zone_configs) {
-        const float x{generate_valid_landing_x(zones)};
-        zones.push_back({
-            .start = {x, 0.0F},    // y gets set during generation of points
-            .end = {x + width, 0.0F},
-            .score_value = score,
-        });
+    switch (shape) {
+        case defs::terrain::Shape::U_normal:
+            apply([](const float t) { return 4.0F * (t - 0.5F) * (t - 0.5F); });
+            break;
+        case defs::terrain::Shape::U_inverted:
+            apply([](const float t) { return 1.0F - (4.0F * (t - 0.5F) * (t - 0.5F)); });
+            break;
+        case defs::terrain::Shape::Linear_ramp_up:
+            break;
+        case defs::terrain::Shape::Linear_ramp_down:
+            apply([](const float t) { return 1.0F - t; });
+            break;
+        case defs::terrain::Shape::S_curve:
+            apply([](const float t) { return t * t * (3.0F - 2.0F * t); });
+            break;
+        case defs::terrain::Shape::Rolling_hills:
+            apply([](const float t) {
+                return 0.5f - std::cos(t * 2.0f * std::numbers::pi_v<float>) * 0.5f;
+            });
+            break;
+        case defs::terrain::Shape::Ease_in_exp:
+            apply([](const float t) { return t * t * t; });
+            break;
+        case defs::terrain::Shape::Ease_out_exp:
+            apply([](const float t) { return 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t); });
+            break;
+        case defs::terrain::Shape::Tent_pole:
+            apply([](const float t) { return 1.0f - std::abs(t - 0.5f) * 2.0f; });
+            break;
+        default:
+            std::ranges::fill(heights, 0.0F);
+            break;
     }
-
-    std::ranges::sort(
-        zones, [](const defs::types::terrain::Landing_zone& a,
-                  const defs::types::terrain::Landing_zone& b) { return a.start.x < b.start.x; }
-    );
-
-    // // DEBUG
-    // utils::log("\nmark_landing_zones():");
-    // for (const auto& zone : zones) {
-    //     utils::log(
-    //         std::format(
-    //             "start: ({:.2f}, {:.2f}) - end: ({:.2f}, {:.2f})", zone.start.x, zone.start.y,
-    //             zone.end.x, zone.end.y
-    //         )
-    //     );
-    // }
-
-    return zones;
 }
 
-auto Terrain_generator::generate_valid_landing_x(const defs::types::terrain::Landing_zones& zones)
-    -> float {
+// Places every zone in one pass, zones keep the same spacing rules as before
+// (start at least separation + widest zone away from any other zone) but instead of
+// rejection sampling, the fixed spacing is reserved up front and the remaining slack is
+// split randomly between the gaps, always terminates and never dead ends
+auto Terrain_generator::mark_landing_zones()
+    -> utils::Result<defs::types::terrain::Landing_zones> {
 
-    constexpr float left_edge{defs::terrain::min_landing_zone_separation};
-    const float right_edge{
-        world_width - (defs::terrain::min_landing_zone_separation + defs::terrain::zone_3.first)
+    constexpr float margin{
+        defs::terrain::min_landing_zone_separation + defs::terrain::zone_3.first
     };
+    constexpr float left_edge{defs::terrain::min_landing_zone_separation};
+    const float right_edge{world_width - margin};
+
+    // random left to right order of zone sizes
+    auto configs{defs::terrain::zone_configs};
+    std::ranges::shuffle(configs, random_engine);
+
+    // each zone but the last needs its own width plus margin before the next can start
+    float required{0.0F};
+    for (size_t i{0}; i + 1 < configs.size(); ++i)
+        required += configs[i].first + margin;
+
+    const float slack{(right_edge - left_edge) - required};
+    if (slack < 0.0F)
+        return std::unexpected(
+            std::format("Landing zones need {:.2f} more width to fit", slack * -1.0F)
+        );
+
+    // sorted uniform samples split the slack into random gaps
+    std::uniform_real_distribution<float> distribution(0.0F, slack);
+    std::array<float, defs::terrain::zone_configs.size()> offsets{};
+    for (float& offset : offsets)
+        offset = distribution(random_engine);
+    std::ranges::sort(offsets);
 
-    std::random_device rd;
-    std::mt19937 random_engine(rd());
-
-    std::uniform_real_distribution<float> x_distribution(left_edge, right_edge);
-
-    float x{};
-    while (true) {
-        x = x_distribution(random_engine);
-
-        bool is_in_zone{false};
-        if (not zones.empty())
-            for (const auto& zone : zones)
-                if (x > zone.start.x - (defs::terrain::min_landing_zone_separation +
-                                        defs::terrain::zone_3.first) &&
-                    x < zone.end.x + (defs::terrain::min_landing_zone_separation +
-                                      defs::terrain::zone_3.first))
-                    is_in_zone = true;
+    defs::types::terrain::Landing_zones zones{};
+    zones.reserve(configs.size());
 
-        if (not is_in_zone)
-            break;
+    float cursor{left_edge};
+    for (size_t i{0}; i < configs.size(); ++i) {
+        const auto& [width, score]{configs[i]};
+        const float x{cursor + offsets[i]};
+        zones.push_back({
+            .start = {x, 0.0F},    // y gets set during generation of points
+            .end = {x + width, 0.0F},
+            .score_value = score,
+        });
+        cursor += width + margin;
     }
 
-    return x;
+    return zones;
 }
 
 auto Terrain_generator::generate_detailed_points(const std::vector<float>& base_curve)
     -> std::vector<glm::vec2> {
 
-    std::vector<glm::vec2> detailed_points(defs::terrain::num_terrain_points);
+    std::vector<glm::vec2> detailed_points(num_points);
 
     const float ratio{
         static_cast<float>(base_curve.size() - 1) / static_cast<float>(detailed_points.size() - 1)
@@ -233,19 +424,11 @@ auto Terrain_generator::generate_detailed_points(const std::vector<float>& base_
         const float height_b{base_curve[index_b]};
 
         detailed_points[i] = {
-            (world_width / defs::terrain::num_terrain_points) * static_cast<float>(i),
+            (world_width / static_cast<float>(num_points)) * static_cast<float>(i),
             (height_a * (1.0F - t)) + (height_b * t)
         };
     }
 
-    // // DEBUG
-    // utils::log("\ngenerate_detailed_points():");
-    // int count{0};
-    // for (const auto& point : detailed_points) {
-    //     utils::log(std::format("{}: ({:.2f}, {:.2f})", count, point.x, point.y));
-    //     count++;
-    // }
-
     return detailed_points;
 }
 
@@ -254,6 +437,7 @@ auto Terrain_generator::integrate_landing_zones(
 ) -> std::pair<std::vector<glm::vec2>, std::vector<size_t>> {
 
     std::vector<glm::vec2> final_terrain{};
+    final_terrain.reserve(source_terrain.size() + zones.size() * 2);
     std::vector<size_t> anchor_points{0};
     size_t src_cursor{0};
 
@@ -295,23 +479,6 @@ auto Terrain_generator::integrate_landing_zones(
 
     anchor_points.push_back(final_terrain.size() - 1);
 
-    // // DEBUG
-    // utils::log("\nintegrate_landing_zones():");
-    // utils::log("anchor_points:");
-    // for (const auto& anchor : anchor_points)
-    //     utils::log(
-    //         std::format(
-    //             "{}: ({:.2f}, {:.2f})", anchor, final_terrain[anchor].x, final_terrain[anchor].y
-    //         )
-    //     );
-    //
-    // utils::log("\nterrain_points:");
-    // int count{0};
-    // for (const auto& point : final_terrain) {
-    //     utils::log(std::format("{}: ({:.2f}, {:.2f})", count, point.x, point.y));
-    //     count++;
-    // }
-
     return {final_terrain, anchor_points};
 }
 
@@ -319,17 +486,23 @@ auto Terrain_generator::add_noise_to_points(
     std::vector<glm::vec2>& terrain, const std::vector<size_t>& anchor_indices
 ) -> void {
 
-    std::random_device rd;
-    std::mt19937 random_engine(rd());
-
-    std::uniform_real_distribution<float> y_distribution(
-        defs::terrain::terrain_noise * -1, defs::terrain::terrain_noise
-    );
+    std::uniform_real_distribution<float> unit_distribution(0.0F, 1.0F);
 
     const float x_limit{
         (world_width / static_cast<float>(terrain.size())) * defs::terrain::x_range_percent
     };
 
+    // vertical detail, sampled in one batch over the whole terrain
+    constexpr noise::Fbm_params detail_params{
+        .octaves = defs::terrain::detail_noise_octaves,
+        .frequency = defs::terrain::detail_noise_frequency,
+    };
+
+    std::vector<float> detail(terrain.size());
+    for (size_t i = 0; i < terrain.size(); ++i)
+        detail[i] = terrain[i].x / world_width;
+    noise::fbm_1d(detail, detail_params, static_cast<Uint32>(random_engine()), detail);
+
     // add noise - process segments between anchors
     for (size_t i = 0; i < anchor_indices.size() - 1; ++i) {
 
@@ -339,7 +512,7 @@ auto Terrain_generator::add_noise_to_points(
         for (size_t j = start_index + 1; j < end_index; ++j) {
 
             // add vertical noise - enforce height constraints
-            terrain[j].y += (terrain[j].y * y_distribution(random_engine));
+            terrain[j].y += (terrain[j].y * defs::terrain::terrain_noise * detail[j]);
             terrain[j].y = std::clamp(terrain[j].y, min_height(), max_height());
 
             // add horizontal noise - define and get random within valid range
@@ -353,45 +526,33 @@ auto Terrain_generator::add_noise_to_points(
             if (lower_bound >= upper_bound)
                 continue;
 
-            std::uniform_real_distribution<float> x_distribution(lower_bound, upper_bound);
-            terrain[j].x = x_distribution(random_engine);
+            terrain[j].x = std::lerp(lower_bound, upper_bound, unit_distribution(random_engine));
         }
     }
-
-    // // DEBUG
-    // utils::log("\nadd_noise_to_points():");
-    // int count{0};
-    // for (const auto& point : terrain) {
-    //     utils::log(std::format("{}: ({:.2f}, {:.2f})", count, point.x, point.y));
-    //     count++;
-    // }
 }
 
 auto Terrain_generator::add_noise_to_curve(std::vector<float>& heights) -> void {
 
-    std::random_device rd;
-    std::mt19937 random_engine(rd());
+    constexpr noise::Fbm_params curve_params{
+        .octaves = defs::terrain::curve_noise_octaves,
+        .frequency = defs::terrain::curve_noise_frequency,
+    };
+    constexpr noise::Fbm_params warp_params{.octaves = 2, .frequency = 1.0F};
 
-    constexpr float base_noise{defs::terrain::base_curve_noise / 100.0F};
-    constexpr float freq{5.0F};
-    constexpr float amp{0.2f};
+    const auto seed{static_cast<Uint32>(random_engine())};
 
-    std::uniform_real_distribution<float> y_distribution(base_noise * -1, base_noise);
-    std::uniform_real_distribution<float> phase_distribution(std::numbers::pi_v<float> / 8.0F);
+    // sample positions along the curve, warped so features aren't evenly spaced
+    std::vector<float> positions(heights.size());
+    const float step{1.0F / static_cast<float>(heights.size() - 1)};
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = static_cast<float>(i) * step;
+    noise::warp_1d(positions, defs::terrain::curve_warp_strength, warp_params, seed + 1);
 
-    // for (auto& y : heights)
-    //     y += y_distribution(random_engine);
+    std::vector<float> offsets(heights.size());
+    noise::fbm_1d(positions, curve_params, seed, offsets);
 
-    for (int i = 0; i < heights.size() - 1; ++i) {
-        // calculate normalized progress 't', 0.0 - 1.0
-        const float t{static_cast<float>(i) / static_cast<float>(heights.size() - 1)};
-        const float noise{
-            std::sin(t * freq * std::numbers::pi_v<float> + phase_distribution(random_engine)) *
-                amp +
-            y_distribution(random_engine)
-        };
-        heights[i] += noise;
-    }
+    for (size_t i = 0; i < heights.size(); ++i)
+        heights[i] += offsets[i] * defs::terrain::curve_noise_amplitude;
 }
 
 auto Terrain_generator::rescale_curve(std::vector<float>& heights) -> void {
@@ -416,36 +577,126 @@ auto Terrain_generator::rescale_curve(std::vector<float>& heights) -> void {
     }
 }
 
+// Terrain x values must be ascending
 auto Terrain_generator::interpolate_height(const std::vector<glm::vec2>& terrain, const float x)
     -> float {
 
-    // find the two points that bracket x
-    for (size_t i = 0; i < terrain.size() - 1; ++i) {
-        if (terrain[i].x <= x && terrain[i + 1].x >= x) {
-            const glm::vec2& p1 = terrain[i];
-            const glm::vec2& p2 = terrain[i + 1];
+    // if x is outside bounds, return closest end
+    if (x <= terrain.front().x)
+        return terrain.front().y;
+    if (x >= terrain.back().x)
+        return terrain.back().y;
 
-            // avoid division by 0
-            if (p2.x == p1.x)
-                return p1.y;
+    // binary search for the first point past x, the one before it brackets x from below
+    const auto upper{std::ranges::upper_bound(terrain, x, {}, &glm::vec2::x)};
+    const glm::vec2& p1 = *(upper - 1);
+    const glm::vec2& p2 = *upper;
 
-            // linearly interpolate
-            float t{(x - p1.x) / (p2.x - p1.x)};
-            return p1.y * (1.0F - t) + p2.y * t;
-        }
+    // avoid division by 0
+    if (p2.x == p1.x)
+        return p1.y;
+
+    // linearly interpolate
+    const float t{(x - p1.x) / (p2.x - p1.x)};
+    return p1.y * (1.0F - t) + p2.y * t;
+}
+
+auto Terrain_generator::build_lod_chain(
+    const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors
+) -> std::vector<defs::types::terrain::Terrain_lod> {
+
+    std::vector<defs::types::terrain::Terrain_lod> lods{};
+    lods.reserve(defs::terrain::num_lod_levels);
+
+    // level 0 keeps every point
+    defs::types::terrain::Terrain_lod full{.indices = {}, .max_error = 0.0F};
+    full.indices.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        full.indices[i] = static_cast<Uint32>(i);
+    lods.push_back(std::move(full));
+
+    // coarser levels simplify each span between anchors independently,
+    // so landing zone edges stay exactly where they are
+    float tolerance{defs::terrain::lod_base_error};
+    for (int level = 1; level < defs::terrain::num_lod_levels; ++level) {
+        defs::types::terrain::Terrain_lod lod{.indices = {}, .max_error = tolerance};
+
+        simplify_span(points, anchors, 0, points.size() - 1, tolerance, lod.indices);
+        lod.indices.push_back(static_cast<Uint32>(anchors.back()));
+
+        lods.push_back(std::move(lod));
+        tolerance *= defs::terrain::lod_error_factor;
     }
 
-    // if x is outside bounds, return closest end
-    if (x < terrain.front().x)
-        return terrain.front().y;
+    return lods;
+}
+
+// Simplifies [first, last] without crossing an anchor, appends kept indices except 'last'
+// long spans are cut into fixed windows, bounds the cost to n log(window) at the price
+// of keeping a few extra points on window edges
+auto Terrain_generator::simplify_span(
+    const std::vector<glm::vec2>& points, const std::vector<size_t>& anchors, const size_t first,
+    const size_t last, const float tolerance, std::vector<Uint32>& kept
+) -> void {
 
-    return terrain.back().y;
+    auto next_anchor{std::ranges::upper_bound(anchors, first)};
+
+    for (size_t start{first}; start < last;) {
+        size_t stop{last};
+        if (next_anchor != anchors.end() && *next_anchor < last)
+            stop = *next_anchor;
+        stop = std::min(stop, start + defs::terrain::lod_max_span_points);
+
+        simplify_range(points, start, stop, tolerance, kept);
+
+        if (next_anchor != anchors.end() && *next_anchor == stop)
+            ++next_anchor;
+        start = stop;
+    }
 }
 
-auto Terrain_generator::random_shape() const -> defs::terrain::Shape {
+// Douglas-Peucker over [first, last], appends kept indices except 'last'
+auto Terrain_generator::simplify_range(
+    const std::vector<glm::vec2>& points, const size_t first, const size_t last,
+    const float tolerance, std::vector<Uint32>& kept
+) -> void {
+
+    if (last <= first)
+        return;
+
+    // explicit stack, recursion depth could reach the point count on large terrain
+    std::vector<std::pair<size_t, size_t>> stack{{first, last}};
+    std::vector<size_t> split_points{first};
+
+    while (not stack.empty()) {
+        const auto [a, b]{stack.back()};
+        stack.pop_back();
+
+        // find the point furthest from the segment a-b
+        float max_dist_sq{0.0F};
+        size_t max_index{a};
+        for (size_t i = a + 1; i < b; ++i) {
+            const float dist_sq{segment_distance_sq(points[i], points[a], points[b])};
+
+            if (dist_sq > max_dist_sq) {
+                max_dist_sq = dist_sq;
+                max_index = i;
+            }
+        }
+
+        if (max_dist_sq > tolerance * tolerance) {
+            split_points.push_back(max_index);
+            stack.push_back({max_index, b});
+            stack.push_back({a, max_index});
+        }
+    }
+
+    std::ranges::sort(split_points);
+    for (const size_t index : split_points)
+        kept.push_back(static_cast<Uint32>(index));
+}
 
-    std::random_device rd;
-    std::mt19937 random_engine(rd());
+auto Terrain_generator::random_shape() -> defs::terrain::Shape {
 
     std::uniform_int_distribution<int> shape_distribution(
         0, static_cast<int>(defs::terrain::Shape::Count) - 1
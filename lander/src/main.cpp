@@ -6,8 +6,12 @@
 
 #include <SDL3/SDL_main.h>
 #include <app.h>
+#include <level_baker.h>
+#include <render_benchmark.h>
+#include <terrain_benchmark.h>
 #include <utils.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -20,6 +24,31 @@ auto SDL_AppInit(void** appstate, int argc, char* argv[]) -> SDL_AppResult {
     SDL_SetLogPriority(SDL_LOG_CATEGORY_CUSTOM, SDL_LOG_PRIORITY_DEBUG);
     SDL_SetLogPriorities(SDL_LOG_PRIORITY_VERBOSE);
 
+    // run terrain scaling benchmark and exit
+    const std::vector<std::string> args(argv, argv + argc);
+    if (std::ranges::find(args, "--terrain-benchmark") != args.end()) {
+        auto bench{terrain_benchmark::run()};
+        if (not bench)
+            utils::log(bench.error());
+        return bench ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // run headless render benchmark against the null gpu device and exit
+    if (std::ranges::find(args, "--render-benchmark") != args.end()) {
+        auto bench{render_benchmark::run()};
+        if (not bench)
+            utils::log(bench.error());
+        return bench ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // bake the curated level set next to the executable and exit
+    if (std::ranges::find(args, "--bake-levels") != args.end()) {
+        auto baked{level_baker::bake(defs::paths::base_path / defs::paths::level_path)};
+        if (not baked)
+            utils::log(baked.error());
+        return baked ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
     auto app{std::make_unique<App>()};
 
     auto result{app->init()};
@@ -81,9 +110,12 @@ auto SDL_AppIterate(void* appstate) -> SDL_AppResult {
 auto SDL_AppQuit(void* appstate, SDL_AppResult result) -> void {
     auto* app{static_cast<App*>(appstate)};
 
-    // app->shutdown();
-    app->quit();
-    delete static_cast<App*>(appstate);
+    // appstate is null when init exits early (failure or benchmark run)
+    if (app) {
+        // app->shutdown();
+        app->quit();
+        delete app;
+    }
 
     result == SDL_APP_SUCCESS ? SDL_Log("App quit successfully!") : SDL_Log("App failure.");
     // SDL_Log("App quit successfully!");
@@ -7,15 +7,33 @@
 #include <definitions.h>
 
 #include <glm/glm/mat4x4.hpp>
+#include <span>
 
 struct Render_mesh_command {
     Uint32 pipeline_id;        // where to send data, req for sorting
     Uint32 mesh_id;            // may be useful for different shapes
     glm::mat4 model_matrix;    // transform matrix
-    // not sure about having color here, rather than per vertex in mesh?
-    // glm::vec4 color;    // prefer to SDL_color for doing math
-    float depth;    // for layering
+    float depth;               // for layering
     // size_t vertex_count;
+    glm::vec4 tint{1.0F};    // multiplies the mesh's vertex colors, prefer to SDL_color for math
+};
+
+// Sprites sharing one atlas texture, kept in the layout the sprite shader reads so the
+// renderer copies them out in one go
+struct Render_sprite_batch {
+    Uint32 texture_id;
+    std::vector<defs::types::shader::Sprite_instance> sprites;
+
+    Uint32 first_sprite{0};    // into the sprite buffer, set by the renderer
+};
+
+// One material's particles, already sprites in the layout the sprite shader reads
+// The instances belong to the particle system and stay put until the frame is rendered
+struct Render_particle_batch {
+    Uint32 texture_id;
+    std::span<const defs::types::shader::Sprite_instance> particles;
+
+    Uint32 first_particle{0};    // into the particle buffer, set by the renderer
 };
 
 // struct Render_ui_command {
@@ -24,15 +42,11 @@ struct Render_mesh_command {
 
 struct Render_text_command {
     // Uint32 pipeline_id;
+    Uint32 text_id;     // the renderer keeps each text's glyphs until these change
+    Uint32 revision;    // (or the model matrix does)
     TTF_GPUAtlasDrawSequence* draw_data;
     glm::mat4 model_matrix;
     float depth;
-
-    // batch rendering - byte offsets in buffer, totals for all glyphs
-    size_t vertex_offset{0};
-    size_t index_offset{0};
-    size_t vertex_count{0};
-    size_t index_count{0};
 };
 
 #endif    // SDL3_GAME_RENDER_COMMAND_H
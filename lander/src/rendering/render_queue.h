@@ -4,18 +4,44 @@
 #define SDL3_GAME_RENDER_QUEUE_H
 
 #include <render_command.h>
+#include <sort_key.h>
+
+#include <algorithm>
+#include <span>
 
 // Collected each frame by game systems
 class Render_queue {
 public:
     std::vector<Render_mesh_command> opaque_commands;
     std::vector<Render_mesh_command> transparent_commands;
+    // opaque commands already in draw order, when whoever queued them sorted them too
+    // only used while it covers every opaque command, the renderer sorts otherwise
+    std::vector<sort_key::Entry> opaque_order;
     std::vector<Render_text_command> text_commands;
+    // one per atlas, kept between frames so their storage is reused
+    std::vector<Render_sprite_batch> sprite_batches;
+    std::vector<Render_particle_batch> particle_batches;
+    // debug_draw's line list, referenced rather than copied
+    std::span<const defs::types::vertex::Mesh_vertex> debug_lines;
+
+    auto add_sprites(
+        const Uint32 texture_id, const std::span<const defs::types::shader::Sprite_instance> sprites
+    ) -> void {
+        auto it{std::ranges::find(sprite_batches, texture_id, &Render_sprite_batch::texture_id)};
+        if (it == sprite_batches.end())
+            it = sprite_batches.insert(sprite_batches.end(), {.texture_id = texture_id});
+        it->sprites.insert(it->sprites.end(), sprites.begin(), sprites.end());
+    }
 
     auto clear() -> void {
         opaque_commands.clear();
+        opaque_order.clear();
         transparent_commands.clear();
         text_commands.clear();
+        for (auto& batch : sprite_batches)
+            batch.sprites.clear();
+        particle_batches.clear();
+        debug_lines = {};
         // ui_commands.clear();
     }
 };
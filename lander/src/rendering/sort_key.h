@@ -0,0 +1,220 @@
+
+
+#ifndef SDL3_GAME_SORT_KEY_H
+#define SDL3_GAME_SORT_KEY_H
+
+#include <SDL3/SDL.h>
+#include <job_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Draws are ordered by one packed 64 bit key, most significant field first:
+//     pass 4 | pipeline 12 | material 12 | mesh 20 | depth 16
+// so sorting the keys groups state changes from most to least expensive, and walking
+// them in order only needs a bind where a field differs from the previous key
+// Blended passes need far to near instead, their keys put inverted depth first:
+//     pass 4 | far depth 16 | pipeline 12 | material 12 | mesh 20
+namespace sort_key {
+
+    enum class Pass : Uint8 {
+        Background = 0,
+        Opaque,
+        Transparent,
+        Ui,
+    };
+
+    inline constexpr int depth_bits{16};
+    inline constexpr int mesh_bits{20};
+    inline constexpr int material_bits{12};
+    inline constexpr int pipeline_bits{12};
+    inline constexpr int pass_bits{4};
+
+    inline constexpr int mesh_shift{depth_bits};
+    inline constexpr int material_shift{mesh_shift + mesh_bits};
+    inline constexpr int pipeline_shift{material_shift + material_bits};
+    inline constexpr int pass_shift{pipeline_shift + pipeline_bits};
+    static_assert(pass_shift + pass_bits == 64);
+
+    // back to front layout, same widths in a different order
+    inline constexpr int far_mesh_shift{0};
+    inline constexpr int far_material_shift{mesh_bits};
+    inline constexpr int far_pipeline_shift{far_material_shift + material_bits};
+    inline constexpr int far_depth_shift{far_pipeline_shift + pipeline_bits};
+    static_assert(far_depth_shift + depth_bits == pass_shift);
+
+    [[nodiscard]] constexpr auto field(const Uint64 key, const int shift, const int bits)
+        -> Uint32 {
+        return static_cast<Uint32>((key >> shift) & ((Uint64{1} << bits) - 1));
+    }
+
+    // Depth in [0, 1] quantized to the key's resolution, values outside are clamped
+    [[nodiscard]] inline auto quantize_depth(const float depth) -> Uint32 {
+        constexpr float max_depth{static_cast<float>((1U << depth_bits) - 1)};
+        return static_cast<Uint32>(std::lround(std::clamp(depth, 0.0F, 1.0F) * max_depth));
+    }
+
+    [[nodiscard]] constexpr auto place(const Uint32 value, const int bits, const int shift)
+        -> Uint64 {
+        return (Uint64{value} & ((Uint64{1} << bits) - 1)) << shift;
+    }
+
+    // Ids wider than their field wrap, that only costs batching, never correctness,
+    // as long as draws read their real ids from the command and not the key
+    [[nodiscard]] constexpr auto encode(
+        const Pass pass, const Uint32 pipeline_id, const Uint32 material_id,
+        const Uint32 mesh_id, const Uint32 depth
+    ) -> Uint64 {
+        return place(static_cast<Uint32>(pass), pass_bits, pass_shift) |
+               place(pipeline_id, pipeline_bits, pipeline_shift) |
+               place(material_id, material_bits, material_shift) |
+               place(mesh_id, mesh_bits, mesh_shift) | place(depth, depth_bits, 0);
+    }
+
+    // Same fields in the back to front layout, the farthest draw sorts first
+    [[nodiscard]] constexpr auto encode_back_to_front(
+        const Pass pass, const Uint32 pipeline_id, const Uint32 material_id,
+        const Uint32 mesh_id, const Uint32 depth
+    ) -> Uint64 {
+        constexpr Uint32 max_depth{(1U << depth_bits) - 1};
+        return place(static_cast<Uint32>(pass), pass_bits, pass_shift) |
+               place(max_depth - (depth & max_depth), depth_bits, far_depth_shift) |
+               place(pipeline_id, pipeline_bits, far_pipeline_shift) |
+               place(material_id, material_bits, far_material_shift) |
+               place(mesh_id, mesh_bits, far_mesh_shift);
+    }
+
+    [[nodiscard]] constexpr auto pipeline_of(const Uint64 key) -> Uint32 {
+        return field(key, pipeline_shift, pipeline_bits);
+    }
+
+    // Everything above depth, equal state means the draws can share a batch
+    // (front to back layout only)
+    [[nodiscard]] constexpr auto state_of(const Uint64 key) -> Uint64 {
+        return key >> depth_bits;
+    }
+
+    struct Entry {
+        Uint64 key;
+        Uint32 index;    // into the command list the key was built from
+    };
+
+    // Stable lsd radix sort, a byte per pass with every histogram counted in one read, passes
+    // where every key shares the byte are skipped (usually the pass and high id bits)
+    // scratch must be as large as entries, nothing is allocated, the result ends up in entries
+    inline auto radix_sort(std::span<Entry> entries, std::span<Entry> scratch) -> void {
+        if (entries.size() < 2)
+            return;
+
+        std::array<std::array<size_t, 256>, 8> counts{};
+        for (const Entry& entry : entries)
+            for (size_t byte = 0; byte < 8; ++byte)
+                ++counts[byte][(entry.key >> (byte * 8)) & 0xFF];
+
+        std::span<Entry> source{entries};
+        std::span<Entry> destination{scratch.first(entries.size())};
+
+        for (size_t byte = 0; byte < 8; ++byte) {
+            const size_t shift{byte * 8};
+            if (counts[byte][(source.front().key >> shift) & 0xFF] == source.size())
+                continue;
+
+            size_t offset{0};
+            for (size_t& count : counts[byte])
+                offset += std::exchange(count, offset);
+
+            for (const Entry& entry : source)
+                destination[counts[byte][(entry.key >> shift) & 0xFF]++] = entry;
+
+            std::swap(source, destination);
+        }
+
+        if (source.data() != entries.data())
+            std::ranges::copy(source, entries.begin());
+    }
+
+    // Below this many entries per chunk the threads cost more than they save
+    inline constexpr size_t parallel_sort_chunk{16 * 1024};
+
+    // Per chunk digit counts for the parallel sort, kept by the caller like the entry scratch
+    // so sorting every frame allocates nothing once the chunk count settles
+    struct Histograms {
+        std::vector<std::array<std::array<size_t, 256>, 8>> totals;
+        std::vector<std::array<size_t, 256>> offsets;
+    };
+
+    // Same sort split over contiguous chunks, one per worker plus the caller
+    // Each pass counts every chunk's digits in parallel, turns them into per chunk offsets
+    // (digit major, chunk minor, which keeps it stable) and scatters the chunks in parallel
+    // Small inputs or a pool without threads fall back to the serial sort
+    inline auto radix_sort(
+        std::span<Entry> entries, std::span<Entry> scratch, Histograms& histograms, Job_pool& jobs
+    ) -> void {
+        const size_t chunk_count{
+            std::min(jobs.thread_count() + 1, entries.size() / parallel_sort_chunk)
+        };
+        if (chunk_count < 2) {
+            radix_sort(entries, scratch);
+            return;
+        }
+
+        const size_t chunk_size{(entries.size() + chunk_count - 1) / chunk_count};
+        const auto chunk{[&](const std::span<Entry> all, const size_t index) {
+            const size_t first{std::min(index * chunk_size, all.size())};
+            return all.subspan(first, std::min(chunk_size, all.size() - first));
+        }};
+
+        // whole input histograms, only to find the passes that can be skipped
+        auto& totals{histograms.totals};
+        totals.assign(chunk_count, {});
+        jobs.parallel_for(chunk_count, [&](const size_t index) {
+            for (const Entry& entry : chunk(entries, index))
+                for (size_t byte = 0; byte < 8; ++byte)
+                    ++totals[index][byte][(entry.key >> (byte * 8)) & 0xFF];
+        });
+
+        auto& offsets{histograms.offsets};
+        offsets.resize(chunk_count);
+        std::span<Entry> source{entries};
+        std::span<Entry> destination{scratch.first(entries.size())};
+
+        for (size_t byte = 0; byte < 8; ++byte) {
+            const size_t shift{byte * 8};
+            const auto digit{[shift](const Entry& entry) { return (entry.key >> shift) & 0xFF; }};
+
+            size_t shared{0};
+            for (const auto& total : totals)
+                shared += total[byte][digit(source.front())];
+            if (shared == source.size())
+                continue;
+
+            jobs.parallel_for(chunk_count, [&](const size_t index) {
+                offsets[index].fill(0);
+                for (const Entry& entry : chunk(source, index))
+                    ++offsets[index][digit(entry)];
+            });
+
+            size_t offset{0};
+            for (size_t value = 0; value < 256; ++value)
+                for (auto& chunk_offsets : offsets)
+                    offset += std::exchange(chunk_offsets[value], offset);
+
+            jobs.parallel_for(chunk_count, [&](const size_t index) {
+                for (const Entry& entry : chunk(source, index))
+                    destination[offsets[index][digit(entry)]++] = entry;
+            });
+
+            std::swap(source, destination);
+        }
+
+        if (source.data() != entries.data())
+            std::ranges::copy(source, entries.begin());
+    }
+
+}    // namespace sort_key
+
+#endif    // SDL3_GAME_SORT_KEY_H
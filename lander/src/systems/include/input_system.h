@@ -21,6 +21,10 @@ public:
     auto terrain_debug(
         const std::vector<std::unique_ptr<Game_object>>& objects, const Input_state& state
     ) -> bool;
+
+    auto crater_debug(
+        const std::vector<std::unique_ptr<Game_object>>& objects, const Input_state& state
+    ) -> bool;
 };
 
 #endif    // SDL3_GAME_INPUT_SYSTEM_H
@@ -0,0 +1,81 @@
+
+
+#ifndef SDL3_GAME_PARTICLE_SYSTEM_H
+#define SDL3_GAME_PARTICLE_SYSTEM_H
+
+#include <definitions.h>
+#include <game_object.h>
+#include <job_pool.h>
+
+#include <array>
+#include <random>
+#include <span>
+#include <vector>
+
+// Cpu particles for exhaust, dust and explosions, one pool and one draw per material
+// Pools are structures of arrays, integrated four particles at a time with SSE2 and split
+// in chunks across the particle workers once they are large enough
+// Storage only grows, up to each material's limit, so steady frames allocate nothing
+class Particle_system {
+private:
+    // Particles alive are the first count entries of every array
+    struct Pool {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> velocity_x;
+        std::vector<float> velocity_y;
+        std::vector<float> age;         // 0 at spawn, dead at 1
+        std::vector<float> age_rate;    // 1 / lifetime
+        std::vector<defs::types::shader::Sprite_instance> instances;    // last written
+        size_t count{0};
+    };
+
+    // What every chunk of one parallel pass reads
+    struct Pass {
+        Pool* pool;
+        const defs::particles::Material_desc* desc;
+        size_t chunk_size;
+        float seconds;
+    };
+
+    std::array<Pool, defs::particles::material_count> pools;
+    Job_pool jobs;
+    std::mt19937 random_engine{defs::particles::seed};
+
+public:
+    Particle_system() = default;
+    ~Particle_system() = default;
+
+    // Zero threads updates everything on the calling thread
+    auto init(size_t max_threads = defs::particles::max_threads) -> void;
+
+    // Spawns from active emitters, then moves and ages every particle by dt
+    auto iterate(const std::vector<std::unique_ptr<Game_object>>& objects, float dt) -> void;
+    // count particles at once from position, spread around direction
+    auto emit_burst(
+        defs::particles::Material material, glm::vec2 position, glm::vec2 direction,
+        Uint32 count, glm::vec2 base_velocity = {0.0F, 0.0F}
+    ) -> void;
+
+    // Turns every live particle into a sprite, once per rendered frame
+    auto write_instances() -> void;
+    // What write_instances produced, valid until the next call
+    [[nodiscard]] auto get_instances(defs::particles::Material material) const
+        -> std::span<const defs::types::shader::Sprite_instance>;
+    [[nodiscard]] auto get_count() const -> size_t;
+
+private:
+    auto spawn(
+        defs::particles::Material material, glm::vec2 position, glm::vec2 direction,
+        size_t count, glm::vec2 base_velocity, float seconds
+    ) -> void;
+    // Room for count more particles, returns how many fit under the material's limit
+    static auto reserve(Pool& pool, size_t count, size_t limit) -> size_t;
+    auto run_pass(Pass pass, void (*chunk)(const Pass&, size_t, size_t)) -> void;
+
+    static auto integrate_chunk(const Pass& pass, size_t first, size_t last) -> void;
+    static auto write_chunk(const Pass& pass, size_t first, size_t last) -> void;
+    static auto remove_dead(Pool& pool) -> void;
+};
+
+#endif    // SDL3_GAME_PARTICLE_SYSTEM_H
@@ -6,23 +6,93 @@
 #include <SDL3/SDL_gpu.h>
 #include <definitions.h>
 #include <game_object.h>
+#include <job_pool.h>
 #include <render_queue.h>
+#include <resource_manager.h>
 
 // Game system that collects renderable data
 class Render_system {
 private:
+    // The world rectangle the camera sees
+    struct View_rect {
+        glm::vec2 center{0.0F};
+        glm::vec2 half_size{std::numeric_limits<float>::infinity()};
+    };
+
+    // An object that passed the component checks, no transform means terrain (identity)
+    struct Candidate {
+        const C_transform* transform;
+        const C_render* render;
+        Uint32 mesh_id;
+    };
+
+    // What one worker collected from its chunk of objects, keys index into commands
+    // Candidates keep their world bounding circles side by side for the batched view test
+    struct Segment {
+        std::vector<Render_mesh_command> commands;
+        std::vector<sort_key::Entry> entries;
+        std::vector<Candidate> candidates;
+        std::vector<float> center_x;
+        std::vector<float> center_y;
+        std::vector<float> radius;
+        std::vector<Uint8> visible;
+    };
+
     Render_queue render_queue;
+    const Resource_manager* resource_manager{nullptr};    // mesh bounds, none culls nothing
+    size_t culled_count{0};
+
+    Job_pool collect_jobs;
+    std::vector<Segment> segments;    // one per chunk, kept so their storage is reused
+    std::vector<size_t> segment_offsets;    // where each segment merges into the queue
+    std::vector<sort_key::Entry> sort_scratch;
+    sort_key::Histograms sort_histograms;
 
 public:
     Render_system() = default;
     ~Render_system() = default;
 
+    // Zero threads collects everything on the calling thread
+    auto init(
+        const Resource_manager& res_manager,
+        size_t max_threads = defs::pipelines::max_collect_threads
+    ) -> void;
+
     // collect objects with transform/terrain, mesh, render
-    auto collect_renderables(const std::vector<std::unique_ptr<Game_object>>& objects) -> void;
+    // objects whose mesh bounds fall outside the camera's view are left out
+    // large object lists are split in chunks across the collect workers, the merged
+    // commands come with their opaque draw order already sorted
+    auto collect_renderables(
+        const std::vector<std::unique_ptr<Game_object>>& objects,
+        const defs::types::camera::Frame_data& frame_data
+    ) -> void;
     auto collect_text(const std::vector<defs::types::text::Text>& objects) -> void;
+    auto collect_sprites(
+        Uint32 texture_id, std::span<const defs::types::shader::Sprite_instance> sprites
+    ) -> void;
+    // one material's particles, referenced rather than copied
+    auto collect_particles(
+        Uint32 texture_id, std::span<const defs::types::shader::Sprite_instance> particles
+    ) -> void;
+    // debug_draw's lines, drawn over everything
+    auto collect_debug_lines(std::span<const defs::types::vertex::Mesh_vertex> vertices) -> void;
 
     auto get_queue() -> Render_queue* { return &render_queue; }
+    [[nodiscard]] auto get_thread_count() const -> size_t { return collect_jobs.thread_count(); }
+    // objects the last collect_renderables left out for being off screen
+    [[nodiscard]] auto get_culled_count() const -> size_t { return culled_count; }
     auto clear_queue() -> void { render_queue.clear(); }
+
+private:
+    static auto get_view_rect(const defs::types::camera::Frame_data& frame_data) -> View_rect;
+    static auto collect_chunk(
+        std::span<const std::unique_ptr<Game_object>> objects,
+        const defs::types::camera::Frame_data& frame_data, const View_rect& view,
+        std::span<const defs::types::vertex::Mesh_bounds> bounds, Segment& segment
+    ) -> void;
+    // Fills segment.visible, circles touching the view rectangle pass
+    static auto cull_candidates(const View_rect& view, Segment& segment) -> void;
+    auto merge_segments(size_t segment_count) -> void;
 };
 
 #endif    // SDL3_GAME_RENDER_SYSTEM_H
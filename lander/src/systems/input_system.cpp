@@ -1,10 +1,12 @@
 
 
 #include <input_system.h>
+#include <profiler.h>
 
 auto Input_system::iterate(
     const std::vector<std::unique_ptr<Game_object>>& objects, const Input_state& state
 ) -> void {
+    PROFILE_ZONE("Input_system::iterate");
 
     for (const auto& obj : objects) {
         C_player_controller* controller{obj->get_component<C_player_controller>()};
@@ -38,3 +40,18 @@ auto Input_system::terrain_debug(
     return false;
 }
 
+
+auto Input_system::crater_debug(
+    const std::vector<std::unique_ptr<Game_object>>& objects, const Input_state& state
+) -> bool {
+
+    for (const auto& obj : objects) {
+        C_terrain_points* terrain_points{obj->get_component<C_terrain_points>()};
+
+        if (terrain_points)
+            if (state.is_c)
+                return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,253 @@
+
+
+#include <particle_system.h>
+#include <profiler.h>
+
+#include <glm/glm/common.hpp>
+#include <glm/glm/trigonometric.hpp>
+#include <algorithm>
+#include <cmath>
+
+// x86-64 always has sse2, other targets take the scalar integration path
+#if defined(__SSE2__) || defined(_M_X64)
+#define PARTICLE_SSE2
+#include <xmmintrin.h>
+#endif
+
+auto Particle_system::init(const size_t max_threads) -> void {
+    // one core stays with the main thread, which updates a chunk itself
+    const auto spare_cores{static_cast<size_t>(std::max(SDL_GetNumLogicalCPUCores() - 1, 1))};
+    jobs.init(std::min(spare_cores, max_threads), "particle");
+}
+
+auto Particle_system::iterate(
+    const std::vector<std::unique_ptr<Game_object>>& objects, const float dt
+) -> void {
+    PROFILE_ZONE("Particle_system::iterate");
+
+    for (const auto& obj : objects) {
+        C_emitter* emitter{obj->get_component<C_emitter>()};
+        const C_transform* transform{obj->get_component<C_transform>()};
+        if (not emitter || not transform)
+            continue;
+
+        if (not emitter->active) {
+            emitter->pending = 0.0F;
+            continue;
+        }
+
+        // whole particles only, the rest waits for the next step
+        emitter->pending += emitter->rate * dt;
+        const float whole{std::floor(emitter->pending)};
+        emitter->pending -= whole;
+        if (whole < 1.0F)
+            continue;
+
+        const float angle{glm::radians(transform->rotation)};
+        const float cos_a{std::cos(angle)};
+        const float sin_a{std::sin(angle)};
+        const auto rotate{[cos_a, sin_a](const glm::vec2 v) {
+            return glm::vec2{(cos_a * v.x) - (sin_a * v.y), (sin_a * v.x) + (cos_a * v.y)};
+        }};
+
+        const C_physics* physics{obj->get_component<C_physics>()};
+        spawn(
+            emitter->material, transform->position + rotate(emitter->offset * transform->scale),
+            rotate(emitter->direction), static_cast<size_t>(whole),
+            physics ? physics->velocity : glm::vec2{0.0F}, dt
+        );
+    }
+
+    for (size_t i{0}; i < pools.size(); ++i) {
+        if (pools[i].count == 0)
+            continue;
+
+        run_pass(
+            {.pool = &pools[i], .desc = &defs::particles::materials[i], .seconds = dt},
+            integrate_chunk
+        );
+        remove_dead(pools[i]);
+    }
+}
+
+auto Particle_system::emit_burst(
+    const defs::particles::Material material, const glm::vec2 position, const glm::vec2 direction,
+    const Uint32 count, const glm::vec2 base_velocity
+) -> void {
+    spawn(material, position, direction, count, base_velocity, 0.0F);
+}
+
+auto Particle_system::write_instances() -> void {
+    PROFILE_ZONE("Particle_system::write_instances");
+
+    for (size_t i{0}; i < pools.size(); ++i) {
+        // within capacity after the pool's largest frame, so no allocation
+        pools[i].instances.resize(pools[i].count);
+        if (pools[i].count == 0)
+            continue;
+
+        run_pass({.pool = &pools[i], .desc = &defs::particles::materials[i]}, write_chunk);
+    }
+}
+
+auto Particle_system::get_instances(const defs::particles::Material material) const
+    -> std::span<const defs::types::shader::Sprite_instance> {
+    return pools[static_cast<size_t>(material)].instances;
+}
+
+auto Particle_system::get_count() const -> size_t {
+    size_t total{0};
+    for (const Pool& pool : pools)
+        total += pool.count;
+    return total;
+}
+
+auto Particle_system::spawn(
+    const defs::particles::Material material, const glm::vec2 position, const glm::vec2 direction,
+    const size_t count, const glm::vec2 base_velocity, const float seconds
+) -> void {
+    const auto index{static_cast<size_t>(material)};
+    const defs::particles::Material_desc& desc{defs::particles::materials[index]};
+    Pool& pool{pools[index]};
+
+    const size_t spawned{reserve(pool, count, desc.max_particles)};
+
+    std::uniform_real_distribution<float> spread_dist{-desc.spread, desc.spread};
+    std::uniform_real_distribution<float> speed_dist{desc.speed_min, desc.speed_max};
+    std::uniform_real_distribution<float> lifetime_dist{desc.lifetime_min, desc.lifetime_max};
+    std::uniform_real_distribution<float> step_dist{0.0F, 1.0F};
+    const float heading{std::atan2(direction.y, direction.x)};
+
+    for (size_t i{pool.count}; i < pool.count + spawned; ++i) {
+        const float angle{heading + spread_dist(random_engine)};
+        const float speed{speed_dist(random_engine)};
+        const glm::vec2 velocity{
+            base_velocity + (glm::vec2{std::cos(angle), std::sin(angle)} * speed)
+        };
+        // spread over the step they were emitted in, so a stream does not come out in clumps
+        const float lead{step_dist(random_engine) * seconds};
+
+        pool.x[i] = position.x + (velocity.x * lead);
+        pool.y[i] = position.y + (velocity.y * lead);
+        pool.velocity_x[i] = velocity.x;
+        pool.velocity_y[i] = velocity.y;
+        pool.age_rate[i] = 1.0F / lifetime_dist(random_engine);
+        pool.age[i] = lead * pool.age_rate[i];
+    }
+    pool.count += spawned;
+}
+
+auto Particle_system::reserve(Pool& pool, const size_t count, const size_t limit) -> size_t {
+    const size_t wanted{std::min(pool.count + count, limit)};
+    if (wanted > pool.x.size()) {
+        const size_t capacity{std::min(
+            std::max({pool.x.size() * 2, wanted, defs::particles::initial_capacity}), limit
+        )};
+        for (std::vector<float>* array :
+             {&pool.x, &pool.y, &pool.velocity_x, &pool.velocity_y, &pool.age, &pool.age_rate})
+            array->resize(capacity);
+        pool.instances.reserve(capacity);
+    }
+    return wanted - pool.count;
+}
+
+auto Particle_system::run_pass(Pass pass, void (*chunk)(const Pass&, size_t, size_t)) -> void {
+    const size_t count{pass.pool->count};
+
+    // a chunk per worker once there are enough particles to go around
+    const size_t chunk_count{std::clamp<size_t>(
+        count / defs::particles::chunk_particles, 1, jobs.thread_count() + 1
+    )};
+    pass.chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    jobs.parallel_for(chunk_count, [&pass, chunk](const size_t index) {
+        const size_t first{std::min(index * pass.chunk_size, pass.pool->count)};
+        chunk(pass, first, std::min(first + pass.chunk_size, pass.pool->count));
+    });
+}
+
+auto Particle_system::integrate_chunk(const Pass& pass, const size_t first, const size_t last)
+    -> void {
+    PROFILE_ZONE("Particle_system::integrate_chunk");
+
+    Pool& pool{*pass.pool};
+    const float dt{pass.seconds};
+    const float fall{defs::particles::gravity * pass.desc->gravity_scale * dt};
+    const float damping{std::max(1.0F - (pass.desc->drag * dt), 0.0F)};
+
+    size_t i{first};
+#if defined(PARTICLE_SSE2)
+    const __m128 dt_4{_mm_set1_ps(dt)};
+    const __m128 fall_4{_mm_set1_ps(fall)};
+    const __m128 damping_4{_mm_set1_ps(damping)};
+
+    for (; i + 4 <= last; i += 4) {
+        const __m128 velocity_x{_mm_mul_ps(_mm_loadu_ps(&pool.velocity_x[i]), damping_4)};
+        const __m128 velocity_y{
+            _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&pool.velocity_y[i]), fall_4), damping_4)
+        };
+        _mm_storeu_ps(&pool.velocity_x[i], velocity_x);
+        _mm_storeu_ps(&pool.velocity_y[i], velocity_y);
+        _mm_storeu_ps(
+            &pool.x[i], _mm_add_ps(_mm_loadu_ps(&pool.x[i]), _mm_mul_ps(velocity_x, dt_4))
+        );
+        _mm_storeu_ps(
+            &pool.y[i], _mm_add_ps(_mm_loadu_ps(&pool.y[i]), _mm_mul_ps(velocity_y, dt_4))
+        );
+        const __m128 aged{_mm_mul_ps(_mm_loadu_ps(&pool.age_rate[i]), dt_4)};
+        _mm_storeu_ps(&pool.age[i], _mm_add_ps(_mm_loadu_ps(&pool.age[i]), aged));
+    }
+#endif
+
+    for (; i < last; ++i) {
+        pool.velocity_x[i] *= damping;
+        pool.velocity_y[i] = (pool.velocity_y[i] + fall) * damping;
+        pool.x[i] += pool.velocity_x[i] * dt;
+        pool.y[i] += pool.velocity_y[i] * dt;
+        pool.age[i] += pool.age_rate[i] * dt;
+    }
+}
+
+auto Particle_system::write_chunk(const Pass& pass, const size_t first, const size_t last)
+    -> void {
+    PROFILE_ZONE("Particle_system::write_chunk");
+
+    const Pool& pool{*pass.pool};
+    const defs::particles::Material_desc& desc{*pass.desc};
+    defs::types::shader::Sprite_instance* instances{pass.pool->instances.data()};
+
+    for (size_t i{first}; i < last; ++i) {
+        const float t{std::min(pool.age[i], 1.0F)};
+        const float size{glm::mix(desc.size_start, desc.size_end, t)};
+        const glm::vec4 color{glm::mix(desc.color_start, desc.color_end, t)};
+
+        // premultiplied, glow keeps the color but gives up covering what is behind
+        instances[i] = {
+            .position = {pool.x[i] - (size * 0.5F), pool.y[i] - (size * 0.5F), 0.0F},
+            .rotation = 0.0F,
+            .scale = {size, size},
+            .padding = {0.0F, 0.0F},
+            .uv_rect = {0.0F, 0.0F, 1.0F, 1.0F},
+            .color = {glm::vec3{color} * color.a, color.a * (1.0F - desc.glow)},
+        };
+    }
+}
+
+auto Particle_system::remove_dead(Pool& pool) -> void {
+    // the last live particle fills each gap, draw order does not matter
+    size_t i{0};
+    while (i < pool.count) {
+        if (pool.age[i] < 1.0F) {
+            ++i;
+            continue;
+        }
+
+        const size_t last{--pool.count};
+        pool.x[i] = pool.x[last];
+        pool.y[i] = pool.y[last];
+        pool.velocity_x[i] = pool.velocity_x[last];
+        pool.velocity_y[i] = pool.velocity_y[last];
+        pool.age[i] = pool.age[last];
+        pool.age_rate[i] = pool.age_rate[last];
+    }
+}
@@ -1,9 +1,11 @@
 
 
 #include <physics_system.h>
+#include <profiler.h>
 
 auto Physics_system::iterate(const std::vector<std::unique_ptr<Game_object>>& objects, float dt)
     -> void {
+    PROFILE_ZONE("Physics_system::iterate");
 
     for (const auto& obj : objects) {
         C_physics* physics{obj->get_component<C_physics>()};
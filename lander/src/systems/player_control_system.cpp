@@ -1,14 +1,21 @@
 
 
 #include <player_control_system.h>
+#include <profiler.h>
 
 auto Player_control_system::iterate(const std::vector<std::unique_ptr<Game_object>>& objects)
     -> void {
+    PROFILE_ZONE("Player_control_system::iterate");
 
     for (const auto& obj : objects) {
         const C_player_controller* controller{obj->get_component<C_player_controller>()};
         const C_transform* transform{obj->get_component<C_transform>()};
         C_physics* physics{obj->get_component<C_physics>()};
+        C_emitter* emitter{obj->get_component<C_emitter>()};
+
+        // exhaust follows the throttle
+        if (controller && emitter)
+            emitter->active = controller->thrust_intent;
 
         if (controller && physics && transform) {
 
@@ -1,13 +1,119 @@
 
 
+#include <profiler.h>
 #include <render_system.h>
 
-auto Render_system::collect_renderables(const std::vector<std::unique_ptr<Game_object>>& objects)
-    -> void {
+#include <glm/glm/common.hpp>
+#include <glm/glm/matrix.hpp>
+#include <glm/glm/trigonometric.hpp>
+#include <algorithm>
+#include <cmath>
+
+// x86-64 always has sse2, other targets take the scalar cull path
+#if defined(__SSE2__) || defined(_M_X64)
+#define CULL_SSE2
+#include <xmmintrin.h>
+#endif
+
+auto Render_system::init(const Resource_manager& res_manager, const size_t max_threads) -> void {
+    resource_manager = &res_manager;
+
+    // one core stays with the main thread, which collects a chunk itself
+    const auto spare_cores{static_cast<size_t>(std::max(SDL_GetNumLogicalCPUCores() - 1, 1))};
+    collect_jobs.init(std::min(spare_cores, max_threads), "collect");
+}
+
+auto Render_system::collect_renderables(
+    const std::vector<std::unique_ptr<Game_object>>& objects,
+    const defs::types::camera::Frame_data& frame_data
+) -> void {
+    PROFILE_ZONE("Render_system::collect_renderables");
+
+    culled_count = 0;
+    if (objects.empty())
+        return;
+
+    const View_rect view{get_view_rect(frame_data)};
+    const std::span<const defs::types::vertex::Mesh_bounds> bounds{
+        resource_manager ? resource_manager->get_mesh_bounds()
+                         : std::span<const defs::types::vertex::Mesh_bounds>{}
+    };
+
+    // a chunk per worker once there are enough objects to go around
+    const size_t chunk_count{std::clamp<size_t>(
+        objects.size() / defs::pipelines::collect_chunk_objects, 1, collect_jobs.thread_count() + 1
+    )};
+    const size_t chunk_size{(objects.size() + chunk_count - 1) / chunk_count};
+    if (segments.size() < chunk_count)
+        segments.resize(chunk_count);
+
+    collect_jobs.parallel_for(chunk_count, [&](const size_t index) {
+        const size_t first{std::min(index * chunk_size, objects.size())};
+        collect_chunk(
+            std::span{objects}.subspan(first, std::min(chunk_size, objects.size() - first)),
+            frame_data, view, bounds, segments[index]
+        );
+    });
+
+    for (size_t i{0}; i < chunk_count; ++i)
+        culled_count += segments[i].candidates.size() - segments[i].commands.size();
+
+    merge_segments(chunk_count);
+}
+
+auto Render_system::get_view_rect(const defs::types::camera::Frame_data& frame_data) -> View_rect {
+    // the corners of clip space taken back through projection and view
+    const glm::mat4 clip_to_world{glm::inverse(frame_data.proj_matrix * frame_data.view_matrix)};
+
+    glm::vec2 low{std::numeric_limits<float>::max()};
+    glm::vec2 high{std::numeric_limits<float>::lowest()};
+    for (const float x : {-1.0F, 1.0F}) {
+        for (const float y : {-1.0F, 1.0F}) {
+            const glm::vec4 corner{clip_to_world * glm::vec4{x, y, 0.0F, 1.0F}};
+            const glm::vec2 world{glm::vec2{corner} / corner.w};
+            low = glm::min(low, world);
+            high = glm::max(high, world);
+        }
+    }
+
+    // a degenerate camera culls nothing rather than everything
+    if (not std::isfinite(low.x + low.y + high.x + high.y))
+        return {};
+
+    return {.center = (low + high) * 0.5F, .half_size = (high - low) * 0.5F};
+}
+
+auto Render_system::collect_chunk(
+    const std::span<const std::unique_ptr<Game_object>> objects,
+    const defs::types::camera::Frame_data& frame_data, const View_rect& view,
+    const std::span<const defs::types::vertex::Mesh_bounds> bounds, Segment& segment
+) -> void {
+    PROFILE_ZONE("Render_system::collect_chunk");
+
+    segment.commands.clear();
+    segment.entries.clear();
+    segment.candidates.clear();
+    segment.center_x.clear();
+    segment.center_y.clear();
+    segment.radius.clear();
+
+    // the key is the one the renderer would build, so the merged order can be used as is
+    const auto push{[&segment](const Render_mesh_command& cmd) {
+        segment.entries.push_back({
+            .key = sort_key::encode(
+                sort_key::Pass::Opaque, cmd.pipeline_id, 0, cmd.mesh_id,
+                sort_key::quantize_depth(cmd.depth)
+            ),
+            .index = static_cast<Uint32>(segment.commands.size()),
+        });
+        segment.commands.push_back(cmd);
+    }};
+
     for (const auto& obj : objects) {
 
         const C_transform* transform{obj->get_component<C_transform>()};
         const C_mesh* mesh{obj->get_component<C_mesh>()};
+        const C_mesh_lod* mesh_lod{obj->get_component<C_mesh_lod>()};
         const C_render* render{obj->get_component<C_render>()};
         const C_terrain_points* terrain_points{obj->get_component<C_terrain_points>()};
 
@@ -24,36 +130,143 @@ auto Render_system::collect_renderables(const std::vector<std::unique_ptr<Game_o
         //     render_queue.opaque_commands.push_back(cmd);
         // }
 
-        if (mesh && render && render->visible) {
-
-            if (transform) {
-                const Render_mesh_command cmd{
-                    .pipeline_id = render->pipeline_id,
-                    .mesh_id = mesh->mesh_id,
-                    .model_matrix = transform->get_matrix(),
-                    .depth = render->depth,
-                };
-                render_queue.opaque_commands.push_back(cmd);
-
-            } else if (terrain_points) {
-                const Render_mesh_command cmd{
-                    .pipeline_id = render->pipeline_id,
-                    .mesh_id = mesh->mesh_id,
-                    .model_matrix = {glm::mat4(1.0F)},
-                    .depth = render->depth,
-                };
-                render_queue.opaque_commands.push_back(cmd);
-            }
+        if (not mesh || not render || not render->visible || (not transform && not terrain_points))
+            continue;
+
+        // pick detail level from how large the mesh appears on screen
+        const Uint32 mesh_id{
+            mesh_lod ? mesh_lod->select(frame_data.pixels_per_unit) : mesh->mesh_id
+        };
+
+        // the bounding circle in world space, same scale then rotate order as get_matrix
+        const defs::types::vertex::Mesh_bounds local{
+            mesh_id < bounds.size() ? bounds[mesh_id] : defs::types::vertex::Mesh_bounds{}
+        };
+        glm::vec2 center{local.center()};
+        float radius{local.radius};
+        if (transform) {
+            const glm::vec2 scaled{center * transform->scale};
+            const float angle{glm::radians(transform->rotation)};
+            const float cos_a{std::cos(angle)};
+            const float sin_a{std::sin(angle)};
+            center = transform->position + glm::vec2{
+                (cos_a * scaled.x) - (sin_a * scaled.y), (sin_a * scaled.x) + (cos_a * scaled.y)
+            };
+            radius *= std::max(std::abs(transform->scale.x), std::abs(transform->scale.y));
         }
+
+        segment.candidates.push_back({
+            .transform = transform,
+            .render = render,
+            .mesh_id = mesh_id,
+        });
+        segment.center_x.push_back(center.x);
+        segment.center_y.push_back(center.y);
+        segment.radius.push_back(radius);
+    }
+
+    cull_candidates(view, segment);
+
+    // only what survived pays for its model matrix
+    for (size_t i{0}; i < segment.candidates.size(); ++i) {
+        if (segment.visible[i] == 0)
+            continue;
+
+        const Candidate& candidate{segment.candidates[i]};
+        const Render_mesh_command cmd{
+            .pipeline_id = candidate.render->pipeline_id,
+            .mesh_id = candidate.mesh_id,
+            .model_matrix = candidate.transform ? candidate.transform->get_matrix()
+                                                : glm::mat4(1.0F),
+            .depth = candidate.render->depth,
+        };
+        push(cmd);
+    }
+}
+
+auto Render_system::cull_candidates(const View_rect& view, Segment& segment) -> void {
+    const size_t count{segment.candidates.size()};
+    segment.visible.resize(count);
+
+    // a circle touches the rectangle when its center is inside the rectangle grown by the
+    // radius, conservative near the corners where it may keep a few off screen objects
+    size_t i{0};
+#if defined(CULL_SSE2)
+    // four circles per step, the sign bit cleared for the distances
+    const __m128 view_x{_mm_set1_ps(view.center.x)};
+    const __m128 view_y{_mm_set1_ps(view.center.y)};
+    const __m128 half_x{_mm_set1_ps(view.half_size.x)};
+    const __m128 half_y{_mm_set1_ps(view.half_size.y)};
+    const __m128 sign{_mm_set1_ps(-0.0F)};
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128 radius{_mm_loadu_ps(&segment.radius[i])};
+        const __m128 x{_mm_loadu_ps(&segment.center_x[i])};
+        const __m128 y{_mm_loadu_ps(&segment.center_y[i])};
+        const __m128 dx{_mm_andnot_ps(sign, _mm_sub_ps(x, view_x))};
+        const __m128 dy{_mm_andnot_ps(sign, _mm_sub_ps(y, view_y))};
+        const int inside{_mm_movemask_ps(_mm_and_ps(
+            _mm_cmple_ps(dx, _mm_add_ps(half_x, radius)),
+            _mm_cmple_ps(dy, _mm_add_ps(half_y, radius))
+        ))};
+
+        for (size_t lane{0}; lane < 4; ++lane)
+            segment.visible[i + lane] = static_cast<Uint8>((inside >> lane) & 1);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const float dx{std::abs(segment.center_x[i] - view.center.x)};
+        const float dy{std::abs(segment.center_y[i] - view.center.y)};
+        segment.visible[i] = static_cast<Uint8>(
+            dx <= view.half_size.x + segment.radius[i] && dy <= view.half_size.y + segment.radius[i]
+        );
     }
 }
 
+auto Render_system::merge_segments(const size_t segment_count) -> void {
+    PROFILE_ZONE("Render_system::merge_segments");
+
+    std::vector<Render_mesh_command>& commands{render_queue.opaque_commands};
+    std::vector<sort_key::Entry>& order{render_queue.opaque_order};
+
+    // where each segment lands, after whatever was queued before
+    const size_t command_base{commands.size()};
+    const size_t order_base{order.size()};
+    segment_offsets.resize(segment_count);
+    size_t total{0};
+    for (size_t i{0}; i < segment_count; ++i) {
+        segment_offsets[i] = total;
+        total += segments[i].commands.size();
+    }
+    commands.resize(command_base + total);
+    order.resize(order_base + total);
+
+    collect_jobs.parallel_for(segment_count, [&](const size_t index) {
+        const Segment& segment{segments[index]};
+        const size_t offset{segment_offsets[index]};
+        std::ranges::copy(segment.commands, commands.begin() + command_base + offset);
+        for (size_t i{0}; i < segment.entries.size(); ++i)
+            order[order_base + offset + i] = {
+                .key = segment.entries[i].key,
+                .index = static_cast<Uint32>(command_base + offset + segment.entries[i].index),
+            };
+    });
+
+    sort_scratch.resize(order.size());
+    sort_key::radix_sort(order, sort_scratch, sort_histograms, collect_jobs);
+}
+
 auto Render_system::collect_text(const std::vector<defs::types::text::Text>& objects) -> void {
+    PROFILE_ZONE("Render_system::collect_text");
+
     for (const auto& obj : objects) {
         if (not obj.visible || not obj.draw_data)
             continue;
 
         const Render_text_command cmd{
+            .text_id = obj.id,
+            .revision = obj.revision,
             .draw_data = obj.draw_data,
             .model_matrix = obj.model_matrix,
             .depth = obj.position.y,    // can sort however
@@ -62,3 +275,23 @@ auto Render_system::collect_text(const std::vector<defs::types::text::Text>& obj
         render_queue.text_commands.push_back(cmd);
     }
 }
+
+auto Render_system::collect_sprites(
+    const Uint32 texture_id, const std::span<const defs::types::shader::Sprite_instance> sprites
+) -> void {
+    if (not sprites.empty())
+        render_queue.add_sprites(texture_id, sprites);
+}
+
+auto Render_system::collect_particles(
+    const Uint32 texture_id, const std::span<const defs::types::shader::Sprite_instance> particles
+) -> void {
+    if (not particles.empty())
+        render_queue.particle_batches.push_back({.texture_id = texture_id, .particles = particles});
+}
+
+auto Render_system::collect_debug_lines(
+    const std::span<const defs::types::vertex::Mesh_vertex> vertices
+) -> void {
+    render_queue.debug_lines = vertices;
+}